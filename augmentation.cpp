@@ -0,0 +1,192 @@
+#include "augmentation.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr uint64_t kGoldenGamma = 0x9E3779B97F4A7C15ull;
+
+// SplitMix64的输出混合函数
+uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// 每个样本一个的轻量随机数发生器（SplitMix64），构造没有开销，适合逐样本重新播种
+class SampleRandom {
+private:
+    uint64_t state;
+
+public:
+    explicit SampleRandom(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        state += kGoldenGamma;
+        return mix64(state);
+    }
+
+    // [-1, 1) 上的均匀分布
+    double symmetric() {
+        return static_cast<double>(next() >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+    }
+};
+
+} // namespace
+
+struct Augmenter::Scratch {
+    std::vector<double> padded;    // (rows + 2) x (cols + 2)，带一圈0边框的源图
+    std::vector<double> grid;      // 弹性形变控制点的随机位移，x与y各一份
+    std::vector<double> field_x;   // 每个像素的弹性位移
+    std::vector<double> field_y;
+    std::vector<size_t> cell;      // 每列所在的控制点区间与区间内的插值系数
+    std::vector<double> frac;
+    std::vector<double> column_x;  // 当前行在各控制点列上的位移（先按行插值）
+    std::vector<double> column_y;
+};
+
+Augmenter::Augmenter(const AugmentationConfig& config, size_t rows, size_t cols)
+    : config(config), rows(rows), cols(cols) {
+}
+
+void Augmenter::apply(MatrixView images, const int* sample_ids, size_t count, uint64_t seed) const {
+    applyRows(images, sample_ids, count, seed);
+}
+
+void Augmenter::apply(MatrixViewF images, const int* sample_ids, size_t count, uint64_t seed) const {
+    applyRows(images, sample_ids, count, seed);
+}
+
+template<typename T>
+void Augmenter::applyRows(BasicMatrixView<T> images, const int* sample_ids, size_t count, uint64_t seed) const {
+    // 临时缓冲区按线程复用，稳定后不再分配内存
+    thread_local Scratch scratch;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t sample_seed = mix64(seed ^ mix64(static_cast<uint64_t>(sample_ids[i]) + kGoldenGamma));
+        augmentSample(images.row(i), sample_seed, scratch);
+    }
+}
+
+template<typename T>
+void Augmenter::augmentSample(T* image, uint64_t sample_seed, Scratch& scratch) const {
+    const size_t padded_cols = cols + 2;
+    SampleRandom random(sample_seed);
+
+    // 仿射参数
+    double angle = config.max_rotation * (kPi / 180.0) * random.symmetric();
+    double scale = 1.0 + config.max_scale * random.symmetric();
+    double shift_x = config.max_shift * random.symmetric();
+    double shift_y = config.max_shift * random.symmetric();
+
+    // 源图复制到带0边框的缓冲区，采样坐标限制在边框内，图像外的区域自然取到背景0
+    scratch.padded.assign((rows + 2) * padded_cols, 0.0);
+    for (size_t y = 0; y < rows; ++y) {
+        std::copy(image + y * cols, image + (y + 1) * cols, scratch.padded.data() + (y + 1) * padded_cols + 1);
+    }
+
+    // 弹性形变：在间距为elastic_spacing的控制点上取随机位移，双线性插值得到平滑的位移场
+    // （相当于对逐像素随机场做高斯平滑的低成本近似）
+    bool elastic = config.elastic_alpha > 0;
+    if (elastic) {
+        double spacing = std::max(config.elastic_spacing, 1.0);
+        size_t grid_cols = static_cast<size_t>(std::ceil((cols - 1) / spacing)) + 1;
+        size_t grid_rows = static_cast<size_t>(std::ceil((rows - 1) / spacing)) + 1;
+        grid_cols = std::max<size_t>(grid_cols, 2);
+        grid_rows = std::max<size_t>(grid_rows, 2);
+        size_t grid_size = grid_cols * grid_rows;
+
+        scratch.grid.resize(2 * grid_size);
+        for (double& v : scratch.grid) {
+            v = config.elastic_alpha * random.symmetric();
+        }
+        const double* grid_x = scratch.grid.data();
+        const double* grid_y = scratch.grid.data() + grid_size;
+
+        scratch.cell.resize(cols);
+        scratch.frac.resize(cols);
+        for (size_t x = 0; x < cols; ++x) {
+            double g = x / spacing;
+            size_t i = std::min(static_cast<size_t>(g), grid_cols - 2);
+            scratch.cell[x] = i;
+            scratch.frac[x] = g - i;
+        }
+
+        scratch.field_x.resize(rows * cols);
+        scratch.field_y.resize(rows * cols);
+        scratch.column_x.resize(grid_cols);
+        scratch.column_y.resize(grid_cols);
+        for (size_t y = 0; y < rows; ++y) {
+            double g = y / spacing;
+            size_t j = std::min(static_cast<size_t>(g), grid_rows - 2);
+            double fy = g - j;
+            for (size_t i = 0; i < grid_cols; ++i) {
+                size_t top = j * grid_cols + i;
+                size_t bottom = top + grid_cols;
+                scratch.column_x[i] = grid_x[top] + fy * (grid_x[bottom] - grid_x[top]);
+                scratch.column_y[i] = grid_y[top] + fy * (grid_y[bottom] - grid_y[top]);
+            }
+            double* fx_row = scratch.field_x.data() + y * cols;
+            double* fy_row = scratch.field_y.data() + y * cols;
+            for (size_t x = 0; x < cols; ++x) {
+                size_t i = scratch.cell[x];
+                double t = scratch.frac[x];
+                fx_row[x] = scratch.column_x[i] + t * (scratch.column_x[i + 1] - scratch.column_x[i]);
+                fy_row[x] = scratch.column_y[i] + t * (scratch.column_y[i + 1] - scratch.column_y[i]);
+            }
+        }
+    }
+
+    // 输出像素p'对应的源坐标为逆变换 p = R(-angle)(p' - center - shift) / scale + center，
+    // 沿一行线性变化，逐像素只需加上增量与弹性位移
+    double center_x = (cols - 1) * 0.5;
+    double center_y = (rows - 1) * 0.5;
+    double a = std::cos(angle) / scale;
+    double b = std::sin(angle) / scale;
+    const double max_x = static_cast<double>(cols + 1) - 1e-6;
+    const double max_y = static_cast<double>(rows + 1) - 1e-6;
+    const double* src = scratch.padded.data();
+
+    for (size_t y = 0; y < rows; ++y) {
+        double dx0 = -center_x - shift_x;
+        double dy0 = static_cast<double>(y) - center_y - shift_y;
+        // 加1转换为带边框缓冲区中的坐标
+        double row_x = a * dx0 + b * dy0 + center_x + 1.0;
+        double row_y = -b * dx0 + a * dy0 + center_y + 1.0;
+        const double* field_x = elastic ? scratch.field_x.data() + y * cols : nullptr;
+        const double* field_y = elastic ? scratch.field_y.data() + y * cols : nullptr;
+        T* out = image + y * cols;
+
+        for (size_t x = 0; x < cols; ++x) {
+            double sx = row_x + a * x;
+            double sy = row_y - b * x;
+            if (elastic) {
+                sx += field_x[x];
+                sy += field_y[x];
+            }
+            sx = std::min(std::max(sx, 0.0), max_x);
+            sy = std::min(std::max(sy, 0.0), max_y);
+
+            // 坐标非负，截断即向下取整；转换为int比转换为size_t快
+            int x0 = static_cast<int>(sx);
+            int y0 = static_cast<int>(sy);
+            double fx = sx - x0;
+            double fy = sy - y0;
+            const double* p = src + static_cast<ptrdiff_t>(y0) * padded_cols + x0;
+            double top = p[0] + fx * (p[1] - p[0]);
+            double bottom = p[padded_cols] + fx * (p[padded_cols + 1] - p[padded_cols]);
+            out[x] = static_cast<T>(top + fy * (bottom - top));
+        }
+    }
+
+    // 均匀分布噪声，方差与标准差为noise_stddev的高斯噪声相同（生成代价远低于高斯分布）
+    if (config.noise_stddev > 0) {
+        double half_width = std::sqrt(3.0) * config.noise_stddev;
+        size_t n = rows * cols;
+        for (size_t j = 0; j < n; ++j) {
+            image[j] = static_cast<T>(image[j] + half_width * random.symmetric());
+        }
+    }
+}
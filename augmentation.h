@@ -0,0 +1,50 @@
+#ifndef AUGMENTATION_H
+#define AUGMENTATION_H
+
+#include "matrix.h"
+#include <cstddef>
+#include <cstdint>
+
+// 数据增强参数，各项为0时关闭对应的变换
+struct AugmentationConfig {
+    double max_shift = 3.0;        // 随机平移，像素，[-max_shift, max_shift]
+    double max_rotation = 12.0;    // 随机旋转，角度，[-max_rotation, max_rotation]
+    double max_scale = 0.1;        // 随机缩放，比例在[1 - max_scale, 1 + max_scale]
+    double elastic_alpha = 0.0;    // 弹性形变的最大位移，像素
+    double elastic_spacing = 4.0;  // 弹性形变随机控制点的间距，像素，越大形变越平滑
+    double noise_stddev = 0.0;     // 加性噪声的标准差（按归一化后的像素值）
+
+    bool enabled() const {
+        return max_shift > 0 || max_rotation > 0 || max_scale > 0 || elastic_alpha > 0 || noise_stddev > 0;
+    }
+};
+
+// ========== 在线数据增强 ==========
+// 对rows x cols的灰度图像做随机仿射变换（平移、旋转、缩放）与弹性形变，合并为一次双线性重采样，
+// 再叠加噪声。每个样本的随机数只由(seed, 样本编号)决定，与批划分和线程无关，
+// 同一seed下结果完全可复现。apply为const且不共享可写状态，可在多个线程上并发调用
+class Augmenter {
+private:
+    AugmentationConfig config;
+    size_t rows;
+    size_t cols;
+
+    // 每个线程一份的临时缓冲区
+    struct Scratch;
+    // 图像元素为double或float，重采样在double中计算
+    template<typename T>
+    void augmentSample(T* image, uint64_t sample_seed, Scratch& scratch) const;
+    template<typename T>
+    void applyRows(BasicMatrixView<T> images, const int* sample_ids, size_t count, uint64_t seed) const;
+
+public:
+    Augmenter(const AugmentationConfig& config, size_t rows, size_t cols);
+
+    const AugmentationConfig& getConfig() const { return config; }
+
+    // 原地增强images的前count行；第i行使用由seed与sample_ids[i]派生的随机数
+    void apply(MatrixView images, const int* sample_ids, size_t count, uint64_t seed) const;
+    void apply(MatrixViewF images, const int* sample_ids, size_t count, uint64_t seed) const;
+};
+
+#endif // AUGMENTATION_H
@@ -0,0 +1,172 @@
+#include "batch_pipeline.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+BatchPipeline::BatchPipeline(size_t queue_depth, size_t num_workers)
+    : slots(queue_depth + 1) {
+    workers.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers.emplace_back(&BatchPipeline::workerLoop, this);
+    }
+}
+
+BatchPipeline::~BatchPipeline() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    consumed_cv.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void BatchPipeline::fill(PreparedBatch& batch, size_t index) const {
+    size_t begin = index * batch_size;
+    size_t count = std::min(batch_size, order->size() - begin);
+    size_t sample_size = data->imageSize();
+
+    // 缓冲区只在批大小或样本形状变化时重新分配
+    if (batch.inputs.rows() < count || batch.inputs.cols() != sample_size) {
+        batch.inputs.resize(batch_size, sample_size);
+    }
+    if (batch.labels.size() < count) {
+        batch.labels.resize(batch_size);
+    }
+
+    batch.indices = order->data() + begin;
+    batch.count = count;
+    batch.batch_index = index;
+
+    data->gatherImages(batch.indices, count, batch.inputs);
+    for (size_t i = 0; i < count; ++i) {
+        batch.labels[i] = data->labels[batch.indices[i]];
+    }
+
+    if (transform) {
+        transform(batch);
+    }
+}
+
+void BatchPipeline::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        // 训练线程持有一个槽位，其余queue_depth个槽位用于提前准备
+        consumed_cv.wait(lock, [this] {
+            return stopping || (next_batch < num_batches && next_batch < consumed + slots.size());
+        });
+        if (stopping) {
+            return;
+        }
+
+        size_t index = next_batch++;
+        size_t current_generation = generation;
+        Slot& slot = slots[index % slots.size()];
+        ++active_fills;
+        lock.unlock();
+
+        auto start_time = std::chrono::steady_clock::now();
+        std::exception_ptr fill_error;
+        try {
+            fill(slot.batch, index);
+        } catch (...) {
+            fill_error = std::current_exception();
+        }
+        double elapsed = secondsSince(start_time);
+
+        lock.lock();
+        --active_fills;
+        statistics.prepare_seconds += elapsed;
+        if (current_generation == generation) {
+            if (fill_error && !error) {
+                error = fill_error;
+            }
+            slot.ready = true;
+        }
+        produced_cv.notify_all();
+    }
+}
+
+void BatchPipeline::start(const MNISTData& new_data, const std::vector<int>& new_order,
+                          size_t new_batch_size, size_t first_batch) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // 停止上一轮：不再领取新批，并等待正在填充的批结束，之后才能复用槽位
+    ++generation;
+    num_batches = 0;
+    produced_cv.wait(lock, [this] { return active_fills == 0; });
+
+    data = &new_data;
+    order = &new_order;
+    batch_size = std::max<size_t>(new_batch_size, 1);
+    holding = false;
+    error = nullptr;
+    for (Slot& slot : slots) {
+        slot.ready = false;
+    }
+    num_batches = (order->size() + batch_size - 1) / batch_size;
+    next_batch = std::min(first_batch, num_batches);
+    consumed = next_batch;
+    consumed_cv.notify_all();
+}
+
+const PreparedBatch* BatchPipeline::next() {
+    if (workers.empty()) {
+        // 同步模式：在调用线程上准备，准备时间全部计为等待
+        if (holding) {
+            ++consumed;
+            holding = false;
+        }
+        if (consumed >= num_batches) {
+            return nullptr;
+        }
+        auto start_time = std::chrono::steady_clock::now();
+        fill(slots[0].batch, consumed);
+        double elapsed = secondsSince(start_time);
+        statistics.prepare_seconds += elapsed;
+        statistics.stall_seconds += elapsed;
+        statistics.stalls++;
+        statistics.batches++;
+        holding = true;
+        return &slots[0].batch;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (holding) {
+        // 释放上一批的槽位，生产者可以继续向前准备
+        ++consumed;
+        holding = false;
+        consumed_cv.notify_all();
+    }
+    if (consumed >= num_batches) {
+        return nullptr;
+    }
+
+    Slot& slot = slots[consumed % slots.size()];
+    auto ready = [&] { return error || slot.ready; };
+    if (!ready()) {
+        auto start_time = std::chrono::steady_clock::now();
+        produced_cv.wait(lock, ready);
+        statistics.stalls++;
+        statistics.stall_seconds += secondsSince(start_time);
+    }
+    if (error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        num_batches = 0;
+        std::rethrow_exception(e);
+    }
+
+    slot.ready = false;
+    holding = true;
+    statistics.batches++;
+    return &slot.batch;
+}
@@ -0,0 +1,102 @@
+#ifndef BATCH_PIPELINE_H
+#define BATCH_PIPELINE_H
+
+#include "matrix.h"
+#include "mnist_reader.h"
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 准备好的一批训练数据
+struct PreparedBatch {
+    MatrixF inputs;                 // count x 样本大小，已转换为float
+    std::vector<int> labels;        // 各样本的类别下标
+    const int* indices = nullptr;   // 本批各样本在数据集中的下标
+    size_t count = 0;
+    size_t batch_index = 0;         // 本轮中的批序号
+};
+
+// 流水线统计：训练线程取批时数据尚未准备好即记为一次停顿
+struct PipelineStats {
+    size_t batches = 0;            // 已取出的批数
+    size_t stalls = 0;             // 需要等待的次数
+    double stall_seconds = 0.0;    // 训练线程等待的总时间
+    double prepare_seconds = 0.0;  // 准备数据的总时间（各生产者线程累加）
+};
+
+// ========== 异步批数据流水线 ==========
+// 生产者线程按给定的样本顺序提前准备之后queue_depth个批次：gather样本并转换为float、
+// 收集标签、执行可选的变换（如数据增强），写入各自的连续缓冲区；
+// 训练线程处理当前批的同时下一批已在准备。批严格按顺序交付，与同步准备的结果完全一致
+class BatchPipeline {
+public:
+    // 对准备好的批做原地变换，在生产者线程上调用，多个生产者时可能并发调用
+    using Transform = std::function<void(PreparedBatch& batch)>;
+
+private:
+    struct Slot {
+        PreparedBatch batch;
+        bool ready = false;
+    };
+
+    std::vector<Slot> slots;          // queue_depth + 1个槽位的环形队列，批b放在slots[b % slots.size()]
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable produced_cv;  // 有批准备好，或填充结束
+    std::condition_variable consumed_cv;  // 新一轮开始、槽位释放或停止
+
+    // 当前一轮
+    const MNISTData* data = nullptr;
+    const std::vector<int>* order = nullptr;
+    size_t batch_size = 0;
+    size_t num_batches = 0;
+    size_t next_batch = 0;   // 下一个待准备的批
+    size_t consumed = 0;     // 训练线程已用完的批数
+    bool holding = false;    // 训练线程是否持有批consumed
+    size_t generation = 0;   // 每轮递增，丢弃上一轮未完成的批
+    size_t active_fills = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+
+    Transform transform;
+    PipelineStats statistics;
+
+    void workerLoop();
+    void fill(PreparedBatch& batch, size_t index) const;
+
+public:
+    // queue_depth为训练当前批时最多提前准备好的批数（1即双缓冲），num_workers为生产者线程数，
+    // 0表示不使用后台线程，在next()中同步准备
+    explicit BatchPipeline(size_t queue_depth = 2, size_t num_workers = 1);
+    ~BatchPipeline();
+
+    BatchPipeline(const BatchPipeline&) = delete;
+    BatchPipeline& operator=(const BatchPipeline&) = delete;
+
+    size_t queueDepth() const { return slots.size() - 1; }
+    size_t numWorkers() const { return workers.size(); }
+
+    // 应在两轮之间设置
+    void setTransform(Transform fn) { transform = std::move(fn); }
+
+    // 开始新的一轮：按order的顺序每batch_size个样本一批，从第first_batch批开始（用于从检查点恢复）。
+    // data与order在本轮结束（或下一次start）前须保持有效且不被修改
+    void start(const MNISTData& data, const std::vector<int>& order, size_t batch_size,
+               size_t first_batch = 0);
+
+    // 取下一批，本轮结束时返回nullptr；返回的批在下次调用next()或start()前有效。
+    // 生产者抛出的异常在此重新抛出
+    const PreparedBatch* next();
+
+    const PipelineStats& stats() const { return statistics; }
+    void resetStats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        statistics = PipelineStats();
+    }
+};
+
+#endif // BATCH_PIPELINE_H
@@ -1,649 +1,2115 @@
-#include "bpnn.h"
-#include <iostream>
-#include <fstream>
-#include <random>
-#include <cmath>
-#include <algorithm>
-#include <cassert>
-
-// C++11兼容的make_unique实现
-template<typename T, typename... Args>
-std::unique_ptr<T> make_unique(Args&&... args) {
-    return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
-}
-
-// ========== 激活函数实现 ==========
-
-double ActivationFunction::sigmoid(double x) {
-    // 添加数值稳定性检查
-    if (x > 500) return 1.0;
-    if (x < -500) return 0.0;
-    return 1.0 / (1.0 + std::exp(-x));
-}
-
-double ActivationFunction::sigmoidDerivative(double x) {
-    double s = sigmoid(x);
-    return s * (1.0 - s);
-}
-
-double ActivationFunction::relu(double x) {
-    return std::max(0.0, x);
-}
-
-double ActivationFunction::reluDerivative(double x) {
-    return x > 0 ? 1.0 : 0.0;
-}
-
-std::vector<double> ActivationFunction::softmax(const std::vector<double>& x) {
-    if (x.empty()) return {};
-    
-    std::vector<double> result(x.size());
-    double max_val = *std::max_element(x.begin(), x.end());
-    double sum = 0.0;
-    
-    // 防止数值溢出
-    for (size_t i = 0; i < x.size(); ++i) {
-        result[i] = std::exp(std::min(x[i] - max_val, 500.0));
-        sum += result[i];
-    }
-    
-    // 防止除零和非有限数
-    if (sum <= 0.0 || !std::isfinite(sum)) {
-        std::fill(result.begin(), result.end(), 1.0 / x.size());
-        return result;
-    }
-    
-    for (size_t i = 0; i < x.size(); ++i) {
-        result[i] /= sum;
-    }
-    
-    return result;
-}
-
-std::vector<double> ActivationFunction::softmaxDerivative(const std::vector<double>& x, size_t index) {
-    std::vector<double> softmax_output = softmax(x);
-    std::vector<double> derivative(x.size());
-    
-    for (size_t i = 0; i < x.size(); ++i) {
-        if (i == index) {
-            derivative[i] = softmax_output[i] * (1.0 - softmax_output[i]);
-        } else {
-            derivative[i] = -softmax_output[i] * softmax_output[index];
-        }
-    }
-    
-    return derivative;
-}
-
-std::function<double(double)> ActivationFunction::getActivation(ActivationType type) {
-    switch (type) {
-        case ActivationType::SIGMOID:
-            return sigmoid;
-        case ActivationType::RELU:
-            return relu;
-        default:
-            return sigmoid;
-    }
-}
-
-std::function<double(double)> ActivationFunction::getDerivative(ActivationType type) {
-    switch (type) {
-        case ActivationType::SIGMOID:
-            return sigmoidDerivative;
-        case ActivationType::RELU:
-            return reluDerivative;
-        default:
-            return sigmoidDerivative;
-    }
-}
-
-std::function<std::vector<double>(const std::vector<double>&)> 
-ActivationFunction::getVectorActivation(ActivationType type) {
-    switch (type) {
-        case ActivationType::SOFTMAX:
-            return softmax;
-        default:
-            return [type](const std::vector<double>& x) {
-                auto func = getActivation(type);
-                std::vector<double> result(x.size());
-                for (size_t i = 0; i < x.size(); ++i) {
-                    result[i] = func(x[i]);
-                }
-                return result;
-            };
-    }
-}
-
-// ========== 层实现 ==========
-
-Layer::Layer(size_t input_size, size_t output_size, ActivationType activation)
-    : activation_type(activation), timestep(0) {
-    
-    weights.resize(output_size, std::vector<double>(input_size));
-    biases.resize(output_size);
-    neurons.resize(output_size);
-    weighted_sums.resize(output_size);
-    errors.resize(output_size);
-    
-    // 初始化Adam优化器参数
-    m_weights.resize(output_size, std::vector<double>(input_size, 0.0));
-    v_weights.resize(output_size, std::vector<double>(input_size, 0.0));
-    m_biases.resize(output_size, 0.0);
-    v_biases.resize(output_size, 0.0);
-    
-    initializeWeights();
-}
-
-void Layer::initializeWeights() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    
-    // 改进的权重初始化
-    double limit;
-    if (activation_type == ActivationType::RELU) {
-        // He初始化，适用于ReLU
-        limit = std::sqrt(2.0 / getInputSize());
-        std::normal_distribution<> dis(0.0, limit);
-        for (auto& weight_row : weights) {
-            for (auto& weight : weight_row) {
-                weight = dis(gen);
-            }
-        }
-    } else {
-        // Xavier初始化，适用于sigmoid和tanh
-        limit = std::sqrt(6.0 / (getInputSize() + getOutputSize()));
-        std::uniform_real_distribution<> dis(-limit, limit);
-        for (auto& weight_row : weights) {
-            for (auto& weight : weight_row) {
-                weight = dis(gen);
-            }
-        }
-    }
-    
-    // 偏置初始化为0
-    std::fill(biases.begin(), biases.end(), 0.0);
-}
-
-std::vector<double> Layer::forward(const std::vector<double>& input) {
-    if (input.size() != getInputSize()) {
-        throw std::invalid_argument("Input size mismatch. Expected: " + 
-                                  std::to_string(getInputSize()) + 
-                                  ", Got: " + std::to_string(input.size()));
-    }
-    
-    // 计算加权和
-    for (size_t i = 0; i < weights.size(); ++i) {
-        weighted_sums[i] = biases[i];
-        for (size_t j = 0; j < input.size(); ++j) {
-            weighted_sums[i] += weights[i][j] * input[j];
-        }
-    }
-    
-    // 应用激活函数
-    if (activation_type == ActivationType::SOFTMAX) {
-        neurons = ActivationFunction::softmax(weighted_sums);
-    } else {
-        auto activation_func = ActivationFunction::getActivation(activation_type);
-        for (size_t i = 0; i < weighted_sums.size(); ++i) {
-            neurons[i] = activation_func(weighted_sums[i]);
-        }
-    }
-    
-    return neurons;
-}
-
-std::vector<double> Layer::backward(const std::vector<double>& gradient) {
-    if (gradient.size() != getOutputSize()) {
-        throw std::invalid_argument("Gradient size mismatch");
-    }
-    
-    std::vector<double> input_gradient(getInputSize(), 0.0);
-    
-    // 计算误差项
-    if (activation_type == ActivationType::SOFTMAX) {
-        // 对于softmax+交叉熵，梯度直接是 predicted - target
-        errors = gradient;
-    } else {
-        auto derivative_func = ActivationFunction::getDerivative(activation_type);
-        for (size_t i = 0; i < errors.size(); ++i) {
-            errors[i] = gradient[i] * derivative_func(weighted_sums[i]);
-        }
-    }
-    
-    // 计算输入梯度（传递给前一层）
-    for (size_t i = 0; i < getInputSize(); ++i) {
-        for (size_t j = 0; j < getOutputSize(); ++j) {
-            input_gradient[i] += errors[j] * weights[j][i];
-        }
-    }
-    
-    return input_gradient;
-}
-
-void Layer::updateWeightsSGD(const std::vector<double>& input, double learning_rate) {
-    if (input.size() != getInputSize()) {
-        throw std::invalid_argument("Input size mismatch for weight update");
-    }
-    
-    // 更新权重和偏置
-    for (size_t i = 0; i < weights.size(); ++i) {
-        for (size_t j = 0; j < weights[i].size(); ++j) {
-            weights[i][j] -= learning_rate * errors[i] * input[j];
-        }
-        biases[i] -= learning_rate * errors[i];
-    }
-}
-
-void Layer::updateWeightsAdam(const std::vector<double>& input, double learning_rate,
-                             double beta1, double beta2, double epsilon) {
-    if (input.size() != getInputSize()) {
-        throw std::invalid_argument("Input size mismatch for weight update");
-    }
-    
-    timestep++;
-    
-    // 更新权重
-    for (size_t i = 0; i < weights.size(); ++i) {
-        for (size_t j = 0; j < weights[i].size(); ++j) {
-            double gradient = errors[i] * input[j];
-            
-            // 更新一阶和二阶动量估计
-            m_weights[i][j] = beta1 * m_weights[i][j] + (1 - beta1) * gradient;
-            v_weights[i][j] = beta2 * v_weights[i][j] + (1 - beta2) * gradient * gradient;
-            
-            // 偏差修正
-            double m_corrected = m_weights[i][j] / (1 - std::pow(beta1, timestep));
-            double v_corrected = v_weights[i][j] / (1 - std::pow(beta2, timestep));
-            
-            // 更新权重
-            weights[i][j] -= learning_rate * m_corrected / (std::sqrt(v_corrected) + epsilon);
-        }
-        
-        // 更新偏置
-        double bias_gradient = errors[i];
-        m_biases[i] = beta1 * m_biases[i] + (1 - beta1) * bias_gradient;
-        v_biases[i] = beta2 * v_biases[i] + (1 - beta2) * bias_gradient * bias_gradient;
-        
-        double m_bias_corrected = m_biases[i] / (1 - std::pow(beta1, timestep));
-        double v_bias_corrected = v_biases[i] / (1 - std::pow(beta2, timestep));
-        
-        biases[i] -= learning_rate * m_bias_corrected / (std::sqrt(v_bias_corrected) + epsilon);
-    }
-}
-
-// ========== 优化器实现 ==========
-
-void SGDOptimizer::updateLayer(Layer* layer, const std::vector<double>& input, 
-                              double learning_rate) {
-    layer->updateWeightsSGD(input, learning_rate);
-}
-
-void AdamOptimizer::updateLayer(Layer* layer, const std::vector<double>& input, 
-                               double learning_rate) {
-    layer->updateWeightsAdam(input, learning_rate, beta1, beta2, epsilon);
-}
-
-// ========== 神经网络实现 ==========
-
-NeuralNetwork::NeuralNetwork(double lr, LossType loss) 
-    : learning_rate(lr), loss_type(loss) {
-    optimizer = make_unique<SGDOptimizer>();
-}
-
-NeuralNetwork::~NeuralNetwork() = default;
-
-void NeuralNetwork::addLayer(int neurons, ActivationType activation) {
-    if (neurons <= 0) {
-        throw std::invalid_argument("Number of neurons must be positive");
-    }
-    
-    size_t input_size = layers.empty() ? 0 : layers.back()->getOutputSize();
-    
-    if (layers.empty()) {
-        // 第一层，输入大小将在第一次前向传播时确定
-        // 使用占位符大小1，稍后会重新创建
-        layers.push_back(make_unique<Layer>(1, neurons, activation));
-    } else {
-        layers.push_back(make_unique<Layer>(input_size, neurons, activation));
-    }
-}
-
-void NeuralNetwork::setOptimizer(OptimizerType type, double lr) {
-    learning_rate = lr;
-    
-    switch (type) {
-        case OptimizerType::SGD:
-            optimizer = make_unique<SGDOptimizer>();
-            break;
-        case OptimizerType::ADAM:
-            optimizer = make_unique<AdamOptimizer>();
-            break;
-        default:
-            optimizer = make_unique<SGDOptimizer>();
-            break;
-    }
-}
-
-std::vector<double> NeuralNetwork::forward(const std::vector<double>& input) {
-    if (layers.empty()) {
-        return input;
-    }
-    
-    // 检查第一层是否需要重新初始化（仅在输入大小为1时，说明是占位符）
-    if (layers[0]->getInputSize() == 1 && input.size() != 1) {
-        size_t output_size = layers[0]->getOutputSize();
-        ActivationType activation = ActivationType::RELU; // 默认使用ReLU作为隐藏层激活函数
-        layers[0] = make_unique<Layer>(input.size(), output_size, activation);
-    }
-    
-    std::vector<double> current_input = input;
-    
-    // 逐层前向传播
-    for (auto& layer : layers) {
-        current_input = layer->forward(current_input);
-    }
-    
-    return current_input;
-}
-
-void NeuralNetwork::backward(const std::vector<double>& target) {
-    if (layers.empty()) return;
-    
-    // 计算输出层梯度（均方误差）
-    const auto& output = layers.back()->getNeurons();
-    if (output.size() != target.size()) {
-        throw std::invalid_argument("Target size mismatch");
-    }
-    
-    std::vector<double> gradient(output.size());
-    for (size_t i = 0; i < output.size(); ++i) {
-        gradient[i] = output[i] - target[i];
-    }
-    
-    // 反向传播
-    performBackwardPass(gradient);
-}
-
-void NeuralNetwork::backwardCrossEntropy(const std::vector<double>& target) {
-    if (layers.empty()) return;
-    
-    // 对于softmax + 交叉熵，梯度简化为 (predicted - target)
-    const auto& output = layers.back()->getNeurons();
-    if (output.size() != target.size()) {
-        throw std::invalid_argument("Target size mismatch");
-    }
-    
-    std::vector<double> gradient(output.size());
-    for (size_t i = 0; i < output.size(); ++i) {
-        gradient[i] = output[i] - target[i];
-    }
-    
-    // 反向传播
-    performBackwardPass(gradient);
-}
-
-void NeuralNetwork::performBackwardPass(std::vector<double> gradient) {
-    // 存储每层的输入用于权重更新
-    std::vector<std::vector<double>> layer_inputs(layers.size());
-    
-    // 第一层的输入需要在train方法中提供
-    // 其他层的输入是前一层的输出
-    for (size_t i = 1; i < layers.size(); ++i) {
-        layer_inputs[i] = layers[i-1]->getNeurons();
-    }
-    
-    // 从输出层开始反向传播
-    for (int i = static_cast<int>(layers.size()) - 1; i >= 0; --i) {
-        gradient = layers[i]->backward(gradient);
-        
-        // 权重更新（除了第一层，第一层在train方法中更新）
-        if (i > 0) {
-            optimizer->updateLayer(layers[i].get(), layer_inputs[i], learning_rate);
-        }
-    }
-}
-
-double NeuralNetwork::train(const std::vector<double>& input, const std::vector<double>& target) {
-    // 前向传播
-    auto output = forward(input);
-    
-    // 根据损失函数类型进行反向传播
-    if (loss_type == LossType::CROSS_ENTROPY) {
-        backwardCrossEntropy(target);
-    } else {
-        backward(target);
-    }
-    
-    // 更新第一层权重（使用原始输入）
-    if (!layers.empty()) {
-        optimizer->updateLayer(layers[0].get(), input, learning_rate);
-    }
-    
-    // 计算并返回损失
-    return calculateLoss(output, target);
-}
-
-double NeuralNetwork::trainBatch(const std::vector<std::vector<double>>& inputs,
-                                const std::vector<std::vector<double>>& targets) {
-    if (inputs.size() != targets.size()) {
-        throw std::invalid_argument("Input and target batch sizes don't match");
-    }
-    
-    double total_loss = 0.0;
-    
-    for (size_t i = 0; i < inputs.size(); ++i) {
-        total_loss += train(inputs[i], targets[i]);
-    }
-    
-    return total_loss / inputs.size();
-}
-
-std::vector<double> NeuralNetwork::predict(const std::vector<double>& input) {
-    return forward(input);
-}
-
-std::vector<double> NeuralNetwork::getHiddenLayerOutput(const std::vector<double>& input) {
-    if (layers.empty()) return {};
-    
-    // 确保第一层已正确初始化
-    if (layers[0]->getInputSize() == 1 && input.size() != 1) {
-        size_t output_size = layers[0]->getOutputSize();
-        ActivationType activation = ActivationType::RELU;
-        layers[0] = make_unique<Layer>(input.size(), output_size, activation);
-    }
-    
-    // 只通过第一层
-    return layers[0]->forward(input);
-}
-
-double NeuralNetwork::calculateLoss(const std::vector<double>& predicted,
-                                   const std::vector<double>& target) {
-    if (loss_type == LossType::CROSS_ENTROPY) {
-        return calculateCrossEntropyLoss(predicted, target);
-    } else {
-        // 均方误差
-        double loss = 0.0;
-        for (size_t i = 0; i < predicted.size(); ++i) {
-            double diff = predicted[i] - target[i];
-            loss += diff * diff;
-        }
-        return loss / (2.0 * predicted.size()); // 除以样本数量
-    }
-}
-
-double NeuralNetwork::calculateCrossEntropyLoss(const std::vector<double>& predicted,
-                                               const std::vector<double>& target) {
-    double loss = 0.0;
-    const double epsilon = 1e-15; // 防止log(0)
-    
-    for (size_t i = 0; i < predicted.size(); ++i) {
-        // 限制预测值在[epsilon, 1-epsilon]范围内
-        double p = std::max(epsilon, std::min(1.0 - epsilon, predicted[i]));
-        loss -= target[i] * std::log(p);
-    }
-    
-    return loss;
-}
-
-// 在Layer类实现中添加：
-ActivationType Layer::getActivationType() const {
-    return activation_type;
-}
-
-// 完整的saveModel实现
-bool NeuralNetwork::saveModel(const std::string& filename) const {
-    std::ofstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Error: Cannot open file for saving: " << filename << std::endl;
-        return false;
-    }
-    
-    try {
-        std::cout << "Saving model to: " << filename << std::endl;
-        
-        // 保存网络配置
-        file.write(reinterpret_cast<const char*>(&learning_rate), sizeof(learning_rate));
-        file.write(reinterpret_cast<const char*>(&loss_type), sizeof(loss_type));
-        
-        // 保存优化器类型
-        OptimizerType opt_type = optimizer->getType();
-        file.write(reinterpret_cast<const char*>(&opt_type), sizeof(opt_type));
-        
-        // 保存层数
-        size_t num_layers = layers.size();
-        file.write(reinterpret_cast<const char*>(&num_layers), sizeof(num_layers));
-        std::cout << "Saving " << num_layers << " layers..." << std::endl;
-        
-        // 保存每层的详细信息
-        for (size_t layer_idx = 0; layer_idx < layers.size(); ++layer_idx) {
-            const auto& layer = layers[layer_idx];
-            const auto& weights = layer->getWeights();
-            const auto& biases = layer->getBiases();
-            
-            // 保存激活函数类型
-            ActivationType activation = layer->getActivationType();
-            file.write(reinterpret_cast<const char*>(&activation), sizeof(activation));
-            
-            // 保存维度
-            size_t rows = weights.size();
-            size_t cols = weights.empty() ? 0 : weights[0].size();
-            file.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
-            file.write(reinterpret_cast<const char*>(&cols), sizeof(cols));
-            
-            std::cout << "Layer " << layer_idx << ": " << cols << "->" << rows 
-                      << " (activation: " << static_cast<int>(activation) << ")" << std::endl;
-            
-            // 保存权重
-            for (const auto& row : weights) {
-                file.write(reinterpret_cast<const char*>(row.data()), 
-                          row.size() * sizeof(double));
-            }
-            
-            // 保存偏置
-            file.write(reinterpret_cast<const char*>(biases.data()), 
-                      biases.size() * sizeof(double));
-        }
-        
-        file.close();
-        std::cout << "Model saved successfully!" << std::endl;
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Error saving model: " << e.what() << std::endl;
-        file.close();
-        return false;
-    }
-}
-
-// 完整的loadModel实现
-bool NeuralNetwork::loadModel(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Error: Cannot open file for loading: " << filename << std::endl;
-        return false;
-    }
-    
-    try {
-        std::cout << "Loading model from: " << filename << std::endl;
-        
-        // 读取网络配置
-        file.read(reinterpret_cast<char*>(&learning_rate), sizeof(learning_rate));
-        file.read(reinterpret_cast<char*>(&loss_type), sizeof(loss_type));
-        
-        // 读取优化器类型并设置
-        OptimizerType opt_type;
-        file.read(reinterpret_cast<char*>(&opt_type), sizeof(opt_type));
-        
-        // 读取层数
-        size_t num_layers;
-        file.read(reinterpret_cast<char*>(&num_layers), sizeof(num_layers));
-        std::cout << "Loading " << num_layers << " layers..." << std::endl;
-        
-        layers.clear();
-        
-        for (size_t layer_idx = 0; layer_idx < num_layers; ++layer_idx) {
-            // 读取激活函数类型
-            ActivationType activation;
-            file.read(reinterpret_cast<char*>(&activation), sizeof(activation));
-            
-            // 读取维度
-            size_t rows, cols;
-            file.read(reinterpret_cast<char*>(&rows), sizeof(rows));
-            file.read(reinterpret_cast<char*>(&cols), sizeof(cols));
-            
-            std::cout << "Layer " << layer_idx << ": " << cols << "->" << rows 
-                      << " (activation: " << static_cast<int>(activation) << ")" << std::endl;
-            
-            // 创建层时使用正确的激活函数类型
-            auto layer = make_unique<Layer>(cols, rows, activation);
-            
-            // 读取权重
-            std::vector<std::vector<double>> weights(rows, std::vector<double>(cols));
-            for (auto& row : weights) {
-                file.read(reinterpret_cast<char*>(row.data()), 
-                         row.size() * sizeof(double));
-            }
-            
-            // 读取偏置
-            std::vector<double> biases(rows);
-            file.read(reinterpret_cast<char*>(biases.data()), 
-                     biases.size() * sizeof(double));
-            
-            layer->setWeights(weights);
-            layer->setBiases(biases);
-            
-            layers.push_back(std::move(layer));
-        }
-        
-        // 恢复优化器设置
-        setOptimizer(opt_type, learning_rate);
-        
-        file.close();
-        std::cout << "Model loaded successfully!" << std::endl;
-        std::cout << "Learning rate: " << learning_rate << std::endl;
-        std::cout << "Loss type: " << (loss_type == LossType::CROSS_ENTROPY ? "Cross-Entropy" : "MSE") << std::endl;
-        std::cout << "Optimizer: " << (opt_type == OptimizerType::ADAM ? "Adam" : "SGD") << std::endl;
-        
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Error loading model: " << e.what() << std::endl;
-        file.close();
-        return false;
-    }
-}
-
-void NeuralNetwork::printNetworkInfo() const {
-    std::cout << "Neural Network Information:" << std::endl;
-    std::cout << "Number of layers: " << layers.size() << std::endl;
-    std::cout << "Learning rate: " << learning_rate << std::endl;
-    std::cout << "Loss function: " << (loss_type == LossType::CROSS_ENTROPY ? "Cross-Entropy" : "Mean Squared Error") << std::endl;
-    
-    if (optimizer) {
-        std::cout << "Optimizer: " << (optimizer->getType() == OptimizerType::SGD ? "SGD" : "Adam") << std::endl;
-    }
-    
-    for (size_t i = 0; i < layers.size(); ++i) {
-        std::cout << "Layer " << i << ": " 
-                  << layers[i]->getInputSize() << " -> " 
-                  << layers[i]->getOutputSize() << " neurons" << std::endl;
-    }
-}
\ No newline at end of file
+#include "bpnn.h"
+#include "linalg.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include "mapped_file.h"
+#include "model_format.h"
+#include "gzip_stream.h"
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <type_traits>
+
+// C++11兼容的make_unique实现
+template<typename T, typename... Args>
+std::unique_ptr<T> make_unique(Args&&... args) {
+    return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
+}
+
+namespace {
+
+// 未指定随机数发生器时使用的线程局部发生器
+std::mt19937& defaultGenerator() {
+    thread_local std::mt19937 gen(std::random_device{}());
+    return gen;
+}
+
+// 将softmax结果写入out（out可以与x相同）
+template<typename T>
+void softmaxInto(const T* x, T* out, size_t n) {
+    T max_val = *std::max_element(x, x + n);
+    
+    // 防止数值溢出
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = std::min(x[i] - max_val, T(500));
+    }
+    simd::kernels<T>().exp(out, out, n);
+    
+    T sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += out[i];
+    }
+    
+    // 防止除零和非有限数
+    if (sum <= 0 || !std::isfinite(sum)) {
+        std::fill(out, out + n, T(1) / n);
+        return;
+    }
+    
+    for (size_t i = 0; i < n; ++i) {
+        out[i] /= sum;
+    }
+}
+
+// 混合精度训练中按行在T与bf16之间转换，float走向量化内核
+template<typename T>
+void encodeRows(BasicMatrixView<const T> src, BasicMatrix<uint16_t>& dst) {
+    for (size_t i = 0; i < src.rows(); ++i) {
+        if constexpr (std::is_same<T, float>::value) {
+            simd::bf16Kernels().encode(src.row(i), dst.row(i), src.cols());
+        } else {
+            for (size_t j = 0; j < src.cols(); ++j) {
+                dst.row(i)[j] = simd::toBf16(static_cast<float>(src.row(i)[j]));
+            }
+        }
+    }
+}
+
+template<typename T>
+void decodeRows(const BasicMatrix<uint16_t>& src, BasicMatrixView<T> dst) {
+    for (size_t i = 0; i < dst.rows(); ++i) {
+        if constexpr (std::is_same<T, float>::value) {
+            simd::bf16Kernels().decode(src.row(i), dst.row(i), dst.cols());
+        } else {
+            for (size_t j = 0; j < dst.cols(); ++j) {
+                dst.row(i)[j] = simd::fromBf16(src.row(i)[j]);
+            }
+        }
+    }
+}
+
+template<typename T>
+void roundRows(BasicMatrixView<T> m) {
+    for (size_t i = 0; i < m.rows(); ++i) {
+        if constexpr (std::is_same<T, float>::value) {
+            simd::bf16Kernels().round(m.row(i), m.row(i), m.cols());
+        } else {
+            for (size_t j = 0; j < m.cols(); ++j) {
+                m.row(i)[j] = simd::fromBf16(simd::toBf16(static_cast<float>(m.row(i)[j])));
+            }
+        }
+    }
+}
+
+// 损失按double累积，单精度网络的损失值也不丢失有效位
+template<typename T>
+double crossEntropyLoss(const T* predicted, const T* target, size_t n) {
+    double loss = 0.0;
+    const double epsilon = 1e-15; // 防止log(0)
+    
+    for (size_t i = 0; i < n; ++i) {
+        // 限制预测值在[epsilon, 1-epsilon]范围内
+        double p = std::max(epsilon, std::min(1.0 - epsilon, static_cast<double>(predicted[i])));
+        loss -= target[i] * std::log(p);
+    }
+    
+    return loss;
+}
+
+// 一次Adam更新的参数：偏差修正项每步只计算一次，并入步长与二阶矩的缩放因子
+simd::AdamStep makeAdamStep(int timestep, double learning_rate, double beta1, double beta2, double epsilon) {
+    simd::AdamStep step;
+    step.beta1 = beta1;
+    step.beta2 = beta2;
+    step.epsilon = epsilon;
+    step.step_size = learning_rate / (1 - std::pow(beta1, timestep));
+    step.inv_sqrt_bias_correction2 = 1 / std::sqrt(1 - std::pow(beta2, timestep));
+    step.weight_scale = 1.0;
+    step.weight_decay = 0.0;
+    return step;
+}
+
+// LAMB的信任比例 ‖w‖/‖r‖，sums为 {Σw², Σr²}；任一范数为0（如初始为0的偏置）时不缩放
+double trustRatio(const double* sums) {
+    return sums[0] > 0 && sums[1] > 0 ? std::sqrt(sums[0]) / std::sqrt(sums[1]) : 1.0;
+}
+
+// 参数个数不少于该值的层，逐元素更新按行分块交给线程池；更小的层同步开销超过收益
+constexpr size_t kParallelUpdateMinParams = 1 << 15;
+
+// 对rows x cols的参数矩阵按行分块调用 fn(first_row, count)：pool非空且参数足够多时
+// 每个线程一块，否则在调用线程上一次完成。逐元素更新与分块方式无关，结果相同
+template<typename Fn>
+void forEachRowChunk(ThreadPool* pool, size_t rows, size_t cols, const Fn& fn) {
+    if (!pool || rows < 2 || rows * cols < kParallelUpdateMinParams) {
+        fn(size_t(0), rows);
+        return;
+    }
+    size_t chunks = std::min(pool->size(), rows);
+    pool->parallelFor(chunks, [&](size_t chunk) {
+        size_t begin = chunk * rows / chunks;
+        size_t end = (chunk + 1) * rows / chunks;
+        fn(begin, end - begin);
+    });
+}
+
+} // namespace
+
+// ========== 激活函数实现 ==========
+
+template<typename T>
+T BasicActivationFunction<T>::sigmoid(T x) {
+    // 添加数值稳定性检查
+    if (x > 500) return 1.0;
+    if (x < -500) return 0.0;
+    return T(1) / (T(1) + std::exp(-x));
+}
+
+template<typename T>
+T BasicActivationFunction<T>::sigmoidDerivative(T x) {
+    T s = sigmoid(x);
+    return s * (T(1) - s);
+}
+
+template<typename T>
+T BasicActivationFunction<T>::relu(T x) {
+    return std::max(T(0), x);
+}
+
+template<typename T>
+T BasicActivationFunction<T>::reluDerivative(T x) {
+    return x > 0 ? 1.0 : 0.0;
+}
+
+template<typename T>
+std::vector<T> BasicActivationFunction<T>::softmax(const std::vector<T>& x) {
+    if (x.empty()) return {};
+    
+    std::vector<T> result(x.size());
+    softmaxInto(x.data(), result.data(), x.size());
+    return result;
+}
+
+template<typename T>
+std::vector<T> BasicActivationFunction<T>::softmaxDerivative(const std::vector<T>& x, size_t index) {
+    std::vector<T> softmax_output = softmax(x);
+    std::vector<T> derivative(x.size());
+    
+    for (size_t i = 0; i < x.size(); ++i) {
+        if (i == index) {
+            derivative[i] = softmax_output[i] * (T(1) - softmax_output[i]);
+        } else {
+            derivative[i] = -softmax_output[i] * softmax_output[index];
+        }
+    }
+    
+    return derivative;
+}
+
+template<typename T>
+std::function<T(T)> BasicActivationFunction<T>::getActivation(ActivationType type) {
+    switch (type) {
+        case ActivationType::SIGMOID:
+            return sigmoid;
+        case ActivationType::RELU:
+            return relu;
+        default:
+            return sigmoid;
+    }
+}
+
+template<typename T>
+std::function<T(T)> BasicActivationFunction<T>::getDerivative(ActivationType type) {
+    switch (type) {
+        case ActivationType::SIGMOID:
+            return sigmoidDerivative;
+        case ActivationType::RELU:
+            return reluDerivative;
+        default:
+            return sigmoidDerivative;
+    }
+}
+
+template<typename T>
+std::function<std::vector<T>(const std::vector<T>&)>
+BasicActivationFunction<T>::getVectorActivation(ActivationType type) {
+    switch (type) {
+        case ActivationType::SOFTMAX:
+            return softmax;
+        default:
+            return [type](const std::vector<T>& x) {
+                auto func = getActivation(type);
+                std::vector<T> result(x.size());
+                for (size_t i = 0; i < x.size(); ++i) {
+                    result[i] = func(x[i]);
+                }
+                return result;
+            };
+    }
+}
+
+template<typename T>
+void BasicActivationFunction<T>::applyInPlace(ActivationType type, T* x, size_t n) {
+    switch (type) {
+        case ActivationType::RELU:
+            simd::kernels<T>().relu(x, x, n);
+            break;
+        case ActivationType::SOFTMAX:
+            softmaxInto(x, x, n);
+            break;
+        default:
+            simd::kernels<T>().sigmoid(x, x, n);
+            break;
+    }
+}
+
+// ========== 激活函数内核 ==========
+// 每种激活函数一个编译期特化的算子，由Layer在构造时按ActivationType选定一次，
+// 热点循环中不再有逐元素的std::function调用。导数都由缓存的输出值计算，无需重新求exp。
+
+namespace {
+
+template<typename T>
+struct SigmoidOp {
+    using Scalar = T;
+    static constexpr bool kElementwise = true;
+    static T scalar(T z) { return BasicActivationFunction<T>::sigmoid(z); }
+    static void apply(T* a, size_t n) { simd::kernels<T>().sigmoid(a, a, n); }
+    static T derivativeFromOutput(T a) { return a * (T(1) - a); }
+};
+
+template<typename T>
+struct ReluOp {
+    using Scalar = T;
+    static constexpr bool kElementwise = true;
+    static T scalar(T z) { return BasicActivationFunction<T>::relu(z); }
+    static void apply(T* a, size_t n) { simd::kernels<T>().relu(a, a, n); }
+    static T derivativeFromOutput(T a) { return a > 0 ? T(1) : T(0); }
+};
+
+template<typename T>
+struct SoftmaxOp {
+    using Scalar = T;
+    static constexpr bool kElementwise = false;
+    static void apply(T* a, size_t n) { softmaxInto(a, a, n); }
+};
+
+// 输入维度不超过该值时（如螨虫分类的2-3-1网络），逐行融合计算 加权和+偏置+激活
+constexpr size_t kFusedInputLimit = 16;
+
+// a = f(W·x + b)
+template<typename Op, typename T = typename Op::Scalar>
+void denseForward(BasicMatrixView<const T> w, const T* b, const T* x, T* a) {
+    size_t n = w.rows();
+    if (w.cols() <= kFusedInputLimit) {
+        for (size_t i = 0; i < n; ++i) {
+            const T* wi = w.row(i);
+            T z = b[i];
+            for (size_t j = 0; j < w.cols(); ++j) {
+                z += wi[j] * x[j];
+            }
+            if constexpr (Op::kElementwise) {
+                a[i] = Op::scalar(z);
+            } else {
+                a[i] = z;
+            }
+        }
+        if constexpr (!Op::kElementwise) {
+            Op::apply(a, n);
+        }
+    } else {
+        std::copy(b, b + n, a);
+        linalg::gemv(w, x, a, 1.0);
+        Op::apply(a, n);
+    }
+}
+
+template<typename Op, typename T = typename Op::Scalar>
+void activateInPlace(T* a, size_t n) {
+    Op::apply(a, n);
+}
+
+// δ = g ⊙ f'(z)，f'(z)由输出a = f(z)得到
+template<typename Op, typename T = typename Op::Scalar>
+void computeErrors(const T* g, const T* a, T* e, size_t n) {
+    if constexpr (Op::kElementwise) {
+        for (size_t i = 0; i < n; ++i) {
+            e[i] = g[i] * Op::derivativeFromOutput(a[i]);
+        }
+    } else {
+        // 对于softmax+交叉熵，梯度直接是 predicted - target
+        std::copy(g, g + n, e);
+    }
+}
+
+} // namespace
+
+// ========== 层缓冲区实现 ==========
+
+template<typename T>
+void BasicLayerBuffers<T>::ensureCapacity(size_t batch_size, size_t input_size, size_t output_size) {
+    if (neurons.rows() < batch_size || neurons.cols() != output_size ||
+        input_gradient.cols() != input_size) {
+        size_t rows = std::max(batch_size, neurons.rows());
+        neurons.resize(rows, output_size);
+        errors.resize(rows, output_size);
+        input_gradient.resize(rows, input_size);
+    }
+    ensureGradients(input_size, output_size);
+}
+
+template<typename T>
+void BasicLayerBuffers<T>::ensureGradients(size_t input_size, size_t output_size) {
+    if (grad_weights.rows() != output_size || grad_weights.cols() != input_size) {
+        grad_weights.resize(output_size, input_size, 0.0);
+        grad_biases.assign(output_size, 0.0);
+    }
+}
+
+template<typename T>
+void BasicLayerBuffers<T>::ensureStash(size_t batch_size, size_t output_size) {
+    if (stash.rows() < batch_size || stash.cols() != output_size) {
+        stash.resize(std::max(batch_size, stash.rows()), output_size);
+    }
+}
+
+template<typename T>
+void BasicOptimizerState<T>::ensureShape(size_t slots, size_t input_size, size_t output_size) {
+    bool matches = weight_slots.size() == slots && bias_slots.size() == slots;
+    for (size_t i = 0; matches && i < slots; ++i) {
+        matches = weight_slots[i].rows() == output_size && weight_slots[i].cols() == input_size &&
+                  bias_slots[i].size() == output_size;
+    }
+    if (matches) return;
+    
+    weight_slots.resize(slots);
+    bias_slots.resize(slots);
+    for (size_t i = 0; i < slots; ++i) {
+        weight_slots[i].resize(output_size, input_size, 0.0);
+        bias_slots[i].assign(output_size, 0.0);
+    }
+    timestep = 0;
+}
+
+// ========== 层实现 ==========
+
+template<typename T>
+BasicLayer<T>::BasicLayer(size_t input_size, size_t output_size, ActivationType activation)
+    : BasicLayer(input_size, output_size, activation, defaultGenerator()) {
+}
+
+template<typename T>
+BasicLayer<T>::BasicLayer(size_t input_size, size_t output_size, ActivationType activation, std::mt19937& gen)
+    : activation_type(activation) {
+    
+    weights.resize(output_size, input_size);
+    biases.resize(output_size);
+    neurons.resize(output_size);
+    errors.resize(output_size);
+    selectKernels();
+    
+    buffers.ensureCapacity(0, input_size, output_size);
+    
+    initializeWeights(gen);
+}
+
+template<typename T>
+BasicLayer<T>::BasicLayer(ConstMatrixView weights, std::vector<T> biases, ActivationType activation,
+                          std::shared_ptr<const void> storage)
+    : external_weights(weights), external_storage(std::move(storage)),
+      biases(std::move(biases)), activation_type(activation) {
+    if (this->biases.size() != weights.rows()) {
+        throw std::invalid_argument("Bias size mismatch");
+    }
+    neurons.resize(weights.rows());
+    errors.resize(weights.rows());
+    selectKernels();
+}
+
+template<typename T>
+void BasicLayer<T>::makeWritable() {
+    if (!external_storage) return;
+    
+    weights.resize(external_weights.rows(), external_weights.cols());
+    weights.assign(external_weights);
+    external_weights = ConstMatrixView();
+    external_storage.reset();
+    
+    buffers.ensureCapacity(0, getInputSize(), getOutputSize());
+}
+
+template<typename T>
+void BasicLayer<T>::selectKernels() {
+    switch (activation_type) {
+        case ActivationType::RELU:
+            forward_kernel = denseForward<ReluOp<T>>;
+            activate_kernel = activateInPlace<ReluOp<T>>;
+            error_kernel = computeErrors<ReluOp<T>>;
+            break;
+        case ActivationType::SOFTMAX:
+            forward_kernel = denseForward<SoftmaxOp<T>>;
+            activate_kernel = activateInPlace<SoftmaxOp<T>>;
+            error_kernel = computeErrors<SoftmaxOp<T>>;
+            break;
+        default:
+            forward_kernel = denseForward<SigmoidOp<T>>;
+            activate_kernel = activateInPlace<SigmoidOp<T>>;
+            error_kernel = computeErrors<SigmoidOp<T>>;
+            break;
+    }
+}
+
+template<typename T>
+void BasicLayer<T>::initializeWeights() {
+    initializeWeights(defaultGenerator());
+}
+
+template<typename T>
+void BasicLayer<T>::initializeWeights(std::mt19937& gen) {
+    makeWritable();
+    
+    // 改进的权重初始化
+    double limit;
+    if (activation_type == ActivationType::RELU) {
+        // He初始化，适用于ReLU
+        limit = std::sqrt(2.0 / getInputSize());
+        std::normal_distribution<> dis(0.0, limit);
+        for (size_t i = 0; i < weights.rows(); ++i) {
+            T* w = weights.row(i);
+            for (size_t j = 0; j < weights.cols(); ++j) {
+                w[j] = static_cast<T>(dis(gen));
+            }
+        }
+    } else {
+        // Xavier初始化，适用于sigmoid和tanh
+        limit = std::sqrt(6.0 / (getInputSize() + getOutputSize()));
+        std::uniform_real_distribution<> dis(-limit, limit);
+        for (size_t i = 0; i < weights.rows(); ++i) {
+            T* w = weights.row(i);
+            for (size_t j = 0; j < weights.cols(); ++j) {
+                w[j] = static_cast<T>(dis(gen));
+            }
+        }
+    }
+    
+    // 偏置初始化为0
+    std::fill(biases.begin(), biases.end(), 0.0);
+}
+
+template<typename T>
+const std::vector<T>& BasicLayer<T>::forward(const std::vector<T>& input) {
+    if (input.size() != getInputSize()) {
+        throw std::invalid_argument("Input size mismatch. Expected: " + 
+                                  std::to_string(getInputSize()) + 
+                                  ", Got: " + std::to_string(input.size()));
+    }
+    
+    // 计算加权和并应用激活函数 a = f(W·x + b)
+    forward_kernel(getWeights(), biases.data(), input.data(), neurons.data());
+    
+    return neurons;
+}
+
+template<typename T>
+const std::vector<T>& BasicLayer<T>::backward(const std::vector<T>& gradient) {
+    if (gradient.size() != getOutputSize()) {
+        throw std::invalid_argument("Gradient size mismatch");
+    }
+    
+    input_gradient.resize(getInputSize());
+    
+    // 计算误差项
+    error_kernel(gradient.data(), neurons.data(), errors.data(), errors.size());
+    
+    // 计算输入梯度（传递给前一层）Wᵀ·δ
+    linalg::gemvT(getWeights(), errors.data(), input_gradient.data());
+    
+    return input_gradient;
+}
+
+template<typename T>
+BasicMatrixView<const T> BasicLayer<T>::forwardBatch(ConstMatrixView input) {
+    return forwardBatch(input, buffers);
+}
+
+template<typename T>
+BasicMatrixView<const T> BasicLayer<T>::backwardBatch(ConstMatrixView gradient, ConstMatrixView input, bool propagate) {
+    return backwardBatch(gradient, input, buffers, propagate);
+}
+
+template<typename T>
+BasicMatrixView<const T> BasicLayer<T>::forwardBatch(ConstMatrixView input, LayerBuffers& buf) const {
+    buf.ensureCapacity(input.rows(), getInputSize(), getOutputSize());
+    MatrixView a = buf.neurons.view().rowRange(0, input.rows());
+    forwardInto(input, a);
+    return a;
+}
+
+template<typename T>
+void BasicLayer<T>::forwardInto(ConstMatrixView input, MatrixView output) const {
+    if (input.cols() != getInputSize()) {
+        throw std::invalid_argument("Input size mismatch. Expected: " + 
+                                  std::to_string(getInputSize()) + 
+                                  ", Got: " + std::to_string(input.cols()));
+    }
+    if (output.rows() != input.rows() || output.cols() != getOutputSize()) {
+        throw std::invalid_argument("Output buffer size mismatch");
+    }
+    
+    size_t batch_size = input.rows();
+    ConstMatrixView weights = getWeights();
+    
+    if (batch_size == 1 || getInputSize() <= kFusedInputLimit) {
+        // 单样本或小层：逐样本走融合内核
+        for (size_t b = 0; b < batch_size; ++b) {
+            forward_kernel(weights, biases.data(), input.row(b), output.row(b));
+        }
+        return;
+    }
+    
+    // 计算加权和 Z = X·Wᵀ + b，直接写入输出缓冲区后原地激活
+    for (size_t b = 0; b < batch_size; ++b) {
+        std::copy(biases.begin(), biases.end(), output.row(b));
+    }
+    linalg::gemmNT(input, weights, output, 1.0);
+    for (size_t b = 0; b < batch_size; ++b) {
+        activate_kernel(output.row(b), getOutputSize());
+    }
+}
+
+template<typename T>
+BasicMatrixView<const T> BasicLayer<T>::backwardBatch(ConstMatrixView gradient, ConstMatrixView input,
+                                                      LayerBuffers& buf, bool propagate) const {
+    size_t batch_size = gradient.rows();
+    if (batch_size > buf.errors.rows()) {
+        throw std::invalid_argument("Gradient size mismatch");
+    }
+    
+    MatrixView input_gradient = propagate ? buf.input_gradient.view().rowRange(0, batch_size) : MatrixView();
+    backwardInto(gradient, buf.neurons.view().rowRange(0, batch_size), input,
+                 buf.errors.view().rowRange(0, batch_size), input_gradient, buf);
+    return input_gradient;
+}
+
+template<typename T>
+void BasicLayer<T>::backwardInto(ConstMatrixView gradient, ConstMatrixView output, ConstMatrixView input,
+                                 MatrixView errors, MatrixView input_gradient, LayerBuffers& buf) const {
+    size_t batch_size = gradient.rows();
+    if (input.rows() != batch_size || input.cols() != getInputSize()) {
+        throw std::invalid_argument("Input size mismatch for backward pass");
+    }
+    if (gradient.cols() != getOutputSize() || output.rows() != batch_size || errors.rows() != batch_size) {
+        throw std::invalid_argument("Gradient size mismatch");
+    }
+    
+    // 误差项
+    for (size_t b = 0; b < batch_size; ++b) {
+        error_kernel(gradient.row(b), output.row(b), errors.row(b), getOutputSize());
+    }
+    
+    // 输入梯度（传递给前一层）δ·W
+    if (input_gradient.rows() > 0) {
+        linalg::gemmNN(errors, getWeights(), input_gradient);
+    }
+    
+    // 累积整批的权重梯度 δᵀ·X 和偏置梯度
+    linalg::gemmTN(errors, input, buf.grad_weights);
+    std::fill(buf.grad_biases.begin(), buf.grad_biases.end(), 0.0);
+    for (size_t b = 0; b < batch_size; ++b) {
+        const T* e = errors.row(b);
+        for (size_t i = 0; i < getOutputSize(); ++i) {
+            buf.grad_biases[i] += e[i];
+        }
+    }
+}
+
+template<typename T>
+BasicMatrixView<const T> BasicLayer<T>::backpropagate(ConstMatrixView gradient, LayerBuffers& buf, bool propagate) const {
+    size_t batch_size = gradient.rows();
+    if (gradient.cols() != getOutputSize() || batch_size > buf.errors.rows()) {
+        throw std::invalid_argument("Gradient size mismatch");
+    }
+    
+    // 计算误差项
+    for (size_t b = 0; b < batch_size; ++b) {
+        error_kernel(gradient.row(b), buf.neurons.row(b), buf.errors.row(b), getOutputSize());
+    }
+    
+    if (!propagate) {
+        return ConstMatrixView();
+    }
+    
+    // 计算输入梯度（传递给前一层）δ·W
+    ConstMatrixView delta = buf.errors.view().rowRange(0, batch_size);
+    MatrixView input_gradient = buf.input_gradient.view().rowRange(0, batch_size);
+    linalg::gemmNN(delta, getWeights(), input_gradient);
+    
+    return input_gradient;
+}
+
+template<typename T>
+void BasicLayer<T>::reduceGradients(const std::vector<const LayerBuffers*>& parts, size_t first_row, size_t count) {
+    const simd::Kernels<T>& k = simd::kernels<T>();
+    size_t cols = getInputSize();
+    
+    // 固定按parts的顺序求和，保证结果与线程调度无关
+    for (size_t i = first_row; i < first_row + count; ++i) {
+        T* dst = buffers.grad_weights.row(i);
+        std::copy(parts[0]->grad_weights.row(i), parts[0]->grad_weights.row(i) + cols, dst);
+        T bias = parts[0]->grad_biases[i];
+        for (size_t p = 1; p < parts.size(); ++p) {
+            k.axpy(1.0, parts[p]->grad_weights.row(i), dst, cols);
+            bias += parts[p]->grad_biases[i];
+        }
+        buffers.grad_biases[i] = bias;
+    }
+}
+
+template<typename T>
+bool BasicLayer<T>::unscaleGradients(double factor) {
+    // 按double相乘：较大的缩放的倒数在float中会成为非规格化数而丢失精度
+    bool finite = true;
+    for (size_t i = 0; i < buffers.grad_weights.rows(); ++i) {
+        T* g = buffers.grad_weights.row(i);
+        for (size_t j = 0; j < buffers.grad_weights.cols(); ++j) {
+            g[j] = static_cast<T>(g[j] * factor);
+            finite &= std::isfinite(g[j]);
+        }
+    }
+    for (T& g : buffers.grad_biases) {
+        g = static_cast<T>(g * factor);
+        finite &= std::isfinite(g);
+    }
+    return finite;
+}
+
+template<typename T>
+typename BasicLayer<T>::ParameterBlock BasicLayer<T>::parameterBlock(const LayerBuffers& buf) {
+    ParameterBlock params;
+    params.weights = weights.view();
+    params.biases = biases.data();
+    params.grad_weights = buf.grad_weights.view();
+    params.grad_biases = buf.grad_biases.data();
+    return params;
+}
+
+template<typename T>
+void BasicLayer<T>::applySampleSGD(const T* delta, const T* input, double learning_rate) {
+    const simd::Kernels<T>& k = simd::kernels<T>();
+    size_t cols = getInputSize();
+    
+    // 收集非零输入的下标：MNIST图像中大部分像素为0，只需更新对应的列
+    thread_local std::vector<size_t> nonzero;
+    nonzero.clear();
+    for (size_t j = 0; j < cols; ++j) {
+        if (input[j] != 0.0) nonzero.push_back(j);
+    }
+    bool sparse = nonzero.size() * 2 < cols;
+    
+    // W -= lr·δxᵀ，b -= lr·δ；误差项为0的行（如未激活的ReLU）不需要更新
+    for (size_t i = 0; i < getOutputSize(); ++i) {
+        T scale = static_cast<T>(-learning_rate * delta[i]);
+        if (scale == 0) continue;
+        
+        T* w = weights.row(i);
+        if (sparse) {
+            for (size_t j : nonzero) {
+                w[j] += scale * input[j];
+            }
+        } else {
+            k.axpy(scale, input, w, cols);
+        }
+        biases[i] += scale;
+    }
+}
+
+template<typename T>
+void BasicLayer<T>::sampleGradients(const T* delta, const T* input, LayerBuffers& buf) const {
+    buf.ensureGradients(getInputSize(), getOutputSize());
+    
+    // 单样本梯度 δxᵀ 写入线程私有缓冲区
+    buf.grad_weights.fill(0.0);
+    linalg::ger(1.0, delta, input, buf.grad_weights);
+    std::copy(delta, delta + getOutputSize(), buf.grad_biases.begin());
+}
+
+// ========== 优化器实现 ==========
+
+const char* optimizerTypeName(OptimizerType type) {
+    switch (type) {
+        case OptimizerType::SGD: return "SGD";
+        case OptimizerType::ADAM: return "Adam";
+        case OptimizerType::MOMENTUM: return "Momentum";
+        case OptimizerType::NESTEROV: return "Nesterov";
+        case OptimizerType::RMSPROP: return "RMSProp";
+        case OptimizerType::ADAMW: return "AdamW";
+        case OptimizerType::LAMB: return "LAMB";
+    }
+    return "Unknown";
+}
+
+template<typename T>
+void BasicOptimizer<T>::prepareState(State& state, const Layer& layer) const {
+    state.ensureShape(stateSlots(), layer.getInputSize(), layer.getOutputSize());
+    size_t scratch = scratchSize(layer.getOutputSize());
+    if (state.scratch.size() < scratch) {
+        state.scratch.resize(scratch);
+    }
+}
+
+template<typename T>
+typename BasicOptimizer<T>::State& BasicOptimizer<T>::layerState(size_t index, const Layer& layer) {
+    if (states.size() <= index) {
+        states.resize(index + 1);
+    }
+    prepareState(states[index], layer);
+    return states[index];
+}
+
+template<typename T>
+void BasicOptimizer<T>::updateLayer(size_t index, Layer& layer, double learning_rate, ThreadPool* pool) {
+    apply(layer.parameterBlock(), layerState(index, layer), learning_rate, pool);
+}
+
+template<typename T>
+void BasicOptimizer<T>::updateLayerSample(Layer& layer, const T* input, LayerBuffers& buf,
+                                          State& state, double learning_rate) {
+    // 单样本梯度写入线程私有缓冲区，再用线程私有的状态更新共享参数
+    layer.sampleGradients(buf.errors.row(0), input, buf);
+    prepareState(state, layer);
+    apply(layer.parameterBlock(buf), state, learning_rate, nullptr);
+}
+
+template<typename T>
+void BasicSGDOptimizer<T>::apply(const ParameterBlock& params, State& /*state*/, double learning_rate,
+                                 ThreadPool* pool) {
+    const simd::Kernels<T>& k = simd::kernels<T>();
+    T alpha = static_cast<T>(-learning_rate);
+    size_t cols = params.weights.cols();
+    forEachRowChunk(pool, params.weights.rows(), cols, [&](size_t first_row, size_t count) {
+        for (size_t i = first_row; i < first_row + count; ++i) {
+            k.axpy(alpha, params.grad_weights.row(i), params.weights.row(i), cols);
+        }
+        k.axpy(alpha, params.grad_biases + first_row, params.biases + first_row, count);
+    });
+}
+
+template<typename T>
+void BasicSGDOptimizer<T>::updateLayerSample(Layer& layer, const T* input, LayerBuffers& buf,
+                                             State& /*state*/, double learning_rate) {
+    layer.applySampleSGD(buf.errors.row(0), input, learning_rate);
+}
+
+template<typename T>
+void BasicMomentumOptimizer<T>::apply(const ParameterBlock& params, State& state, double learning_rate,
+                                      ThreadPool* pool) {
+    const simd::Kernels<T>& k = simd::kernels<T>();
+    simd::MomentumStep step;
+    step.momentum = this->config.momentum;
+    step.grad_scale = nesterov ? learning_rate : 0.0;
+    step.velocity_scale = nesterov ? learning_rate * this->config.momentum : learning_rate;
+    
+    BasicMatrix<T>& velocity = state.weight_slots[0];
+    T* bias_velocity = state.bias_slots[0].data();
+    size_t cols = params.weights.cols();
+    forEachRowChunk(pool, params.weights.rows(), cols, [&](size_t first_row, size_t count) {
+        for (size_t i = first_row; i < first_row + count; ++i) {
+            k.momentum(params.weights.row(i), velocity.row(i), params.grad_weights.row(i), cols, step);
+        }
+        k.momentum(params.biases + first_row, bias_velocity + first_row, params.grad_biases + first_row,
+                   count, step);
+    });
+}
+
+template<typename T>
+void BasicRmsPropOptimizer<T>::apply(const ParameterBlock& params, State& state, double learning_rate,
+                                     ThreadPool* pool) {
+    const simd::Kernels<T>& k = simd::kernels<T>();
+    simd::RmsPropStep step;
+    step.rho = this->config.rho;
+    step.learning_rate = learning_rate;
+    step.epsilon = this->config.epsilon;
+    
+    BasicMatrix<T>& mean_square = state.weight_slots[0];
+    T* bias_mean_square = state.bias_slots[0].data();
+    size_t cols = params.weights.cols();
+    forEachRowChunk(pool, params.weights.rows(), cols, [&](size_t first_row, size_t count) {
+        for (size_t i = first_row; i < first_row + count; ++i) {
+            k.rmsprop(params.weights.row(i), mean_square.row(i), params.grad_weights.row(i), cols, step);
+        }
+        k.rmsprop(params.biases + first_row, bias_mean_square + first_row, params.grad_biases + first_row,
+                  count, step);
+    });
+}
+
+template<typename T>
+void BasicAdamOptimizer<T>::apply(const ParameterBlock& params, State& state, double learning_rate,
+                                  ThreadPool* pool) {
+    const simd::Kernels<T>& k = simd::kernels<T>();
+    const OptimizerConfig& c = this->config;
+    state.timestep++;
+    simd::AdamStep bias_step = makeAdamStep(state.timestep, learning_rate, c.beta1, c.beta2, c.epsilon);
+    simd::AdamStep weight_step = bias_step;
+    if (decoupled_weight_decay) {
+        weight_step.weight_scale = 1 - learning_rate * c.weight_decay;
+    }
+    
+    BasicMatrix<T>& m = state.weight_slots[0];
+    BasicMatrix<T>& v = state.weight_slots[1];
+    T* m_biases = state.bias_slots[0].data();
+    T* v_biases = state.bias_slots[1].data();
+    size_t cols = params.weights.cols();
+    forEachRowChunk(pool, params.weights.rows(), cols, [&](size_t first_row, size_t count) {
+        for (size_t i = first_row; i < first_row + count; ++i) {
+            k.adam(params.weights.row(i), m.row(i), v.row(i), params.grad_weights.row(i), cols, weight_step);
+        }
+        k.adam(params.biases + first_row, m_biases + first_row, v_biases + first_row,
+               params.grad_biases + first_row, count, bias_step);
+    });
+}
+
+template<typename T>
+void BasicLambOptimizer<T>::apply(const ParameterBlock& params, State& state, double learning_rate,
+                                  ThreadPool* pool) {
+    const simd::Kernels<T>& k = simd::kernels<T>();
+    const OptimizerConfig& c = this->config;
+    state.timestep++;
+    
+    BasicMatrix<T>& m = state.weight_slots[0];
+    BasicMatrix<T>& v = state.weight_slots[1];
+    T* m_biases = state.bias_slots[0].data();
+    T* v_biases = state.bias_slots[1].data();
+    size_t rows = params.weights.rows();
+    size_t cols = params.weights.cols();
+    
+    // 第一遍：更新矩估计，逐行记录 Σw² 与 Σr²（r为学习率取1时AdamW的更新量）。
+    // 按行存放在state.scratch中再按行序求和，范数与分块方式无关
+    double* sums = state.scratch.data();
+    std::fill(sums, sums + 2 * rows, 0.0);
+    simd::AdamStep unit_step = makeAdamStep(state.timestep, 1.0, c.beta1, c.beta2, c.epsilon);
+    unit_step.weight_decay = c.weight_decay;
+    forEachRowChunk(pool, rows, cols, [&](size_t first_row, size_t count) {
+        for (size_t i = first_row; i < first_row + count; ++i) {
+            k.adamMoments(params.weights.row(i), m.row(i), v.row(i), params.grad_weights.row(i), cols,
+                          unit_step, sums + 2 * i);
+        }
+    });
+    double weight_sums[2] = {0.0, 0.0};
+    for (size_t i = 0; i < rows; ++i) {
+        weight_sums[0] += sums[2 * i];
+        weight_sums[1] += sums[2 * i + 1];
+    }
+    // 偏置很短，在调用线程上单独更新矩估计并求范数（不做权重衰减）
+    double bias_sums[2] = {0.0, 0.0};
+    simd::AdamStep bias_unit_step = makeAdamStep(state.timestep, 1.0, c.beta1, c.beta2, c.epsilon);
+    k.adamMoments(params.biases, m_biases, v_biases, params.grad_biases, rows, bias_unit_step, bias_sums);
+    
+    // 第二遍：w = (1 - lr'·λ)·w - lr'·m̂/(sqrt(v̂) + ε)，lr' = lr·信任比例
+    double weight_rate = learning_rate * trustRatio(weight_sums);
+    simd::AdamStep weight_step = makeAdamStep(state.timestep, weight_rate, c.beta1, c.beta2, c.epsilon);
+    weight_step.weight_scale = 1 - weight_rate * c.weight_decay;
+    forEachRowChunk(pool, rows, cols, [&](size_t first_row, size_t count) {
+        for (size_t i = first_row; i < first_row + count; ++i) {
+            k.adamApply(params.weights.row(i), m.row(i), v.row(i), cols, weight_step);
+        }
+    });
+    simd::AdamStep bias_step = makeAdamStep(state.timestep, learning_rate * trustRatio(bias_sums),
+                                            c.beta1, c.beta2, c.epsilon);
+    k.adamApply(params.biases, m_biases, v_biases, rows, bias_step);
+}
+
+// ========== 神经网络实现 ==========
+
+template<typename T>
+BasicNeuralNetwork<T>::BasicNeuralNetwork(double lr, LossType loss) 
+    : learning_rate(lr), loss_type(loss), rng(std::random_device{}()) {
+    optimizer = make_unique<BasicSGDOptimizer<T>>();
+}
+
+template<typename T>
+BasicNeuralNetwork<T>::~BasicNeuralNetwork() = default;
+
+template<typename T>
+void BasicNeuralNetwork<T>::addLayer(int neurons, ActivationType activation) {
+    if (neurons <= 0) {
+        throw std::invalid_argument("Number of neurons must be positive");
+    }
+    
+    size_t input_size = layers.empty() ? 0 : layers.back()->getOutputSize();
+    
+    if (layers.empty()) {
+        // 第一层，输入大小将在第一次前向传播时确定
+        // 使用占位符大小1，稍后会重新创建
+        layers.push_back(::make_unique<Layer>(1, neurons, activation, rng));
+    } else {
+        layers.push_back(::make_unique<Layer>(input_size, neurons, activation, rng));
+    }
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::setSeed(unsigned seed) {
+    rng.seed(seed);
+    for (auto& layer : layers) {
+        layer->initializeWeights(rng);
+    }
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::setNumThreads(size_t threads) {
+    if (threads == 0) {
+        threads = ThreadPool::hardwareThreads();
+    }
+    if (threads == num_threads) return;
+    
+    num_threads = threads;
+    thread_pool.reset(threads > 1 ? new ThreadPool(threads) : nullptr);
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::setMixedPrecision(const MixedPrecisionConfig& config) {
+    if (!(config.loss_scale > 0.0) || config.growth_interval == 0) {
+        throw std::invalid_argument("Invalid loss scaling configuration");
+    }
+    mixed_precision = config;
+    loss_scale = config.loss_scale;
+    good_steps = 0;
+    skipped_steps = 0;
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::setOptimizer(OptimizerType type, double lr, const OptimizerConfig& config) {
+    if (!(config.momentum >= 0 && config.momentum < 1) ||
+        !(config.beta1 >= 0 && config.beta1 < 1) || !(config.beta2 >= 0 && config.beta2 < 1) ||
+        !(config.rho >= 0 && config.rho < 1) || !(config.epsilon > 0) || !(config.weight_decay >= 0)) {
+        throw std::invalid_argument("Invalid optimizer configuration");
+    }
+    learning_rate = lr;
+    
+    switch (type) {
+        case OptimizerType::MOMENTUM:
+        case OptimizerType::NESTEROV:
+            optimizer = make_unique<BasicMomentumOptimizer<T>>(config, type == OptimizerType::NESTEROV);
+            break;
+        case OptimizerType::RMSPROP:
+            optimizer = make_unique<BasicRmsPropOptimizer<T>>(config);
+            break;
+        case OptimizerType::ADAM:
+        case OptimizerType::ADAMW:
+            optimizer = make_unique<BasicAdamOptimizer<T>>(config, type == OptimizerType::ADAMW);
+            break;
+        case OptimizerType::LAMB:
+            optimizer = make_unique<BasicLambOptimizer<T>>(config);
+            break;
+        case OptimizerType::SGD:
+        default:
+            optimizer = make_unique<BasicSGDOptimizer<T>>(config);
+            break;
+    }
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::makeWritable() {
+    for (auto& layer : layers) {
+        layer->makeWritable();
+    }
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::ensureInputLayer(size_t input_size) {
+    // 检查第一层是否需要重新初始化（仅在输入大小为1时，说明是占位符）
+    if (layers[0]->getInputSize() == 1 && input_size != 1) {
+        size_t output_size = layers[0]->getOutputSize();
+        ActivationType activation = ActivationType::RELU; // 默认使用ReLU作为隐藏层激活函数
+        layers[0] = ::make_unique<Layer>(input_size, output_size, activation, rng);
+    }
+}
+
+template<typename T>
+const std::vector<T>& BasicNeuralNetwork<T>::forward(const std::vector<T>& input) {
+    if (layers.empty()) {
+        return input;
+    }
+    
+    ensureInputLayer(input.size());
+    
+    // 逐层前向传播，每层的输出直接作为下一层的输入，不做拷贝
+    const std::vector<T>* current_input = &input;
+    for (auto& layer : layers) {
+        current_input = &layer->forward(*current_input);
+    }
+    
+    return *current_input;
+}
+
+template<typename T>
+BasicMatrixView<const T> BasicNeuralNetwork<T>::forwardBatch(ConstMatrixView inputs) {
+    if (layers.empty()) {
+        return inputs;
+    }
+    
+    ensureInputLayer(inputs.cols());
+    
+    // 逐层前向传播，每层的输出保存在该层的批缓冲区中
+    ConstMatrixView current = inputs;
+    for (auto& layer : layers) {
+        current = layer->forwardBatch(current);
+    }
+    
+    return current;
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::backwardBatch(ConstMatrixView inputs, const TargetView& targets) {
+    if (layers.empty()) return;
+    
+    size_t batch_size = inputs.rows();
+    const Layer& output_layer = *layers.back();
+    checkTargets(targets, batch_size);
+    makeWritable();
+    
+    // 按批大小取平均，使学习率与批大小无关
+    computeOutputGradient(output_layer.getBatchNeurons(batch_size), targets, 1.0 / batch_size,
+                          output_gradient);
+    
+    // 从输出层开始反向传播，第一层不需要计算输入梯度
+    ConstMatrixView gradient = output_gradient.view().rowRange(0, batch_size);
+    for (int i = static_cast<int>(layers.size()) - 1; i >= 0; --i) {
+        ConstMatrixView layer_input = i > 0 ? layers[i-1]->getBatchNeurons(batch_size) : inputs;
+        gradient = layers[i]->backwardBatch(gradient, layer_input, i > 0);
+    }
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::computeOutputGradient(ConstMatrixView output, const TargetView& targets,
+                                                  double scale, Matrix& gradient) const {
+    // MSE（误差项中再乘激活导数）与softmax+交叉熵都从 (predicted - target) 开始
+    size_t batch_size = targets.rows();
+    size_t n = targets.cols();
+    if (gradient.rows() < batch_size || gradient.cols() != n) {
+        gradient.resize(batch_size, n);
+    }
+    
+    if (targets.hasLabels()) {
+        // one-hot目标只在label处为1
+        for (size_t b = 0; b < batch_size; ++b) {
+            const T* predicted = output.row(b);
+            T* g = gradient.row(b);
+            for (size_t i = 0; i < n; ++i) {
+                g[i] = predicted[i] * scale;
+            }
+            int label = targets.label(b);
+            g[label] = (predicted[label] - 1.0) * scale;
+        }
+        return;
+    }
+    
+    for (size_t b = 0; b < batch_size; ++b) {
+        const T* predicted = output.row(b);
+        const T* target = targets.row(b);
+        T* g = gradient.row(b);
+        for (size_t i = 0; i < n; ++i) {
+            g[i] = (predicted[i] - target[i]) * scale;
+        }
+    }
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::checkTargets(const TargetView& targets, size_t batch_size) const {
+    if (targets.rows() != batch_size) {
+        throw std::invalid_argument("Input and target batch sizes don't match");
+    }
+    size_t output_size = layers.back()->getOutputSize();
+    if (targets.cols() != output_size) {
+        throw std::invalid_argument("Target size mismatch");
+    }
+    if (targets.hasLabels()) {
+        for (size_t b = 0; b < batch_size; ++b) {
+            int label = targets.label(b);
+            if (label < 0 || static_cast<size_t>(label) >= output_size) {
+                throw std::invalid_argument("Class label out of range");
+            }
+        }
+    }
+}
+
+template<typename T>
+double BasicNeuralNetwork<T>::batchLoss(ConstMatrixView output, const TargetView& targets) const {
+    double total_loss = 0.0;
+    if (targets.hasLabels()) {
+        for (size_t b = 0; b < output.rows(); ++b) {
+            total_loss += sampleLoss(output.row(b), targets.label(b), output.cols());
+        }
+    } else {
+        for (size_t b = 0; b < output.rows(); ++b) {
+            total_loss += sampleLoss(output.row(b), targets.row(b), output.cols());
+        }
+    }
+    return total_loss;
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::applyGradients() {
+    for (size_t i = 0; i < layers.size(); ++i) {
+        optimizer->updateLayer(i, *layers[i], learning_rate, thread_pool.get());
+    }
+}
+
+template<typename T>
+double BasicNeuralNetwork<T>::train(const std::vector<T>& input, const std::vector<T>& target) {
+    // 单样本训练即批大小为1的小批量训练
+    ConstMatrixView input_row(input.data(), 1, input.size(), input.size());
+    ConstMatrixView target_row(target.data(), 1, target.size(), target.size());
+    return trainBatch(input_row, target_row);
+}
+
+template<typename T>
+double BasicNeuralNetwork<T>::train(const std::vector<T>& input, int label) {
+    ConstMatrixView input_row(input.data(), 1, input.size(), input.size());
+    return trainBatch(input_row, &label);
+}
+
+template<typename T>
+double BasicNeuralNetwork<T>::trainBatch(const std::vector<std::vector<T>>& inputs,
+                                         const std::vector<std::vector<T>>& targets) {
+    if (inputs.size() != targets.size()) {
+        throw std::invalid_argument("Input and target batch sizes don't match");
+    }
+    if (inputs.empty()) return 0.0;
+    
+    // 打包为连续的批矩阵
+    Matrix input_batch(inputs.size(), inputs[0].size());
+    Matrix target_batch(targets.size(), targets[0].size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (inputs[i].size() != input_batch.cols() || targets[i].size() != target_batch.cols()) {
+            throw std::invalid_argument("Inconsistent sample size in batch");
+        }
+        std::copy(inputs[i].begin(), inputs[i].end(), input_batch.row(i));
+        std::copy(targets[i].begin(), targets[i].end(), target_batch.row(i));
+    }
+    
+    return trainBatch(input_batch, target_batch);
+}
+
+template<typename T>
+double BasicNeuralNetwork<T>::trainBatch(ConstMatrixView inputs, const TargetView& targets) {
+    if (inputs.rows() != targets.rows()) {
+        throw std::invalid_argument("Input and target batch sizes don't match");
+    }
+    if (inputs.rows() == 0) return 0.0;
+    if (!layers.empty()) {
+        checkTargets(targets, inputs.rows());
+    }
+    
+    // 混合精度训练总是使用工作区（单线程时只有一个分片）
+    size_t num_shards = numShards(inputs.rows());
+    if ((num_shards > 1 || mixed_precision.enabled) && !layers.empty()) {
+        return trainBatchParallel(inputs, targets, num_shards);
+    }
+    
+    // 前向传播
+    ConstMatrixView output = forwardBatch(inputs);
+    double total_loss = batchLoss(output, targets);
+    
+    // 反向传播累积整批梯度，然后每批只更新一次参数
+    backwardBatch(inputs, targets);
+    applyGradients();
+    
+    return total_loss / inputs.rows();
+}
+
+template<typename T>
+size_t BasicNeuralNetwork<T>::numShards(size_t batch_size) const {
+    if (!thread_pool) return 1;
+    
+    // 每个分片至少kMinShardRows个样本，否则线程同步开销超过收益
+    constexpr size_t kMinShardRows = 4;
+    return std::max<size_t>(1, std::min(num_threads, batch_size / kMinShardRows));
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::reserveWorkspace(size_t max_batch_size) {
+    if (layers.empty() || max_batch_size == 0) return;
+    
+    // 单线程路径：各层自己的批缓冲区与输出层梯度（混合精度训练不使用）
+    if (!mixed_precision.enabled) {
+        for (auto& layer : layers) {
+            layer->reserveBuffers(max_batch_size);
+        }
+        output_gradient.resize(max_batch_size, layers.back()->getOutputSize());
+    }
+    
+    // 小批量训练的优化器状态（第一次更新时才分配，这里提前分配）
+    for (size_t i = 0; i < layers.size(); ++i) {
+        optimizer->reserveState(i, *layers[i]);
+    }
+    
+    // 数据并行路径：找出各种批大小下的最大分片数与最大分片行数
+    size_t max_shards = 1;
+    size_t max_shard_rows = 1;
+    for (size_t batch_size = 1; batch_size <= max_batch_size; ++batch_size) {
+        size_t shards = numShards(batch_size);
+        if (shards < 2 && !mixed_precision.enabled) continue;
+        max_shards = std::max(max_shards, shards);
+        max_shard_rows = std::max(max_shard_rows, (batch_size + shards - 1) / shards);
+    }
+    
+    // Hogwild每个线程逐样本训练，工作区至少要覆盖所有线程
+    size_t num_workspaces = std::max(max_shards, thread_pool ? num_threads : size_t(1));
+    workers.resize(num_workspaces);
+    for (auto& worker : workers) {
+        worker.layers.resize(layers.size());
+        worker.optimizer_states.resize(layers.size());
+        if (mixed_precision.enabled) {
+            ensureMixedWorkspace(worker, max_shard_rows);
+        }
+        for (size_t i = 0; i < layers.size(); ++i) {
+            const Layer& layer = *layers[i];
+            if (!mixed_precision.enabled) {
+                worker.layers[i].ensureCapacity(max_shard_rows, layer.getInputSize(), layer.getOutputSize());
+            }
+            optimizer->prepareState(worker.optimizer_states[i], layer);
+        }
+        worker.output_gradient.resize(max_shard_rows, layers.back()->getOutputSize());
+    }
+    reduce_parts.reserve(num_workspaces);
+    
+    prepareContext(predict_context, 1);
+}
+
+template<typename T>
+double BasicNeuralNetwork<T>::trainBatchParallel(ConstMatrixView inputs, const TargetView& targets,
+                                                 size_t num_shards) {
+    ensureInputLayer(inputs.cols());
+    makeWritable();
+    
+    if (workers.size() < num_shards) {
+        workers.resize(num_shards);
+    }
+    for (auto& worker : workers) {
+        worker.layers.resize(layers.size());
+    }
+    
+    // 样本按分片下标连续切分，分片划分只取决于批大小与线程数，与调度无关
+    size_t batch_size = inputs.rows();
+    double scale = 1.0 / batch_size;
+    auto run_shard = [&](size_t shard) {
+        size_t begin = shard * batch_size / num_shards;
+        size_t end = (shard + 1) * batch_size / num_shards;
+        ConstMatrixView shard_inputs = inputs.rowRange(begin, end - begin);
+        TargetView shard_targets = targets.rowRange(begin, end - begin);
+        Workspace& worker = workers[shard];
+        
+        if (mixed_precision.enabled) {
+            worker.loss = forwardBackwardMixed(shard_inputs, shard_targets, scale, worker);
+            return;
+        }
+        
+        ConstMatrixView output = shard_inputs;
+        for (size_t i = 0; i < layers.size(); ++i) {
+            output = layers[i]->forwardBatch(output, worker.layers[i]);
+        }
+        
+        worker.loss = batchLoss(output, shard_targets);
+        
+        // 梯度按整批大小缩放，各分片求和即为整批平均梯度
+        computeOutputGradient(output, shard_targets, scale, worker.output_gradient);
+        ConstMatrixView gradient = worker.output_gradient.view().rowRange(0, end - begin);
+        for (int i = static_cast<int>(layers.size()) - 1; i >= 0; --i) {
+            ConstMatrixView layer_input = i > 0
+                ? worker.layers[i-1].neurons.view().rowRange(0, end - begin)
+                : shard_inputs;
+            gradient = layers[i]->backwardBatch(gradient, layer_input, worker.layers[i], i > 0);
+        }
+    };
+    if (num_shards > 1) {
+        thread_pool->parallelFor(num_shards, run_shard);
+    } else {
+        run_shard(0);
+    }
+    
+    // 按分片顺序归约梯度；每层的输出行在线程间切分
+    std::vector<const LayerBuffers*>& parts = reduce_parts;
+    parts.resize(num_shards);
+    for (size_t i = 0; i < layers.size(); ++i) {
+        for (size_t shard = 0; shard < num_shards; ++shard) {
+            parts[shard] = &workers[shard].layers[i];
+        }
+        Layer& layer = *layers[i];
+        size_t rows = layer.getOutputSize();
+        if (!thread_pool) {
+            layer.reduceGradients(parts, 0, rows);
+            continue;
+        }
+        size_t chunks = std::min(thread_pool->size(), rows);
+        thread_pool->parallelFor(chunks, [&](size_t chunk) {
+            size_t begin = chunk * rows / chunks;
+            size_t end = (chunk + 1) * rows / chunks;
+            layer.reduceGradients(parts, begin, end - begin);
+        });
+    }
+    
+    if (!mixed_precision.enabled || finishLossScaling()) {
+        applyGradients();
+    }
+    
+    double total_loss = 0.0;
+    for (size_t shard = 0; shard < num_shards; ++shard) {
+        total_loss += workers[shard].loss;
+    }
+    return total_loss / batch_size;
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::ensureMixedWorkspace(Workspace& worker, size_t batch_size) const {
+    worker.layers.resize(layers.size());
+    size_t width = 0;
+    for (size_t i = 0; i < layers.size(); ++i) {
+        size_t input_size = layers[i]->getInputSize();
+        size_t output_size = layers[i]->getOutputSize();
+        worker.layers[i].ensureGradients(input_size, output_size);
+        // 输出层的激活值留在暂存区中直接用于反向传播，不需要bf16副本
+        if (i + 1 < layers.size()) {
+            worker.layers[i].ensureStash(batch_size, output_size);
+        }
+        width = std::max(width, std::max(input_size, output_size));
+    }
+    
+    for (Matrix* m : {&worker.scratch_activations[0], &worker.scratch_activations[1],
+                      &worker.scratch_errors, &worker.scratch_gradient}) {
+        if (m->rows() < batch_size || m->cols() < width) {
+            m->resize(std::max(batch_size, m->rows()), width);
+        }
+    }
+}
+
+template<typename T>
+double BasicNeuralNetwork<T>::forwardBackwardMixed(ConstMatrixView inputs, const TargetView& targets, double scale,
+                                                   Workspace& worker) const {
+    size_t batch_size = inputs.rows();
+    ensureMixedWorkspace(worker, batch_size);
+    auto scratch = [batch_size](Matrix& m, size_t cols) {
+        return MatrixView(m.data(), batch_size, cols, m.stride());
+    };
+    
+    // 前向传播：隐藏层的输出存为bf16，下一层读取的也是舍入后的值，与反向传播看到的一致
+    size_t last = layers.size() - 1;
+    ConstMatrixView current = inputs;
+    for (size_t i = 0; i <= last; ++i) {
+        MatrixView output = scratch(worker.scratch_activations[i % 2], layers[i]->getOutputSize());
+        layers[i]->forwardInto(current, output);
+        if (i < last) {
+            encodeRows<T>(output, worker.layers[i].stash);
+            decodeRows<T>(worker.layers[i].stash, output);
+        }
+        current = output;
+    }
+    
+    double loss = batchLoss(current, targets);
+    computeOutputGradient(current, targets, scale * loss_scale, worker.output_gradient);
+    
+    // 反向传播：每层把前一层的激活值（本层输入）由bf16展开到另一块暂存区，下一步作为本层输出使用。
+    // 输入梯度与输出梯度共用暂存区：backwardInto先算完误差项才写输入梯度
+    ConstMatrixView output = current;
+    ConstMatrixView gradient = worker.output_gradient.view().rowRange(0, batch_size);
+    for (size_t i = last + 1; i-- > 0;) {
+        const Layer& layer = *layers[i];
+        ConstMatrixView layer_input = inputs;
+        MatrixView input_gradient;
+        if (i > 0) {
+            MatrixView previous = scratch(worker.scratch_activations[(i - 1) % 2], layer.getInputSize());
+            decodeRows<T>(worker.layers[i - 1].stash, previous);
+            layer_input = previous;
+            input_gradient = scratch(worker.scratch_gradient, layer.getInputSize());
+        }
+        MatrixView errors = scratch(worker.scratch_errors, layer.getOutputSize());
+        layer.backwardInto(gradient, output, layer_input, errors, input_gradient, worker.layers[i]);
+        
+        if (i > 0) {
+            roundRows<T>(input_gradient);
+            gradient = input_gradient;
+            output = layer_input;
+        }
+    }
+    
+    return loss;
+}
+
+template<typename T>
+bool BasicNeuralNetwork<T>::finishLossScaling() {
+    if (loss_scale == 1.0 && !mixed_precision.dynamic_loss_scale) {
+        return true;
+    }
+    
+    bool finite = true;
+    for (auto& layer : layers) {
+        finite &= layer->unscaleGradients(1.0 / loss_scale);
+    }
+    if (!mixed_precision.dynamic_loss_scale) {
+        return true;
+    }
+    
+    // 溢出时跳过本步并减小缩放（不低于1，bf16与float的指数范围相同），持续正常时再增大
+    if (!finite) {
+        loss_scale = std::max(loss_scale * 0.5, 1.0);
+        good_steps = 0;
+        skipped_steps++;
+        return false;
+    }
+    if (++good_steps >= mixed_precision.growth_interval) {
+        loss_scale *= 2.0;
+        good_steps = 0;
+    }
+    return true;
+}
+
+template<typename T>
+double BasicNeuralNetwork<T>::trainHogwild(ConstMatrixView inputs, const TargetView& targets) {
+    if (inputs.rows() != targets.rows()) {
+        throw std::invalid_argument("Input and target batch sizes don't match");
+    }
+    size_t num_samples = inputs.rows();
+    if (num_samples == 0 || layers.empty()) return 0.0;
+    
+    ensureInputLayer(inputs.cols());
+    checkTargets(targets, num_samples);
+    // 各线程并发写参数，须先把引用外部存储的权重复制出来
+    makeWritable();
+    
+    size_t num_workers = std::min(num_threads, num_samples);
+    if (workers.size() < num_workers) {
+        workers.resize(num_workers);
+    }
+    for (auto& worker : workers) {
+        worker.layers.resize(layers.size());
+        worker.optimizer_states.resize(layers.size());
+    }
+    
+    auto run = [&](size_t w) {
+        size_t begin = w * num_samples / num_workers;
+        size_t end = (w + 1) * num_samples / num_workers;
+        Workspace& worker = workers[w];
+        worker.loss = 0.0;
+        
+        for (size_t n = begin; n < end; ++n) {
+            ConstMatrixView input = inputs.rowRange(n, 1);
+            TargetView target = targets.rowRange(n, 1);
+            
+            ConstMatrixView output = input;
+            for (size_t i = 0; i < layers.size(); ++i) {
+                output = layers[i]->forwardBatch(output, worker.layers[i]);
+            }
+            worker.loss += batchLoss(output, target);
+            
+            // 逐层反向：先用当前权重算出传给前一层的梯度，再更新本层
+            computeOutputGradient(output, target, 1.0, worker.output_gradient);
+            ConstMatrixView gradient = worker.output_gradient.view().rowRange(0, 1);
+            for (int i = static_cast<int>(layers.size()) - 1; i >= 0; --i) {
+                const T* layer_input = i > 0 ? worker.layers[i-1].neurons.row(0) : input.row(0);
+                gradient = layers[i]->backpropagate(gradient, worker.layers[i], i > 0);
+                optimizer->updateLayerSample(*layers[i], layer_input, worker.layers[i],
+                                             worker.optimizer_states[i], learning_rate);
+            }
+        }
+    };
+    
+    if (thread_pool && num_workers > 1) {
+        thread_pool->parallelFor(num_workers, run);
+    } else {
+        run(0);
+    }
+    
+    double total_loss = 0.0;
+    for (size_t w = 0; w < num_workers; ++w) {
+        total_loss += workers[w].loss;
+    }
+    return total_loss / num_samples;
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::snapshotParameters(ParameterSnapshot& snapshot) const {
+    snapshot.weights.resize(layers.size());
+    snapshot.biases.resize(layers.size());
+    for (size_t i = 0; i < layers.size(); ++i) {
+        ConstMatrixView w = layers[i]->getWeights();
+        if (snapshot.weights[i].rows() != w.rows() || snapshot.weights[i].cols() != w.cols()) {
+            snapshot.weights[i].resize(w.rows(), w.cols());
+        }
+        snapshot.weights[i].assign(w);
+        snapshot.biases[i] = layers[i]->getBiases();
+    }
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::restoreParameters(const ParameterSnapshot& snapshot) {
+    if (snapshot.weights.size() != layers.size()) {
+        throw std::invalid_argument("Snapshot layer count mismatch");
+    }
+    for (size_t i = 0; i < layers.size(); ++i) {
+        layers[i]->setWeights(snapshot.weights[i]);
+        layers[i]->setBiases(snapshot.biases[i]);
+    }
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::snapshotState(NetworkState& state) const {
+    state.learning_rate = learning_rate;
+    state.loss_type = loss_type;
+    state.optimizer_type = optimizer->getType();
+    state.optimizer_config = optimizer->getConfig();
+    const std::vector<OptimizerState>& optimizer_states = optimizer->getStates();
+    state.layers.resize(layers.size());
+    for (size_t i = 0; i < layers.size(); ++i) {
+        const Layer& layer = *layers[i];
+        typename NetworkState::LayerState& dst = state.layers[i];
+        ConstMatrixView w = layer.getWeights();
+        if (dst.weights.rows() != w.rows() || dst.weights.cols() != w.cols()) {
+            dst.weights.resize(w.rows(), w.cols());
+        }
+        dst.weights.assign(w);
+        dst.biases = layer.getBiases();
+        dst.activation = layer.getActivationType();
+        if (i < optimizer_states.size()) {
+            dst.optimizer = optimizer_states[i];
+        } else {
+            dst.optimizer = OptimizerState();
+        }
+    }
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::restoreState(const NetworkState& state) {
+    std::vector<std::unique_ptr<Layer>> restored;
+    for (size_t i = 0; i < state.layers.size(); ++i) {
+        const typename NetworkState::LayerState& src = state.layers[i];
+        if (src.biases.size() != src.weights.rows() ||
+            (i > 0 && src.weights.cols() != state.layers[i-1].weights.rows())) {
+            throw std::invalid_argument("Network state dimension mismatch");
+        }
+        auto layer = ::make_unique<Layer>(src.weights.cols(), src.weights.rows(), src.activation, rng);
+        layer->setWeights(src.weights);
+        layer->setBiases(src.biases);
+        restored.push_back(std::move(layer));
+    }
+    
+    layers = std::move(restored);
+    loss_type = state.loss_type;
+    setOptimizer(state.optimizer_type, state.learning_rate, state.optimizer_config);
+    std::vector<OptimizerState> optimizer_states;
+    optimizer_states.reserve(state.layers.size());
+    for (const auto& src : state.layers) {
+        optimizer_states.push_back(src.optimizer);
+    }
+    optimizer->setStates(std::move(optimizer_states));
+}
+
+template<typename T>
+std::vector<T> BasicNeuralNetwork<T>::predict(const std::vector<T>& input) {
+    if (layers.empty()) {
+        return input;
+    }
+    
+    ensureInputLayer(input.size());
+    
+    ConstMatrixView output = predict(input, predict_context);
+    return std::vector<T>(output.row(0), output.row(0) + output.cols());
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::prepareContext(InferenceContext& ctx, size_t batch_size) const {
+    ctx.activations.resize(layers.size());
+    for (size_t i = 0; i < layers.size(); ++i) {
+        Matrix& a = ctx.activations[i];
+        size_t output_size = layers[i]->getOutputSize();
+        if (a.rows() < batch_size || a.cols() != output_size) {
+            a.resize(std::max(batch_size, a.rows()), output_size);
+        }
+    }
+}
+
+template<typename T>
+BasicMatrixView<const T> BasicNeuralNetwork<T>::predict(ConstMatrixView inputs, InferenceContext& ctx) const {
+    if (layers.empty()) {
+        return inputs;
+    }
+    
+    // 只读访问各层参数，中间结果全部写入ctx
+    prepareContext(ctx, inputs.rows());
+    ConstMatrixView current = inputs;
+    for (size_t i = 0; i < layers.size(); ++i) {
+        MatrixView output = ctx.activations[i].view().rowRange(0, inputs.rows());
+        layers[i]->forwardInto(current, output);
+        current = output;
+    }
+    
+    return current;
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::predictBatch(ConstMatrixView inputs, MatrixView outputs) const {
+    if (layers.empty()) {
+        throw std::invalid_argument("Network has no layers");
+    }
+    if (outputs.rows() != inputs.rows() || outputs.cols() != layers.back()->getOutputSize()) {
+        throw std::invalid_argument("Output buffer size mismatch");
+    }
+    
+    // 每块的中间激活（256 x 128 约256KB）可常驻L2
+    constexpr size_t kChunkRows = 256;
+    size_t num_samples = inputs.rows();
+    size_t num_chunks = (num_samples + kChunkRows - 1) / kChunkRows;
+    size_t num_tasks = thread_pool ? std::min(thread_pool->size(), num_chunks) : 1;
+    
+    // 每个任务一个推理上下文，按步长领取块
+    std::vector<InferenceContext> contexts(num_tasks);
+    auto run = [&](size_t task) {
+        InferenceContext& ctx = contexts[task];
+        for (size_t chunk = task; chunk < num_chunks; chunk += num_tasks) {
+            size_t begin = chunk * kChunkRows;
+            size_t count = std::min(kChunkRows, num_samples - begin);
+            ConstMatrixView result = predict(inputs.rowRange(begin, count), ctx);
+            for (size_t b = 0; b < count; ++b) {
+                std::copy(result.row(b), result.row(b) + result.cols(), outputs.row(begin + b));
+            }
+        }
+    };
+    
+    if (num_tasks > 1) {
+        thread_pool->parallelFor(num_tasks, run);
+    } else if (num_chunks > 0) {
+        run(0);
+    }
+}
+
+template<typename T>
+BasicMatrixView<const T> BasicNeuralNetwork<T>::predict(const std::vector<T>& input, InferenceContext& ctx) const {
+    return predict(ConstMatrixView(input.data(), 1, input.size(), input.size()), ctx);
+}
+
+template<typename T>
+std::vector<T> BasicNeuralNetwork<T>::getHiddenLayerOutput(const std::vector<T>& input) {
+    if (layers.empty()) return {};
+    
+    // 确保第一层已正确初始化
+    ensureInputLayer(input.size());
+    
+    // 只通过第一层
+    return layers[0]->forward(input);
+}
+
+template<typename T>
+double BasicNeuralNetwork<T>::sampleLoss(const T* predicted, const T* target, size_t n) const {
+    if (loss_type == LossType::CROSS_ENTROPY) {
+        return crossEntropyLoss(predicted, target, n);
+    } else {
+        // 均方误差
+        double loss = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double diff = predicted[i] - target[i];
+            loss += diff * diff;
+        }
+        return loss / (2.0 * n); // 除以样本数量
+    }
+}
+
+template<typename T>
+double BasicNeuralNetwork<T>::sampleLoss(const T* predicted, int label, size_t n) const {
+    // 与one-hot目标的结果相同，只是跳过目标为0的项
+    if (loss_type == LossType::CROSS_ENTROPY) {
+        const double epsilon = 1e-15;
+        return -std::log(std::max(epsilon, std::min(1.0 - epsilon, static_cast<double>(predicted[label]))));
+    } else {
+        double loss = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double diff = predicted[i] - (static_cast<size_t>(label) == i ? 1.0 : 0.0);
+            loss += diff * diff;
+        }
+        return loss / (2.0 * n);
+    }
+}
+
+template<typename T>
+double BasicNeuralNetwork<T>::calculateLoss(const std::vector<T>& predicted,
+                                            const std::vector<T>& target) {
+    return sampleLoss(predicted.data(), target.data(), predicted.size());
+}
+
+template<typename T>
+double BasicNeuralNetwork<T>::calculateCrossEntropyLoss(const std::vector<T>& predicted,
+                                                        const std::vector<T>& target) {
+    return crossEntropyLoss(predicted.data(), target.data(), predicted.size());
+}
+
+// 在Layer类实现中添加：
+template<typename T>
+ActivationType BasicLayer<T>::getActivationType() const {
+    return activation_type;
+}
+
+template<typename T>
+bool BasicNeuralNetwork<T>::saveModel(const std::string& filename) const {
+    using namespace model_format;
+    
+    // 先写临时文件，完整写入后再替换目标文件
+    std::string temp_path = filename + ".tmp";
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Cannot open file for saving: " << temp_path << std::endl;
+        return false;
+    }
+    
+    try {
+        std::cout << "Saving model to: " << filename << std::endl;
+        
+        Header header;
+        header.num_layers = static_cast<uint32_t>(layers.size());
+        header.learning_rate = learning_rate;
+        header.loss_type = static_cast<uint32_t>(loss_type);
+        header.optimizer_type = static_cast<uint32_t>(optimizer->getType());
+        
+        // 计算布局：文件头与层记录之后，各层的权重与偏置依次按64字节对齐存放
+        std::vector<LayerRecord> records(layers.size());
+        uint64_t offset = kHeaderSize + kLayerRecordSize * layers.size();
+        for (size_t i = 0; i < layers.size(); ++i) {
+            ConstMatrixView weights = layers[i]->getWeights();
+            LayerRecord& record = records[i];
+            record.activation = static_cast<uint32_t>(layers[i]->getActivationType());
+            record.dtype = dataTypeOf<T>();
+            record.rows = weights.rows();
+            record.cols = weights.cols();
+            record.stride = Matrix::paddedStride(weights.cols());
+            record.weights_offset = alignUp(offset);
+            offset = record.weights_offset + record.rows * record.stride * sizeof(T);
+            record.biases_offset = alignUp(offset);
+            offset = record.biases_offset + record.rows * sizeof(T);
+        }
+        header.file_size = offset;
+        
+        // 顺序写出并累积CRC（跳过CRC字段），最后回填CRC
+        uint32_t crc = 0;
+        uint64_t written = 0;
+        auto emit = [&](const unsigned char* data, size_t size) {
+            file.write(reinterpret_cast<const char*>(data), size);
+            crc = crc32Update(crc, data, size);
+            written += size;
+        };
+        auto padTo = [&](uint64_t target) {
+            static const unsigned char zeros[kAlignment] = {};
+            emit(zeros, static_cast<size_t>(target - written));
+        };
+        
+        unsigned char block[kHeaderSize];
+        encodeHeader(header, block);
+        file.write(reinterpret_cast<const char*>(block), kHeaderSize);
+        crc = crc32Update(crc, block, kCrcOffset);
+        written = kHeaderSize;
+        for (const LayerRecord& record : records) {
+            encodeLayerRecord(record, block);
+            emit(block, kLayerRecordSize);
+        }
+        
+        std::vector<unsigned char> buffer;
+        for (size_t i = 0; i < layers.size(); ++i) {
+            ConstMatrixView weights = layers[i]->getWeights();
+            const std::vector<T>& biases = layers[i]->getBiases();
+            const LayerRecord& record = records[i];
+            
+            std::cout << "Layer " << i << ": " << record.cols << "->" << record.rows
+                      << " (activation: " << record.activation << ", "
+                      << dataTypeName(record.dtype) << ")" << std::endl;
+            
+            // 权重逐行写出，行尾补0到stride
+            padTo(record.weights_offset);
+            buffer.assign(record.stride * sizeof(T), 0);
+            for (size_t r = 0; r < weights.rows(); ++r) {
+                const T* w = weights.row(r);
+                for (size_t j = 0; j < weights.cols(); ++j) {
+                    storeScalar(buffer.data() + j * sizeof(T), w[j]);
+                }
+                emit(buffer.data(), buffer.size());
+            }
+            
+            padTo(record.biases_offset);
+            buffer.resize(biases.size() * sizeof(T));
+            for (size_t j = 0; j < biases.size(); ++j) {
+                storeScalar(buffer.data() + j * sizeof(T), biases[j]);
+            }
+            emit(buffer.data(), buffer.size());
+        }
+        
+        storeU32(block, crc);
+        file.seekp(kCrcOffset);
+        file.write(reinterpret_cast<const char*>(block), 4);
+        file.close();
+        if (!file) {
+            std::cerr << "Error: Failed to write model file: " << temp_path << std::endl;
+            std::remove(temp_path.c_str());
+            return false;
+        }
+        if (!replaceFile(temp_path, filename)) {
+            std::cerr << "Error: Cannot replace model file: " << filename << std::endl;
+            std::remove(temp_path.c_str());
+            return false;
+        }
+        
+        std::cout << "Model saved successfully! (format v" << kVersion << ", "
+                  << header.file_size << " bytes)" << std::endl;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error saving model: " << e.what() << std::endl;
+        file.close();
+        std::remove(temp_path.c_str());
+        return false;
+    }
+}
+
+template<typename T>
+bool BasicNeuralNetwork<T>::loadModel(const std::string& filename) {
+    // 优先映射到内存：新格式的权重直接引用映射（大端序主机上解码复制），旧格式改用流读取
+    auto mapping = std::make_shared<MappedFile>();
+    if (mapping->open(filename)) {
+        if (!model_format::hasMagic(mapping->data(), mapping->size())) {
+            mapping.reset();
+            return loadLegacyModel(filename);
+        }
+        std::cout << "Loading model from: " << filename << std::endl;
+        std::shared_ptr<const void> storage;
+        if (model_format::hostIsLittleEndian()) {
+            storage = mapping;
+        }
+        return loadVersionedModel(mapping->data(), mapping->size(), storage);
+    }
+    
+    // 无法映射时整个读入内存后解码
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        std::cerr << "Error: Cannot open file for loading: " << filename << std::endl;
+        return false;
+    }
+    std::vector<unsigned char> contents(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(contents.data()), contents.size());
+    if (!file) {
+        std::cerr << "Error: Failed to read model file: " << filename << std::endl;
+        return false;
+    }
+    file.close();
+    if (!model_format::hasMagic(contents.data(), contents.size())) {
+        return loadLegacyModel(filename);
+    }
+    std::cout << "Loading model from: " << filename << std::endl;
+    return loadVersionedModel(contents.data(), contents.size(), nullptr);
+}
+
+template<typename T>
+bool BasicNeuralNetwork<T>::loadVersionedModel(const unsigned char* data, size_t size,
+                                               std::shared_ptr<const void> storage) {
+    using namespace model_format;
+    
+    std::string error;
+    Header header;
+    if (!decodeHeader(data, size, header, error)) {
+        std::cerr << "Error loading model: " << error << std::endl;
+        return false;
+    }
+    if (header.loss_type > static_cast<uint32_t>(LossType::CROSS_ENTROPY) ||
+        header.optimizer_type > static_cast<uint32_t>(OptimizerType::LAMB)) {
+        std::cerr << "Error loading model: Invalid training configuration" << std::endl;
+        return false;
+    }
+    
+    // 全部层校验通过后才替换当前网络
+    std::vector<std::unique_ptr<Layer>> loaded;
+    bool converted = false;
+    bool mapped = false;
+    for (size_t i = 0; i < header.num_layers; ++i) {
+        LayerRecord record = decodeLayerRecord(data + kHeaderSize + i * kLayerRecordSize);
+        if (!checkLayerRecord(record, size, error)) {
+            std::cerr << "Error loading model: Layer " << i << ": " << error << std::endl;
+            return false;
+        }
+        if (record.activation > static_cast<uint32_t>(ActivationType::SOFTMAX)) {
+            std::cerr << "Error loading model: Layer " << i << ": Invalid activation type" << std::endl;
+            return false;
+        }
+        if (record.dtype == DataType::INT8) {
+            std::cerr << "Error loading model: Layer " << i
+                      << ": int8 quantized model, load it with QuantizedNetwork" << std::endl;
+            return false;
+        }
+        if (!loaded.empty() && record.cols != loaded.back()->getOutputSize()) {
+            std::cerr << "Error loading model: Layer " << i << ": Dimension mismatch" << std::endl;
+            return false;
+        }
+        
+        size_t rows = static_cast<size_t>(record.rows);
+        size_t cols = static_cast<size_t>(record.cols);
+        size_t stride = static_cast<size_t>(record.stride);
+        ActivationType activation = static_cast<ActivationType>(record.activation);
+        std::cout << "Layer " << i << ": " << cols << "->" << rows
+                  << " (activation: " << record.activation << ", "
+                  << dataTypeName(record.dtype) << ")" << std::endl;
+        
+        // 文件精度与本网络相同时按原样读取，否则逐元素转换
+        size_t element_size = dataTypeSize(record.dtype);
+        bool same_type = record.dtype == dataTypeOf<T>();
+        if (!same_type) {
+            converted = true;
+        }
+        
+        const unsigned char* bias_data = data + record.biases_offset;
+        std::vector<T> biases(rows);
+        for (size_t j = 0; j < rows; ++j) {
+            biases[j] = static_cast<T>(loadScalar(bias_data + j * element_size, record.dtype));
+        }
+        
+        const unsigned char* weight_data = data + record.weights_offset;
+        if (storage && same_type) {
+            // 零拷贝：文件中的权重布局与Matrix一致，映射后就地使用
+            ConstMatrixView weights(reinterpret_cast<const T*>(weight_data), rows, cols, stride);
+            loaded.push_back(::make_unique<Layer>(weights, std::move(biases), activation, storage));
+            mapped = true;
+        } else {
+            auto weights = std::make_shared<Matrix>(rows, cols);
+            for (size_t r = 0; r < rows; ++r) {
+                const unsigned char* src = weight_data + r * stride * element_size;
+                T* dst = weights->row(r);
+                for (size_t j = 0; j < cols; ++j) {
+                    dst[j] = static_cast<T>(loadScalar(src + j * element_size, record.dtype));
+                }
+            }
+            ConstMatrixView view = weights->view();
+            loaded.push_back(::make_unique<Layer>(view, std::move(biases), activation, std::move(weights)));
+        }
+    }
+    
+    layers = std::move(loaded);
+    loss_type = static_cast<LossType>(header.loss_type);
+    OptimizerType opt_type = static_cast<OptimizerType>(header.optimizer_type);
+    setOptimizer(opt_type, header.learning_rate);
+    
+    std::cout << "Model loaded successfully! (format v" << header.version
+              << (mapped ? ", memory-mapped" : "")
+              << (converted ? std::string(", converted to ") + dataTypeName(dataTypeOf<T>()) : "")
+              << ")" << std::endl;
+    std::cout << "Learning rate: " << learning_rate << std::endl;
+    std::cout << "Loss type: " << (loss_type == LossType::CROSS_ENTROPY ? "Cross-Entropy" : "MSE") << std::endl;
+    std::cout << "Optimizer: " << optimizerTypeName(opt_type) << std::endl;
+    return true;
+}
+
+// 旧格式：按主机字节序直接写出的size_t/枚举/double，没有魔数与版本
+template<typename T>
+bool BasicNeuralNetwork<T>::loadLegacyModel(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Cannot open file for loading: " << filename << std::endl;
+        return false;
+    }
+    
+    try {
+        std::cout << "Loading legacy model from: " << filename << std::endl;
+        
+        // 读取网络配置
+        file.read(reinterpret_cast<char*>(&learning_rate), sizeof(learning_rate));
+        file.read(reinterpret_cast<char*>(&loss_type), sizeof(loss_type));
+        
+        // 读取优化器类型并设置
+        OptimizerType opt_type;
+        file.read(reinterpret_cast<char*>(&opt_type), sizeof(opt_type));
+        
+        // 读取层数
+        size_t num_layers;
+        file.read(reinterpret_cast<char*>(&num_layers), sizeof(num_layers));
+        std::cout << "Loading " << num_layers << " layers..." << std::endl;
+        
+        layers.clear();
+        
+        for (size_t layer_idx = 0; layer_idx < num_layers; ++layer_idx) {
+            // 读取激活函数类型
+            ActivationType activation;
+            file.read(reinterpret_cast<char*>(&activation), sizeof(activation));
+            
+            // 读取维度
+            size_t rows, cols;
+            file.read(reinterpret_cast<char*>(&rows), sizeof(rows));
+            file.read(reinterpret_cast<char*>(&cols), sizeof(cols));
+            
+            std::cout << "Layer " << layer_idx << ": " << cols << "->" << rows 
+                      << " (activation: " << static_cast<int>(activation) << ")" << std::endl;
+            
+            // 创建层时使用正确的激活函数类型
+            auto layer = make_unique<Layer>(cols, rows, activation);
+            
+            // 读取权重（文件中为double），逐行转换后写入层的连续存储
+            MatrixView weights = layer->getWeightsView();
+            std::vector<double> row(cols);
+            for (size_t r = 0; r < rows; ++r) {
+                file.read(reinterpret_cast<char*>(row.data()), 
+                         cols * sizeof(double));
+                std::copy(row.begin(), row.end(), weights.row(r));
+            }
+            
+            // 读取偏置
+            std::vector<double> biases(rows);
+            file.read(reinterpret_cast<char*>(biases.data()), 
+                     biases.size() * sizeof(double));
+            
+            layer->setBiases(std::vector<T>(biases.begin(), biases.end()));
+            
+            layers.push_back(std::move(layer));
+        }
+        
+        // 恢复优化器设置
+        setOptimizer(opt_type, learning_rate);
+        
+        file.close();
+        std::cout << "Model loaded successfully!" << std::endl;
+        std::cout << "Learning rate: " << learning_rate << std::endl;
+        std::cout << "Loss type: " << (loss_type == LossType::CROSS_ENTROPY ? "Cross-Entropy" : "MSE") << std::endl;
+        std::cout << "Optimizer: " << optimizerTypeName(opt_type) << std::endl;
+        
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading model: " << e.what() << std::endl;
+        file.close();
+        return false;
+    }
+}
+
+template<typename T>
+void BasicNeuralNetwork<T>::printNetworkInfo() const {
+    std::cout << "Neural Network Information:" << std::endl;
+    std::cout << "Number of layers: " << layers.size() << std::endl;
+    std::cout << "Learning rate: " << learning_rate << std::endl;
+    std::cout << "Loss function: " << (loss_type == LossType::CROSS_ENTROPY ? "Cross-Entropy" : "Mean Squared Error") << std::endl;
+    
+    if (optimizer) {
+        std::cout << "Optimizer: " << optimizerTypeName(optimizer->getType()) << std::endl;
+    }
+    std::cout << "Precision: " << model_format::dataTypeName(model_format::dataTypeOf<T>()) << std::endl;
+    std::cout << "SIMD: " << simd::isaName(simd::kernels<T>().isa) << std::endl;
+    
+    for (size_t i = 0; i < layers.size(); ++i) {
+        std::cout << "Layer " << i << ": " 
+                  << layers[i]->getInputSize() << " -> " 
+                  << layers[i]->getOutputSize() << " neurons" << std::endl;
+    }
+}
+
+// ========== 显式实例化 ==========
+template class BasicActivationFunction<float>;
+template class BasicActivationFunction<double>;
+template struct BasicLayerBuffers<float>;
+template struct BasicLayerBuffers<double>;
+template struct BasicOptimizerState<float>;
+template struct BasicOptimizerState<double>;
+template class BasicLayer<float>;
+template class BasicLayer<double>;
+template class BasicOptimizer<float>;
+template class BasicOptimizer<double>;
+template class BasicSGDOptimizer<float>;
+template class BasicSGDOptimizer<double>;
+template class BasicMomentumOptimizer<float>;
+template class BasicMomentumOptimizer<double>;
+template class BasicRmsPropOptimizer<float>;
+template class BasicRmsPropOptimizer<double>;
+template class BasicAdamOptimizer<float>;
+template class BasicAdamOptimizer<double>;
+template class BasicLambOptimizer<float>;
+template class BasicLambOptimizer<double>;
+template class BasicNeuralNetwork<float>;
+template class BasicNeuralNetwork<double>;
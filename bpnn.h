@@ -5,6 +5,10 @@
 #include <functional>
 #include <memory>
 #include <chrono>
+#include <random>
+#include "matrix.h"
+
+class ThreadPool;
 
 // 激活函数类型
 enum class ActivationType {
@@ -19,134 +23,667 @@ enum class LossType {
     CROSS_ENTROPY
 };
 
-// 优化器类型
+// 优化器类型（数值写入模型文件与检查点，只能在末尾追加）
 enum class OptimizerType {
     SGD,
-    ADAM
+    ADAM,
+    MOMENTUM,
+    NESTEROV,
+    RMSPROP,
+    ADAMW,
+    LAMB
+};
+
+// 优化器名称，用于打印
+const char* optimizerTypeName(OptimizerType type);
+
+// 优化器的超参数，各优化器只使用与自己相关的项
+struct OptimizerConfig {
+    double momentum = 0.9;       // 动量与Nesterov
+    double beta1 = 0.9;          // Adam、AdamW、LAMB的一阶/二阶矩衰减率
+    double beta2 = 0.999;
+    double rho = 0.99;           // RMSProp平方梯度的衰减率
+    double epsilon = 1e-8;       // Adam系与RMSProp分母中的小常数
+    double weight_decay = 0.01;  // AdamW与LAMB的解耦权重衰减，不作用于偏置
 };
 
+// 网络的各个部分都以标量类型T（float或double）为模板参数，实现在bpnn.cpp中对两种类型显式实例化。
+// 参数、激活值、梯度与优化器状态都以T存储并以T计算；学习率等超参数与损失值仍为double。
+// 类模板内的Matrix、MatrixView、ConstMatrixView等类型名均指元素类型为T的版本
+
 // ========== 激活函数类 ==========
-class ActivationFunction {
-public:
-    static double sigmoid(double x);
-    static double sigmoidDerivative(double x);
-    static double relu(double x);
-    static double reluDerivative(double x);
-    static std::vector<double> softmax(const std::vector<double>& x);
-    static std::vector<double> softmaxDerivative(const std::vector<double>& x, size_t index);
-    
-    static std::function<double(double)> getActivation(ActivationType type);
-    static std::function<double(double)> getDerivative(ActivationType type);
-    static std::function<std::vector<double>(const std::vector<double>&)> 
+template<typename T>
+class BasicActivationFunction {
+public:
+    static T sigmoid(T x);
+    static T sigmoidDerivative(T x);
+    static T relu(T x);
+    static T reluDerivative(T x);
+    static std::vector<T> softmax(const std::vector<T>& x);
+    static std::vector<T> softmaxDerivative(const std::vector<T>& x, size_t index);
+    
+    static std::function<T(T)> getActivation(ActivationType type);
+    static std::function<T(T)> getDerivative(ActivationType type);
+    static std::function<std::vector<T>(const std::vector<T>&)>
            getVectorActivation(ActivationType type);
+    
+    // 对长度为n的一行原地施加激活（向量化），用于量化推理等自行计算加权和的场合
+    static void applyInPlace(ActivationType type, T* x, size_t n);
+};
+
+// ========== 层缓冲区 ==========
+// 小批量前向/反向传播的中间结果与梯度（每行一个样本，行数按需增长）；
+// 数据并行训练时每个工作线程持有一份，互不干扰
+template<typename T>
+struct BasicLayerBuffers {
+    using Matrix = BasicMatrix<T>;
+
+    Matrix neurons;          // batch x output_size
+    Matrix errors;           // batch x output_size
+    Matrix input_gradient;   // batch x input_size
+    
+    // 批内平均后的梯度
+    Matrix grad_weights;     // output_size x input_size
+    std::vector<T> grad_biases;
+    
+    // 混合精度训练时本层输出的bf16副本，此时上面的neurons等批缓冲区不分配
+    BasicMatrix<uint16_t> stash;  // batch x output_size
+    
+    void ensureCapacity(size_t batch_size, size_t input_size, size_t output_size);
+    void ensureGradients(size_t input_size, size_t output_size);
+    void ensureStash(size_t batch_size, size_t output_size);
+};
+
+// 一层的优化器状态：若干份与权重、偏置同形状的缓冲区（动量的速度、Adam的一阶/二阶矩等），
+// 份数由优化器决定，SGD没有状态
+template<typename T>
+struct BasicOptimizerState {
+    using Matrix = BasicMatrix<T>;
+
+    std::vector<Matrix> weight_slots;  // 每份 output_size x input_size
+    std::vector<std::vector<T>> bias_slots;
+    int timestep = 0;
+    std::vector<double> scratch;  // 更新时的临时数据（如LAMB逐行的范数平方），不保存到检查点
+    
+    size_t slots() const { return weight_slots.size(); }
+    // 份数或形状不符时重新分配为0并把步数清零
+    void ensureShape(size_t slots, size_t input_size, size_t output_size);
+};
+
+// 优化器一次更新的对象：一层可写的权重、偏置及对应的梯度
+template<typename T>
+struct BasicParameterBlock {
+    BasicMatrixView<T> weights;
+    T* biases;
+    BasicMatrixView<const T> grad_weights;
+    const T* grad_biases;
 };
 
 // ========== 层类 ==========
-class Layer {
+template<typename T>
+class BasicLayer {
+public:
+    using Matrix = BasicMatrix<T>;
+    using MatrixView = BasicMatrixView<T>;
+    using ConstMatrixView = BasicMatrixView<const T>;
+    using LayerBuffers = BasicLayerBuffers<T>;
+    using ParameterBlock = BasicParameterBlock<T>;
+
 private:
-    std::vector<std::vector<double>> weights;
-    std::vector<double> biases;
-    std::vector<double> neurons;
-    std::vector<double> weighted_sums;
-    std::vector<double> errors;
+    Matrix weights;  // output_size x input_size，行主序连续存储
+    // 权重也可以直接引用外部的只读存储（如映射到内存的模型文件），此时weights为空，
+    // external_storage保证存储有效；第一次修改参数前复制到weights
+    ConstMatrixView external_weights;
+    std::shared_ptr<const void> external_storage;
+    std::vector<T> biases;
+    std::vector<T> neurons;
+    std::vector<T> errors;
+    std::vector<T> input_gradient;
     ActivationType activation_type;
     
-    // Adam优化器参数
-    std::vector<std::vector<double>> m_weights, v_weights;
-    std::vector<double> m_biases, v_biases;
-    int timestep;
+    // 按激活类型在构造时选定的内核
+    void (*forward_kernel)(ConstMatrixView w, const T* b, const T* x, T* a);
+    void (*activate_kernel)(T* a, size_t n);
+    void (*error_kernel)(const T* g, const T* a, T* e, size_t n);
+    
+    // 单线程路径的批缓冲区；其中的梯度由优化器消费
+    LayerBuffers buffers;
+    
+    void selectKernels();
 
 public:
-    Layer(size_t input_size, size_t output_size, ActivationType activation = ActivationType::SIGMOID);
+    BasicLayer(size_t input_size, size_t output_size, ActivationType activation = ActivationType::SIGMOID);
+    BasicLayer(size_t input_size, size_t output_size, ActivationType activation, std::mt19937& gen);
+    // 直接使用外部只读存储中的权重，不复制；storage在层的生命周期内持有该存储。
+    // 训练用的梯度与优化器缓冲区推迟到makeWritable时分配
+    BasicLayer(ConstMatrixView weights, std::vector<T> biases, ActivationType activation,
+               std::shared_ptr<const void> storage);
+    
+    // 权重引用外部存储时复制为自有存储，并分配训练缓冲区；修改参数前调用
+    void makeWritable();
+    bool usesExternalWeights() const { return external_storage != nullptr; }
     
     void initializeWeights();
-    std::vector<double> forward(const std::vector<double>& input);
-    std::vector<double> backward(const std::vector<double>& gradient);
+    void initializeWeights(std::mt19937& gen);
+    // 单样本接口：结果写入层内缓冲区并返回其引用（在下次调用前有效）
+    const std::vector<T>& forward(const std::vector<T>& input);
+    const std::vector<T>& backward(const std::vector<T>& gradient);
+    
+    // 小批量接口：input为 batch x input_size，返回 batch x output_size 的激活值
+    ConstMatrixView forwardBatch(ConstMatrixView input);
+    // 根据输出梯度计算并累积权重梯度；propagate为false时不计算输入梯度（用于第一层）
+    ConstMatrixView backwardBatch(ConstMatrixView gradient, ConstMatrixView input, bool propagate = true);
+    
+    // 使用外部缓冲区的版本，只读访问本层参数，可在多个线程中同时调用
+    ConstMatrixView forwardBatch(ConstMatrixView input, LayerBuffers& buf) const;
+    // 前向传播写入调用者提供的 batch x output_size 缓冲区
+    void forwardInto(ConstMatrixView input, MatrixView output) const;
+    ConstMatrixView backwardBatch(ConstMatrixView gradient, ConstMatrixView input,
+                                  LayerBuffers& buf, bool propagate) const;
+    
+    // 将各份缓冲区中的梯度按给定顺序求和，写入本层梯度的 [first_row, first_row + count) 行
+    void reduceGradients(const std::vector<const LayerBuffers*>& parts, size_t first_row, size_t count);
+    
+    // 预先分配单线程路径的批缓冲区
+    void reserveBuffers(size_t batch_size) { buffers.ensureCapacity(batch_size, getInputSize(), getOutputSize()); }
+    
+    // 只计算误差项与输入梯度，不累积权重梯度（用于Hogwild的单样本直接更新）
+    ConstMatrixView backpropagate(ConstMatrixView gradient, LayerBuffers& buf, bool propagate) const;
+    // 反向传播的一般形式：output为本层的激活值，误差项写入errors，输入梯度写入input_gradient
+    // （为空视图时不计算），整批的权重与偏置梯度写入buf。各缓冲区由调用者提供
+    void backwardInto(ConstMatrixView gradient, ConstMatrixView output, ConstMatrixView input,
+                      MatrixView errors, MatrixView input_gradient, LayerBuffers& buf) const;
     
-    void updateWeightsSGD(const std::vector<double>& input, double learning_rate);
-    void updateWeightsAdam(const std::vector<double>& input, double learning_rate,
-                          double beta1 = 0.9, double beta2 = 0.999, double epsilon = 1e-8);
+    // 梯度乘以factor（撤销损失缩放），返回梯度是否全部为有限值
+    bool unscaleGradients(double factor);
+    
+    // 交给优化器的参数与backwardBatch累积的梯度（先调用makeWritable）
+    ParameterBlock parameterBlock() { makeWritable(); return parameterBlock(buffers); }
+    // 参数与buf中的梯度；权重须已可写（Hogwild各线程共用参数、各用自己的梯度）
+    ParameterBlock parameterBlock(const LayerBuffers& buf);
+    
+    // Hogwild单样本：delta为该样本的误差项，input为该层输入。
+    // sampleGradients把梯度 δxᵀ 与 δ 写入buf；applySampleSGD直接更新共享参数（不加锁），
+    // 跳过input中的零元素
+    void sampleGradients(const T* delta, const T* input, LayerBuffers& buf) const;
+    void applySampleSGD(const T* delta, const T* input, double learning_rate);
     
     // Getters
-    size_t getInputSize() const { return weights.empty() ? 0 : weights[0].size(); }
-    size_t getOutputSize() const { return weights.size(); }
-    const std::vector<double>& getNeurons() const { return neurons; }
-    const std::vector<double>& getErrors() const { return errors; }
-    const std::vector<std::vector<double>>& getWeights() const { return weights; }
-    const std::vector<double>& getBiases() const { return biases; }
+    size_t getInputSize() const { return getWeights().cols(); }
+    size_t getOutputSize() const { return getWeights().rows(); }
+    const std::vector<T>& getNeurons() const { return neurons; }
+    const std::vector<T>& getErrors() const { return errors; }
+    ConstMatrixView getBatchNeurons(size_t batch_size) const { return buffers.neurons.view().rowRange(0, batch_size); }
+    ConstMatrixView getWeights() const { return external_storage ? external_weights : weights.view(); }
+    MatrixView getWeightsView() { makeWritable(); return weights.view(); }
+    const std::vector<T>& getBiases() const { return biases; }
     
     // Setters
-    void setWeights(const std::vector<std::vector<double>>& w) { weights = w; }
-    void setBiases(const std::vector<double>& b) { biases = b; }
+    void setWeights(ConstMatrixView w) { makeWritable(); weights.assign(w); }
+    void setBiases(const std::vector<T>& b) { biases = b; }
 
     ActivationType getActivationType() const;
 };
 
 // ========== 优化器基类 ==========
-class Optimizer {
+// 各层的状态由优化器持有，第一次更新某层时才按stateSlots()分配。
+// 子类的apply对参数逐行调用simd中融合的更新内核（每个元素的参数、梯度与状态各读写一次），
+// 大层按行分块在线程池上并行；行之间互不相关，结果与线程数无关
+template<typename T>
+class BasicOptimizer {
 public:
-    virtual ~Optimizer() = default;
-    virtual void updateLayer(Layer* layer, const std::vector<double>& input, double learning_rate) = 0;
+    using Layer = BasicLayer<T>;
+    using LayerBuffers = BasicLayerBuffers<T>;
+    using State = BasicOptimizerState<T>;
+    using ParameterBlock = BasicParameterBlock<T>;
+
+    explicit BasicOptimizer(const OptimizerConfig& config) : config(config) {}
+    virtual ~BasicOptimizer() = default;
+    
     virtual OptimizerType getType() const = 0;
+    // 每个参数需要的状态份数：SGD为0，动量、Nesterov与RMSProp为1，Adam、AdamW与LAMB为2
+    virtual size_t stateSlots() const = 0;
+    // 一层更新时需要的临时空间（double个数），output_size为该层的输出维度
+    virtual size_t scratchSize(size_t output_size) const { (void)output_size; return 0; }
+    const OptimizerConfig& getConfig() const { return config; }
+    
+    // 按本优化器的需要为layer分配状态（份数或形状不符时重建为0）与临时空间
+    void prepareState(State& state, const Layer& layer) const;
+    // 预先分配第index层的状态，之后的updateLayer不再分配内存
+    void reserveState(size_t index, const Layer& layer) { layerState(index, layer); }
+    
+    // 用第index层累积的梯度更新其参数。pool为网络的线程池（单线程时为空）
+    void updateLayer(size_t index, Layer& layer, double learning_rate, ThreadPool* pool);
+    // Hogwild训练中的单样本更新：buf中已有该样本的误差项，input为该层输入，
+    // state为调用线程私有的优化器状态
+    virtual void updateLayerSample(Layer& layer, const T* input, LayerBuffers& buf,
+                                   State& state, double learning_rate);
+    
+    // 各层的状态（下标与层对应），用于检查点；尚未更新过的层状态为空
+    const std::vector<State>& getStates() const { return states; }
+    void setStates(std::vector<State> layer_states) { states = std::move(layer_states); }
+
+protected:
+    OptimizerConfig config;
+    
+    // 对一层参数执行一次更新，state已按stateSlots()分配
+    virtual void apply(const ParameterBlock& params, State& state, double learning_rate, ThreadPool* pool) = 0;
+
+private:
+    std::vector<State> states;
+    
+    State& layerState(size_t index, const Layer& layer);
 };
 
-class SGDOptimizer : public Optimizer {
+// 随机梯度下降：w -= lr·g
+template<typename T>
+class BasicSGDOptimizer : public BasicOptimizer<T> {
 public:
-    void updateLayer(Layer* layer, const std::vector<double>& input, double learning_rate) override;
+    using typename BasicOptimizer<T>::Layer;
+    using typename BasicOptimizer<T>::LayerBuffers;
+    using typename BasicOptimizer<T>::State;
+    using typename BasicOptimizer<T>::ParameterBlock;
+
+    explicit BasicSGDOptimizer(const OptimizerConfig& config = OptimizerConfig()) : BasicOptimizer<T>(config) {}
+    
     OptimizerType getType() const override { return OptimizerType::SGD; }
+    size_t stateSlots() const override { return 0; }
+    // 单样本更新不构造梯度矩阵，只更新输入非零的列
+    void updateLayerSample(Layer& layer, const T* input, LayerBuffers& buf,
+                           State& state, double learning_rate) override;
+
+protected:
+    void apply(const ParameterBlock& params, State& state, double learning_rate, ThreadPool* pool) override;
 };
 
-class AdamOptimizer : public Optimizer {
+// 动量SGD：u = μ·u + g，w -= lr·u；Nesterov版本 w -= lr·(g + μ·u)
+template<typename T>
+class BasicMomentumOptimizer : public BasicOptimizer<T> {
+public:
+    using typename BasicOptimizer<T>::State;
+    using typename BasicOptimizer<T>::ParameterBlock;
+
 private:
-    double beta1 = 0.9;
-    double beta2 = 0.999;
-    double epsilon = 1e-8;
+    bool nesterov;
+
+public:
+    BasicMomentumOptimizer(const OptimizerConfig& config = OptimizerConfig(), bool nesterov = false)
+        : BasicOptimizer<T>(config), nesterov(nesterov) {}
     
+    OptimizerType getType() const override { return nesterov ? OptimizerType::NESTEROV : OptimizerType::MOMENTUM; }
+    size_t stateSlots() const override { return 1; }
+
+protected:
+    void apply(const ParameterBlock& params, State& state, double learning_rate, ThreadPool* pool) override;
+};
+
+// RMSProp：s = ρ·s + (1-ρ)·g²，w -= lr·g / (sqrt(s) + ε)
+template<typename T>
+class BasicRmsPropOptimizer : public BasicOptimizer<T> {
 public:
-    AdamOptimizer(double b1 = 0.9, double b2 = 0.999, double eps = 1e-8) 
-        : beta1(b1), beta2(b2), epsilon(eps) {}
+    using typename BasicOptimizer<T>::State;
+    using typename BasicOptimizer<T>::ParameterBlock;
+
+    explicit BasicRmsPropOptimizer(const OptimizerConfig& config = OptimizerConfig())
+        : BasicOptimizer<T>(config) {}
     
-    void updateLayer(Layer* layer, const std::vector<double>& input, double learning_rate) override;
-    OptimizerType getType() const override { return OptimizerType::ADAM; }
+    OptimizerType getType() const override { return OptimizerType::RMSPROP; }
+    size_t stateSlots() const override { return 1; }
+
+protected:
+    void apply(const ParameterBlock& params, State& state, double learning_rate, ThreadPool* pool) override;
+};
+
+// Adam；decoupled_weight_decay时为AdamW，每步先把权重乘以 1 - lr·weight_decay
+template<typename T>
+class BasicAdamOptimizer : public BasicOptimizer<T> {
+public:
+    using typename BasicOptimizer<T>::State;
+    using typename BasicOptimizer<T>::ParameterBlock;
+
+private:
+    bool decoupled_weight_decay;
+
+public:
+    BasicAdamOptimizer(const OptimizerConfig& config = OptimizerConfig(), bool decoupled_weight_decay = false)
+        : BasicOptimizer<T>(config), decoupled_weight_decay(decoupled_weight_decay) {}
+    
+    OptimizerType getType() const override { return decoupled_weight_decay ? OptimizerType::ADAMW : OptimizerType::ADAM; }
+    size_t stateSlots() const override { return 2; }
+
+protected:
+    void apply(const ParameterBlock& params, State& state, double learning_rate, ThreadPool* pool) override;
+};
+
+// LAMB：AdamW的更新量 r 按层缩放，w -= lr·(‖w‖/‖r‖)·r，权重与偏置各自计算比例（偏置不做权重衰减）。
+// 每层的步长与权重的量级成比例，大批量训练时可以用更大的学习率
+template<typename T>
+class BasicLambOptimizer : public BasicOptimizer<T> {
+public:
+    using typename BasicOptimizer<T>::State;
+    using typename BasicOptimizer<T>::ParameterBlock;
+
+    explicit BasicLambOptimizer(const OptimizerConfig& config = OptimizerConfig()) : BasicOptimizer<T>(config) {}
+    
+    OptimizerType getType() const override { return OptimizerType::LAMB; }
+    size_t stateSlots() const override { return 2; }
+    size_t scratchSize(size_t output_size) const override { return 2 * output_size; }
+
+protected:
+    void apply(const ParameterBlock& params, State& state, double learning_rate, ThreadPool* pool) override;
+};
+
+template<typename T>
+class BasicNeuralNetwork;
+
+// ========== 推理上下文 ==========
+// 只读推理所需的临时缓冲区。每个线程持有一份，即可让多个线程无锁地
+// 共用同一个已加载的网络；缓冲区按需增长，容量足够后推理不再分配内存
+template<typename T>
+class BasicInferenceContext {
+public:
+    BasicInferenceContext() = default;
+    
+    // 当前可容纳的最大批大小
+    size_t capacity() const { return activations.empty() ? 0 : activations[0].rows(); }
+    
+    // 最近一次predict中第layer层的输出（前rows行），用于量化校准统计各层激活的范围
+    BasicMatrixView<const T> layerOutput(size_t layer, size_t rows) const {
+        return activations.at(layer).view().rowRange(0, rows);
+    }
+
+private:
+    friend class BasicNeuralNetwork<T>;
+    std::vector<BasicMatrix<T>> activations;  // 每层一份 capacity x output_size
+};
+
+// 所有层参数的副本，用于回滚或保存最佳权重
+template<typename T>
+struct BasicParameterSnapshot {
+    std::vector<BasicMatrix<T>> weights;
+    std::vector<std::vector<T>> biases;
+    
+    bool empty() const { return weights.empty(); }
+};
+
+// 网络结构、参数与优化器（类型、超参数与各层状态）的完整副本，用于训练检查点。
+// 反复快照到同一对象时复用已有的缓冲区
+template<typename T>
+struct BasicNetworkState {
+    struct LayerState {
+        ActivationType activation = ActivationType::SIGMOID;
+        BasicMatrix<T> weights;
+        std::vector<T> biases;
+        BasicOptimizerState<T> optimizer;
+    };
+    
+    std::vector<LayerState> layers;
+    double learning_rate = 0.0;
+    LossType loss_type = LossType::MEAN_SQUARED_ERROR;
+    OptimizerType optimizer_type = OptimizerType::SGD;
+    OptimizerConfig optimizer_config;
+};
+
+// ========== 训练目标 ==========
+// 一批样本的训练目标，每行一个样本：稠密目标矩阵，或每个样本的类别下标。
+// 类别下标等价于one-hot目标，损失与输出层梯度直接按下标计算，不构造one-hot向量
+template<typename T>
+class BasicTargetView {
+public:
+    using ConstMatrixView = BasicMatrixView<const T>;
+
+private:
+    ConstMatrixView dense;
+    const int* class_labels = nullptr;
+    size_t count = 0;
+    size_t num_classes = 0;
+
+public:
+    BasicTargetView(ConstMatrixView targets)
+        : dense(targets), count(targets.rows()), num_classes(targets.cols()) {}
+    BasicTargetView(const BasicMatrix<T>& targets) : BasicTargetView(ConstMatrixView(targets.view())) {}
+    BasicTargetView(const int* labels, size_t count, size_t num_classes)
+        : class_labels(labels), count(count), num_classes(num_classes) {}
+
+    size_t rows() const { return count; }
+    size_t cols() const { return num_classes; }
+    bool hasLabels() const { return class_labels != nullptr; }
+
+    const T* row(size_t i) const { return dense.row(i); }
+    int label(size_t i) const { return class_labels[i]; }
+
+    BasicTargetView rowRange(size_t first, size_t rows) const {
+        if (class_labels) {
+            return BasicTargetView(class_labels + first, rows, num_classes);
+        }
+        return BasicTargetView(dense.rowRange(first, rows));
+    }
+};
+
+// ========== 混合精度训练 ==========
+// 小批量训练中各层的激活值只以bf16保存到反向传播（内存占用与读写量减半），
+// float的中间结果放在每个线程一份、按最宽层分配的暂存区中，各层轮流使用；
+// 层间传递的梯度舍入到bf16精度。权重、梯度累积与优化器状态仍为网络本身的精度（主权重）。
+// Hogwild训练不受影响
+struct MixedPrecisionConfig {
+    bool enabled = false;
+    // 损失缩放：输出层梯度乘以loss_scale，更新参数前再除掉，避免小梯度在低精度下下溢。
+    // bf16的指数范围与float相同，一般保持1即可
+    double loss_scale = 1.0;
+    // 动态损失缩放：梯度出现非有限值时跳过该步并把缩放减半，连续growth_interval步正常后加倍
+    bool dynamic_loss_scale = false;
+    size_t growth_interval = 2000;
+};
+
+// ========== 训练工作区 ==========
+// 一个线程完成一次前向/反向传播所需的全部缓冲区；由reserveWorkspace按网络结构
+// 与最大批大小一次性分配，之后的训练步只通过视图读写，不再分配内存
+template<typename T>
+struct BasicWorkspace {
+    std::vector<BasicLayerBuffers<T>> layers;
+    BasicMatrix<T> output_gradient;
+    std::vector<BasicOptimizerState<T>> optimizer_states;  // Hogwild模式下线程私有的优化器状态
+    double loss = 0.0;
+    
+    // 混合精度训练的float暂存区，列数为最宽层的维度：前向传播时两块交替作为各层的输入与输出，
+    // 反向传播时分别存放本层与前一层由bf16展开的激活值
+    BasicMatrix<T> scratch_activations[2];
+    BasicMatrix<T> scratch_errors;
+    BasicMatrix<T> scratch_gradient;
 };
 
 // ========== 神经网络类 ==========
-class NeuralNetwork {
+template<typename T>
+class BasicNeuralNetwork {
+public:
+    using Scalar = T;
+    using Matrix = BasicMatrix<T>;
+    using MatrixView = BasicMatrixView<T>;
+    using ConstMatrixView = BasicMatrixView<const T>;
+    using Layer = BasicLayer<T>;
+    using LayerBuffers = BasicLayerBuffers<T>;
+    using OptimizerState = BasicOptimizerState<T>;
+    using Optimizer = BasicOptimizer<T>;
+    using InferenceContext = BasicInferenceContext<T>;
+    using ParameterSnapshot = BasicParameterSnapshot<T>;
+    using NetworkState = BasicNetworkState<T>;
+    using TargetView = BasicTargetView<T>;
+    using Workspace = BasicWorkspace<T>;
+
 private:
     std::vector<std::unique_ptr<Layer>> layers;
     std::unique_ptr<Optimizer> optimizer;
     double learning_rate;
     LossType loss_type;  // 新增：损失函数类型
+    
+    Matrix output_gradient;  // 输出层梯度缓冲区
+    InferenceContext predict_context;  // 非const的predict使用的推理缓冲区
+    
+    std::mt19937 rng;  // 权重初始化使用的随机数发生器
+    
+    // 数据并行训练，每个分片/线程一份工作区
+    size_t num_threads = 1;
+    std::unique_ptr<ThreadPool> thread_pool;
+    std::vector<Workspace> workers;
+    std::vector<const LayerBuffers*> reduce_parts;  // 梯度归约时各分片缓冲区的指针
+    
+    // 混合精度训练
+    MixedPrecisionConfig mixed_precision;
+    double loss_scale = 1.0;       // 当前的损失缩放（动态缩放时随训练调整）
+    size_t good_steps = 0;         // 上次调整缩放以来连续正常的步数
+    size_t skipped_steps = 0;      // 因梯度非有限而跳过的步数
+    
+    void ensureInputLayer(size_t input_size);
+    // 训练前把引用外部存储（映射的模型文件）的权重复制为可写的自有存储
+    void makeWritable();
+    double sampleLoss(const T* predicted, const T* target, size_t n) const;
+    double sampleLoss(const T* predicted, int label, size_t n) const;
+    // output各行相对targets的损失之和
+    double batchLoss(ConstMatrixView output, const TargetView& targets) const;
+    // 检查目标的行数与输出维度，类别下标须在[0, 输出维度)内
+    void checkTargets(const TargetView& targets, size_t batch_size) const;
+    // 计算输出层梯度 (predicted - target)·scale，写入gradient的前batch行
+    void computeOutputGradient(ConstMatrixView output, const TargetView& targets, double scale,
+                               Matrix& gradient) const;
+    double trainBatchParallel(ConstMatrixView inputs, const TargetView& targets, size_t num_shards);
+    // 一个分片的混合精度前向/反向传播，梯度写入worker的各层缓冲区，返回损失之和
+    double forwardBackwardMixed(ConstMatrixView inputs, const TargetView& targets, double scale,
+                                Workspace& worker) const;
+    void ensureMixedWorkspace(Workspace& worker, size_t batch_size) const;
+    // 撤销损失缩放并按需调整缩放，返回本步是否应更新参数
+    bool finishLossScaling();
+    
+    // 模型文件：data为整个文件的内容；storage非空时与本网络精度相同的权重直接引用data
+    // （须为小端序主机），精度不同的权重转换后复制
+    bool loadVersionedModel(const unsigned char* data, size_t size, std::shared_ptr<const void> storage);
+    bool loadLegacyModel(const std::string& filename);
+    // 给定批大小时数据并行切分的分片数，1表示走单线程路径
+    size_t numShards(size_t batch_size) const;
 
 public:
-    NeuralNetwork(double lr = 0.01, LossType loss = LossType::MEAN_SQUARED_ERROR);
-    ~NeuralNetwork();
+    BasicNeuralNetwork(double lr = 0.01, LossType loss = LossType::MEAN_SQUARED_ERROR);
+    ~BasicNeuralNetwork();
     
     void addLayer(int neurons, ActivationType activation = ActivationType::SIGMOID);
-    void setOptimizer(OptimizerType type, double lr = 0.01);
+    // 更换优化器（各层的优化器状态随之丢弃）；超参数不合法时抛出invalid_argument
+    void setOptimizer(OptimizerType type, double lr = 0.01, const OptimizerConfig& config = OptimizerConfig());
+    OptimizerType getOptimizerType() const { return optimizer->getType(); }
+    // 当前学习率；学习率调度在每个训练步之前修改它，优化器状态不受影响
+    double getLearningRate() const { return learning_rate; }
+    void setLearningRate(double lr) { learning_rate = lr; }
     void setLossType(LossType type) { loss_type = type; }  // 新增：设置损失函数类型
+    // 确定输入维度（第一层在首次前向传播前只有占位符大小）
+    void setInputSize(size_t input_size) { if (!layers.empty()) ensureInputLayer(input_size); }
+    // 输入/输出维度，没有层时为0
+    size_t getInputSize() const { return layers.empty() ? 0 : layers.front()->getInputSize(); }
+    size_t getOutputSize() const { return layers.empty() ? 0 : layers.back()->getOutputSize(); }
+    
+    // 设置随机种子并重新初始化已有层的权重；相同种子与线程数下训练结果可复现
+    void setSeed(unsigned seed);
+    // 设置训练使用的线程数（0表示使用全部硬件线程），大于1时小批量按样本切分到各线程
+    void setNumThreads(size_t threads);
+    size_t getNumThreads() const { return num_threads; }
+    
+    // 混合精度训练（见MixedPrecisionConfig），只影响小批量的trainBatch
+    void setMixedPrecision(const MixedPrecisionConfig& config);
+    const MixedPrecisionConfig& getMixedPrecision() const { return mixed_precision; }
+    double getLossScale() const { return loss_scale; }
+    size_t getSkippedSteps() const { return skipped_steps; }
+    
+    // 按网络结构预先分配批大小不超过max_batch_size的训练与推理缓冲区，
+    // 之后的trainBatch/train/trainHogwild不再分配内存；应在网络结构与线程数确定后调用
+    void reserveWorkspace(size_t max_batch_size);
+    
+    // 返回输出层激活值的引用（在下次前向传播前有效）
+    const std::vector<T>& forward(const std::vector<T>& input);
+    
+    // 小批量前向/反向传播，inputs与targets每行一个样本
+    ConstMatrixView forwardBatch(ConstMatrixView inputs);
+    void backwardBatch(ConstMatrixView inputs, const TargetView& targets);
+    void applyGradients();
+    
+    double train(const std::vector<T>& input, const std::vector<T>& target);
+    double trainBatch(const std::vector<std::vector<T>>& inputs,
+                     const std::vector<std::vector<T>>& targets);
+    double trainBatch(ConstMatrixView inputs, const TargetView& targets);
     
-    std::vector<double> forward(const std::vector<double>& input);
-    void backward(const std::vector<double>& target);
-    void backwardCrossEntropy(const std::vector<double>& target);  // 新增：交叉熵反向传播
+    // 按类别下标训练（labels每个样本一个，取值[0, 输出维度)），与对应的one-hot目标结果相同，
+    // 但不构造one-hot向量：交叉熵损失为 -log p[label]，输出层梯度只在label处减1
+    double train(const std::vector<T>& input, int label);
+    double trainBatch(ConstMatrixView inputs, const int* labels) {
+        return trainBatch(inputs, TargetView(labels, inputs.rows(), getOutputSize()));
+    }
     
-    double train(const std::vector<double>& input, const std::vector<double>& target);
-    double trainBatch(const std::vector<std::vector<double>>& inputs,
-                     const std::vector<std::vector<double>>& targets);
+    // Hogwild异步训练：样本按行连续切分给各线程，每个线程逐样本执行与train()相同的
+    // 前向/反向传播并直接更新共享参数，线程之间不加锁也不同步。
+    // 优化器状态（动量、矩估计等）每个线程一份；结果与线程调度有关，不可复现。返回平均损失
+    double trainHogwild(ConstMatrixView inputs, const TargetView& targets);
+    double trainHogwild(ConstMatrixView inputs, const int* labels) {
+        return trainHogwild(inputs, TargetView(labels, inputs.rows(), getOutputSize()));
+    }
     
-    std::vector<double> predict(const std::vector<double>& input);
-    std::vector<double> getHiddenLayerOutput(const std::vector<double>& input);
+    // 保存/恢复所有层的权重与偏置（不含优化器状态）
+    void snapshotParameters(ParameterSnapshot& snapshot) const;
+    void restoreParameters(const ParameterSnapshot& snapshot);
+    
+    // 保存/恢复网络结构、参数与优化器状态；restoreState按state重建各层。
+    // Hogwild训练中各线程私有的矩估计不包含在内
+    void snapshotState(NetworkState& state) const;
+    void restoreState(const NetworkState& state);
+    
+    std::vector<T> predict(const std::vector<T>& input);
+    
+    // 只读推理：inputs每行一个样本，结果写入ctx并返回其视图（在下次使用ctx前有效）。
+    // 不修改网络状态，多个线程可各自使用自己的ctx并发调用
+    ConstMatrixView predict(ConstMatrixView inputs, InferenceContext& ctx) const;
+    ConstMatrixView predict(const std::vector<T>& input, InferenceContext& ctx) const;
+    // 预先按批大小分配ctx的缓冲区，之后不超过该批大小的推理不再分配内存
+    void prepareContext(InferenceContext& ctx, size_t batch_size = 1) const;
+    
+    // 批量只读推理：inputs为 N x 输入维度，结果写入 N x 输出维度 的outputs。
+    // 按块走矩阵乘法内核，各块在线程池上并行计算
+    void predictBatch(ConstMatrixView inputs, MatrixView outputs) const;
+    std::vector<T> getHiddenLayerOutput(const std::vector<T>& input);
     
     // 损失函数计算
-    double calculateLoss(const std::vector<double>& predicted, const std::vector<double>& target);
-    double calculateCrossEntropyLoss(const std::vector<double>& predicted, 
-                                   const std::vector<double>& target);  // 新增：交叉熵损失
+    double calculateLoss(const std::vector<T>& predicted, const std::vector<T>& target);
+    double calculateCrossEntropyLoss(const std::vector<T>& predicted,
+                                   const std::vector<T>& target);  // 新增：交叉熵损失
     
+    // 保存为版本化的模型文件（见model_format.h），按本网络的精度写出权重并在层记录中注明：
+    // 先写临时文件再替换，不影响正在使用旧文件的进程
     bool saveModel(const std::string& filename) const;
+    // 读取模型文件，也兼容旧格式。新格式在小端序主机上映射到内存后直接使用文件中的权重，
+    // 不复制（偏置很小，仍复制）；开始训练时才把权重复制为可写的存储。
+    // 文件的精度与本网络不同时（如double模型读入float网络）转换后复制
     bool loadModel(const std::string& filename);
     void printNetworkInfo() const;
-
-    void performBackwardPass(std::vector<double> gradient);
 };
 
-#endif // BPNN_H
\ No newline at end of file
+// ========== 常用类型 ==========
+// 双精度：原有接口（如螨虫分类）使用
+using ActivationFunction = BasicActivationFunction<double>;
+using LayerBuffers = BasicLayerBuffers<double>;
+using OptimizerState = BasicOptimizerState<double>;
+using Layer = BasicLayer<double>;
+using Optimizer = BasicOptimizer<double>;
+using SGDOptimizer = BasicSGDOptimizer<double>;
+using MomentumOptimizer = BasicMomentumOptimizer<double>;
+using RmsPropOptimizer = BasicRmsPropOptimizer<double>;
+using AdamOptimizer = BasicAdamOptimizer<double>;
+using LambOptimizer = BasicLambOptimizer<double>;
+using InferenceContext = BasicInferenceContext<double>;
+using ParameterSnapshot = BasicParameterSnapshot<double>;
+using NetworkState = BasicNetworkState<double>;
+using TargetView = BasicTargetView<double>;
+using Workspace = BasicWorkspace<double>;
+using NeuralNetwork = BasicNeuralNetwork<double>;
+
+// 单精度：带宽减半、SIMD宽度加倍，MNIST分类器默认使用
+using InferenceContextF = BasicInferenceContext<float>;
+using ParameterSnapshotF = BasicParameterSnapshot<float>;
+using NetworkStateF = BasicNetworkState<float>;
+using TargetViewF = BasicTargetView<float>;
+using NeuralNetworkF = BasicNeuralNetwork<float>;
+
+#endif // BPNN_H
@@ -0,0 +1,588 @@
+#include "checkpoint.h"
+#include "model_format.h"
+#include "gzip_stream.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace model_format;
+
+namespace {
+
+constexpr char kCheckpointMagic[8] = {'B', 'P', 'N', 'N', 'C', 'K', 'P', 'T'};
+// 版本2在负载开头记录张量的元素类型；版本1的张量均为double。
+// 版本3记录优化器的超参数，每层的优化器状态为若干份缓冲区；之前的版本固定为Adam的两份矩估计。
+// 版本4在训练进度之后记录学习率调度，之前的版本为固定学习率；版本5再记录提前停止的进度
+constexpr uint32_t kCheckpointVersion = 5;
+// 每层优化器状态的份数上限（Adam系为2）
+constexpr uint32_t kMaxStateSlots = 8;
+// 文件头：magic[8]  version(u32)  crc(u32)  payload_size(u64)
+constexpr size_t kCheckpointHeaderSize = 24;
+
+// 顺序编码到复用的缓冲区
+class ByteWriter {
+private:
+    std::vector<unsigned char>& out;
+
+    unsigned char* grow(size_t n) {
+        size_t size = out.size();
+        out.resize(size + n);
+        return out.data() + size;
+    }
+
+public:
+    explicit ByteWriter(std::vector<unsigned char>& buffer) : out(buffer) { out.clear(); }
+
+    void u32(uint32_t v) { storeU32(grow(4), v); }
+    void u64(uint64_t v) { storeU64(grow(8), v); }
+    void f64(double v) { storeF64(grow(8), v); }
+
+    // 张量元素按T本身的精度写出
+    template<typename T>
+    void scalars(const T* values, size_t n) {
+        unsigned char* p = grow(n * sizeof(T));
+        for (size_t i = 0; i < n; ++i) {
+            storeScalar(p + i * sizeof(T), values[i]);
+        }
+    }
+
+    template<typename T>
+    void vector(const std::vector<T>& values) {
+        u64(values.size());
+        scalars(values.data(), values.size());
+    }
+
+    template<typename T>
+    void matrix(const BasicMatrix<T>& m) {
+        u64(m.rows());
+        u64(m.cols());
+        for (size_t r = 0; r < m.rows(); ++r) {
+            scalars(m.row(r), m.cols());
+        }
+    }
+
+    void string(const std::string& s) {
+        u64(s.size());
+        std::copy(s.begin(), s.end(), grow(s.size()));
+    }
+};
+
+// 带边界检查的顺序解码，越界后所有读取返回0并标记失败
+class ByteReader {
+private:
+    const unsigned char* ptr;
+    size_t remaining;
+    bool ok = true;
+    DataType element_type = DataType::FLOAT64;  // 张量元素在负载中的类型
+
+    const unsigned char* take(size_t n) {
+        if (!ok || n > remaining) {
+            ok = false;
+            return nullptr;
+        }
+        const unsigned char* p = ptr;
+        ptr += n;
+        remaining -= n;
+        return p;
+    }
+
+    // 读取元素个数，超出剩余数据能容纳的数量时失败
+    bool count(uint64_t n, size_t element_size) {
+        if (n > remaining / element_size) {
+            ok = false;
+        }
+        return ok;
+    }
+
+public:
+    ByteReader(const unsigned char* data, size_t size) : ptr(data), remaining(size) {}
+
+    void setElementType(DataType type) { element_type = type; }
+
+    bool failed() const { return !ok; }
+    bool finished() const { return ok && remaining == 0; }
+
+    uint32_t u32() { const unsigned char* p = take(4); return p ? loadU32(p) : 0; }
+    uint64_t u64() { const unsigned char* p = take(8); return p ? loadU64(p) : 0; }
+    double f64() { const unsigned char* p = take(8); return p ? loadF64(p) : 0.0; }
+
+    // 张量元素按element_type解码，与T不同时转换
+    template<typename T>
+    void scalars(T* values, size_t n) {
+        size_t element_size = dataTypeSize(element_type);
+        const unsigned char* p = take(n * element_size);
+        if (!p) return;
+        for (size_t i = 0; i < n; ++i) {
+            values[i] = static_cast<T>(loadScalar(p + i * element_size, element_type));
+        }
+    }
+
+    template<typename T>
+    void vector(std::vector<T>& values) {
+        uint64_t n = u64();
+        if (!count(n, dataTypeSize(element_type))) return;
+        values.resize(static_cast<size_t>(n));
+        scalars(values.data(), values.size());
+    }
+
+    template<typename T>
+    void matrix(BasicMatrix<T>& m) {
+        uint64_t rows = u64();
+        uint64_t cols = u64();
+        if (cols != 0 && rows > remaining / dataTypeSize(element_type) / cols) {
+            ok = false;
+        }
+        if (!ok) return;
+        m.resize(static_cast<size_t>(rows), static_cast<size_t>(cols));
+        for (size_t r = 0; r < m.rows(); ++r) {
+            scalars(m.row(r), m.cols());
+        }
+    }
+
+    void string(std::string& s) {
+        uint64_t n = u64();
+        if (!count(n, 1)) return;
+        const unsigned char* p = take(static_cast<size_t>(n));
+        if (p) s.assign(reinterpret_cast<const char*>(p), static_cast<size_t>(n));
+    }
+};
+
+void encodeCheckpoint(const TrainingCheckpoint& checkpoint, std::vector<unsigned char>& buffer) {
+    ByteWriter out(buffer);
+
+    const NetworkStateF& network = checkpoint.network;
+    out.u32(static_cast<uint32_t>(dataTypeOf<float>()));
+    out.f64(network.learning_rate);
+    out.u32(static_cast<uint32_t>(network.loss_type));
+    out.u32(static_cast<uint32_t>(network.optimizer_type));
+    const OptimizerConfig& config = network.optimizer_config;
+    out.f64(config.momentum);
+    out.f64(config.beta1);
+    out.f64(config.beta2);
+    out.f64(config.rho);
+    out.f64(config.epsilon);
+    out.f64(config.weight_decay);
+    out.u32(static_cast<uint32_t>(network.layers.size()));
+    for (const NetworkStateF::LayerState& layer : network.layers) {
+        out.u32(static_cast<uint32_t>(layer.activation));
+        out.matrix(layer.weights);
+        out.vector(layer.biases);
+        const BasicOptimizerState<float>& state = layer.optimizer;
+        out.u32(static_cast<uint32_t>(state.timestep));
+        out.u32(static_cast<uint32_t>(state.slots()));
+        for (size_t i = 0; i < state.slots(); ++i) {
+            out.matrix(state.weight_slots[i]);
+            out.vector(state.bias_slots[i]);
+        }
+    }
+
+    out.u64(checkpoint.step);
+    out.u32(checkpoint.epoch);
+    out.u64(checkpoint.next_batch);
+    out.u64(checkpoint.batch_size);
+    out.f64(checkpoint.epoch_loss_sum);
+    out.u64(checkpoint.epoch_batches);
+    out.f64(checkpoint.previous_loss);
+    out.u32(checkpoint.training_mode);
+    out.u64(checkpoint.augmentation_seed);
+    
+    const LRScheduleConfig& schedule = checkpoint.lr_schedule;
+    out.u32(static_cast<uint32_t>(schedule.type));
+    out.u64(schedule.warmup_steps);
+    out.u64(schedule.step_size);
+    out.f64(schedule.gamma);
+    out.f64(schedule.min_lr);
+    out.f64(schedule.pct_start);
+    out.f64(schedule.div_factor);
+    out.f64(schedule.final_div_factor);
+    out.f64(checkpoint.peak_learning_rate);
+    out.u64(checkpoint.schedule_total_steps);
+    
+    out.f64(checkpoint.best_validation_loss);
+    out.u32(checkpoint.best_epoch);
+    out.u32(checkpoint.stale_epochs);
+
+    out.u64(checkpoint.order.size());
+    for (int index : checkpoint.order) {
+        out.u32(static_cast<uint32_t>(index));
+    }
+
+    std::ostringstream rng_state;
+    rng_state << checkpoint.rng;
+    out.string(rng_state.str());
+}
+
+bool decodeCheckpoint(const unsigned char* data, size_t size, uint32_t version,
+                      TrainingCheckpoint& checkpoint) {
+    ByteReader in(data, size);
+
+    if (version >= 2) {
+        DataType element_type = static_cast<DataType>(in.u32());
+        if (dataTypeSize(element_type) == 0) {
+            return false;
+        }
+        in.setElementType(element_type);
+    }
+
+    NetworkStateF& network = checkpoint.network;
+    network.learning_rate = in.f64();
+    uint32_t loss_type = in.u32();
+    uint32_t optimizer_type = in.u32();
+    OptimizerConfig& config = network.optimizer_config;
+    config = OptimizerConfig();
+    if (version >= 3) {
+        config.momentum = in.f64();
+        config.beta1 = in.f64();
+        config.beta2 = in.f64();
+        config.rho = in.f64();
+        config.epsilon = in.f64();
+        config.weight_decay = in.f64();
+    }
+    uint32_t num_layers = in.u32();
+    if (loss_type > static_cast<uint32_t>(LossType::CROSS_ENTROPY) ||
+        optimizer_type > static_cast<uint32_t>(OptimizerType::LAMB) ||
+        num_layers > size) {
+        return false;
+    }
+    network.loss_type = static_cast<LossType>(loss_type);
+    network.optimizer_type = static_cast<OptimizerType>(optimizer_type);
+    network.layers.resize(num_layers);
+    for (NetworkStateF::LayerState& layer : network.layers) {
+        uint32_t activation = in.u32();
+        if (activation > static_cast<uint32_t>(ActivationType::SOFTMAX)) {
+            return false;
+        }
+        layer.activation = static_cast<ActivationType>(activation);
+        in.matrix(layer.weights);
+        in.vector(layer.biases);
+        BasicOptimizerState<float>& state = layer.optimizer;
+        state.timestep = static_cast<int>(in.u32());
+        if (version >= 3) {
+            uint32_t slots = in.u32();
+            if (slots > kMaxStateSlots) {
+                return false;
+            }
+            state.weight_slots.resize(slots);
+            state.bias_slots.resize(slots);
+            for (uint32_t i = 0; i < slots; ++i) {
+                in.matrix(state.weight_slots[i]);
+                in.vector(state.bias_slots[i]);
+            }
+        } else {
+            // 旧版本：一阶矩与二阶矩，按 m_weights、v_weights、m_biases、v_biases 的顺序
+            state.weight_slots.resize(2);
+            state.bias_slots.resize(2);
+            in.matrix(state.weight_slots[0]);
+            in.matrix(state.weight_slots[1]);
+            in.vector(state.bias_slots[0]);
+            in.vector(state.bias_slots[1]);
+        }
+        if (in.failed()) {
+            return false;
+        }
+    }
+
+    checkpoint.step = in.u64();
+    checkpoint.epoch = in.u32();
+    checkpoint.next_batch = in.u64();
+    checkpoint.batch_size = in.u64();
+    checkpoint.epoch_loss_sum = in.f64();
+    checkpoint.epoch_batches = in.u64();
+    checkpoint.previous_loss = in.f64();
+    checkpoint.training_mode = in.u32();
+    checkpoint.augmentation_seed = in.u64();
+    
+    LRScheduleConfig& schedule = checkpoint.lr_schedule;
+    schedule = LRScheduleConfig();
+    checkpoint.peak_learning_rate = 0.0;
+    checkpoint.schedule_total_steps = 0;
+    if (version >= 4) {
+        uint32_t schedule_type = in.u32();
+        if (schedule_type > static_cast<uint32_t>(LRScheduleType::ONE_CYCLE)) {
+            return false;
+        }
+        schedule.type = static_cast<LRScheduleType>(schedule_type);
+        schedule.warmup_steps = static_cast<size_t>(in.u64());
+        schedule.step_size = static_cast<size_t>(in.u64());
+        schedule.gamma = in.f64();
+        schedule.min_lr = in.f64();
+        schedule.pct_start = in.f64();
+        schedule.div_factor = in.f64();
+        schedule.final_div_factor = in.f64();
+        checkpoint.peak_learning_rate = in.f64();
+        checkpoint.schedule_total_steps = in.u64();
+        try {
+            LRScheduler::validate(schedule);
+        } catch (const std::invalid_argument&) {
+            return false;
+        }
+    }
+    
+    checkpoint.best_validation_loss = std::numeric_limits<double>::infinity();
+    checkpoint.best_epoch = 0;
+    checkpoint.stale_epochs = 0;
+    if (version >= 5) {
+        checkpoint.best_validation_loss = in.f64();
+        checkpoint.best_epoch = in.u32();
+        checkpoint.stale_epochs = in.u32();
+    }
+
+    uint64_t order_size = in.u64();
+    if (in.failed() || order_size > size / 4) {
+        return false;
+    }
+    checkpoint.order.resize(static_cast<size_t>(order_size));
+    for (int& index : checkpoint.order) {
+        index = static_cast<int>(in.u32());
+    }
+
+    std::string rng_state;
+    in.string(rng_state);
+    if (!in.finished()) {
+        return false;
+    }
+    std::istringstream rng_stream(rng_state);
+    rng_stream >> checkpoint.rng;
+    return !rng_stream.fail();
+}
+
+bool writeTextFile(const std::string& path, const std::string& contents) {
+    std::string temp_path = path + ".tmp";
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    file << contents;
+    file.close();
+    if (!file || !replaceFile(temp_path, path)) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> readIndex(const std::string& prefix) {
+    std::vector<std::string> paths;
+    std::ifstream file(prefix + ".index");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty()) {
+            paths.push_back(line);
+        }
+    }
+    return paths;
+}
+
+} // namespace
+
+// ========== 检查点文件 ==========
+
+bool writeCheckpoint(const std::string& path, const TrainingCheckpoint& checkpoint) {
+    // 编码缓冲区按线程复用
+    thread_local std::vector<unsigned char> payload;
+    encodeCheckpoint(checkpoint, payload);
+
+    unsigned char header[kCheckpointHeaderSize];
+    std::memcpy(header, kCheckpointMagic, sizeof(kCheckpointMagic));
+    storeU32(header + 8, kCheckpointVersion);
+    storeU32(header + 12, crc32Update(0, payload.data(), payload.size()));
+    storeU64(header + 16, payload.size());
+
+    std::string temp_path = path + ".tmp";
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Cannot open checkpoint file for writing: " << temp_path << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(header), kCheckpointHeaderSize);
+    file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+    file.close();
+    if (!file) {
+        std::cerr << "Error: Failed to write checkpoint: " << temp_path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    if (!replaceFile(temp_path, path)) {
+        std::cerr << "Error: Cannot replace checkpoint file: " << path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool readCheckpoint(const std::string& path, TrainingCheckpoint& checkpoint) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Cannot open checkpoint file: " << path << std::endl;
+        return false;
+    }
+
+    unsigned char header[kCheckpointHeaderSize];
+    if (!file.read(reinterpret_cast<char*>(header), kCheckpointHeaderSize) ||
+        std::memcmp(header, kCheckpointMagic, sizeof(kCheckpointMagic)) != 0) {
+        std::cerr << "Error: Not a checkpoint file: " << path << std::endl;
+        return false;
+    }
+    uint32_t version = loadU32(header + 8);
+    if (version == 0 || version > kCheckpointVersion) {
+        std::cerr << "Error: Unsupported checkpoint version " << version << ": " << path << std::endl;
+        return false;
+    }
+
+    // 先确认文件长度与头中记录的一致，再分配缓冲区
+    uint64_t payload_size = loadU64(header + 16);
+    file.seekg(0, std::ios::end);
+    uint64_t file_size = static_cast<uint64_t>(file.tellg());
+    if (file_size != kCheckpointHeaderSize + payload_size) {
+        std::cerr << "Error: Checkpoint size mismatch (truncated or corrupted file): " << path << std::endl;
+        return false;
+    }
+    std::vector<unsigned char> payload(static_cast<size_t>(payload_size));
+    file.seekg(kCheckpointHeaderSize);
+    file.read(reinterpret_cast<char*>(payload.data()), payload.size());
+    if (!file) {
+        std::cerr << "Error: Failed to read checkpoint: " << path << std::endl;
+        return false;
+    }
+
+    if (crc32Update(0, payload.data(), payload.size()) != loadU32(header + 12)) {
+        std::cerr << "Error: Checkpoint checksum mismatch: " << path << std::endl;
+        return false;
+    }
+    if (!decodeCheckpoint(payload.data(), payload.size(), version, checkpoint)) {
+        std::cerr << "Error: Invalid checkpoint contents: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// ========== 后台检查点写入 ==========
+
+CheckpointWriter::CheckpointWriter(const std::string& prefix, size_t keep_last)
+    : prefix(prefix), keep_last(std::max<size_t>(keep_last, 1)) {
+    // 接着上一次运行的记录继续计数，之前留下的旧检查点同样按keep_last清理
+    for (const std::string& path : readIndex(prefix)) {
+        retained.push_back(path);
+    }
+    worker = std::thread(&CheckpointWriter::workerLoop, this);
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    pending_cv.notify_all();
+    worker.join();
+}
+
+std::unique_ptr<TrainingCheckpoint> CheckpointWriter::acquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (spare) {
+        return std::move(spare);
+    }
+    return std::unique_ptr<TrainingCheckpoint>(new TrainingCheckpoint());
+}
+
+void CheckpointWriter::submit(std::unique_ptr<TrainingCheckpoint> checkpoint) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending) {
+            // 上一个快照还没开始写，直接被更新的快照取代
+            ++dropped;
+            if (!spare) {
+                spare = std::move(pending);
+            }
+        }
+        pending = std::move(checkpoint);
+    }
+    pending_cv.notify_one();
+}
+
+void CheckpointWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle_cv.wait(lock, [this] { return !pending && !writing; });
+}
+
+size_t CheckpointWriter::writtenCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return written;
+}
+
+size_t CheckpointWriter::droppedCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return dropped;
+}
+
+size_t CheckpointWriter::failureCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return failures;
+}
+
+std::string CheckpointWriter::pathForStep(uint64_t step) const {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "-%010llu.ckpt", static_cast<unsigned long long>(step));
+    return prefix + suffix;
+}
+
+std::string CheckpointWriter::latest(const std::string& prefix) {
+    std::vector<std::string> paths = readIndex(prefix);
+    return paths.empty() ? std::string() : paths.back();
+}
+
+void CheckpointWriter::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        // 停止前先写完已提交的快照
+        pending_cv.wait(lock, [this] { return stopping || pending; });
+        if (!pending) {
+            return;
+        }
+
+        std::unique_ptr<TrainingCheckpoint> checkpoint = std::move(pending);
+        writing = true;
+        lock.unlock();
+
+        std::string path = pathForStep(checkpoint->step);
+        bool ok = writeCheckpoint(path, *checkpoint);
+        if (ok) {
+            retain(path);
+        }
+
+        lock.lock();
+        writing = false;
+        if (ok) {
+            ++written;
+        } else {
+            ++failures;
+        }
+        if (!spare) {
+            spare = std::move(checkpoint);
+        }
+        idle_cv.notify_all();
+    }
+}
+
+void CheckpointWriter::retain(const std::string& path) {
+    // 同一步的检查点（如epoch结束时）覆盖写入同一个文件，只记录一次
+    for (auto it = retained.begin(); it != retained.end(); ++it) {
+        if (*it == path) {
+            retained.erase(it);
+            break;
+        }
+    }
+    retained.push_back(path);
+    while (retained.size() > keep_last) {
+        std::remove(retained.front().c_str());
+        retained.pop_front();
+    }
+
+    std::string index;
+    for (const std::string& p : retained) {
+        index += p;
+        index += '\n';
+    }
+    if (!writeTextFile(prefix + ".index", index)) {
+        std::cerr << "Error: Cannot update checkpoint index: " << prefix << ".index" << std::endl;
+    }
+}
@@ -0,0 +1,100 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "bpnn.h"
+#include "lr_scheduler.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 训练检查点：网络参数与优化器状态，加上恢复训练所需的全部进度
+struct TrainingCheckpoint {
+    NetworkStateF network;
+
+    uint64_t step = 0;             // 已完成的训练批数（跨epoch累计），用于文件命名
+    uint32_t epoch = 0;            // 当前epoch，从0开始
+    uint64_t next_batch = 0;       // 本epoch下一个要训练的批；0表示本epoch尚未开始（还未打乱）
+    uint64_t batch_size = 0;
+    double epoch_loss_sum = 0.0;   // 本epoch已训练各批的损失之和
+    uint64_t epoch_batches = 0;
+    double previous_loss = 0.0;    // 上一epoch的平均损失（Hogwild发散检测使用）
+    uint32_t training_mode = 0;
+    uint64_t augmentation_seed = 0;
+    LRScheduleConfig lr_schedule;  // 学习率调度的配置、峰值与总步数，固定学习率时峰值与总步数为0
+    double peak_learning_rate = 0.0;
+    uint64_t schedule_total_steps = 0;
+    // 提前停止：最低的验证损失、取得它的epoch与之后没有改善的epoch数（最佳参数本身不保存）
+    double best_validation_loss = std::numeric_limits<double>::infinity();
+    uint32_t best_epoch = 0;
+    uint32_t stale_epochs = 0;
+    std::vector<int> order;        // 本epoch的样本顺序（下一epoch在此基础上继续打乱）
+    std::mt19937 rng;              // 打乱数据的随机数发生器
+};
+
+// ========== 检查点文件 ==========
+// 文件头（魔数、版本、负载长度与负载的CRC-32）之后是顺序编码的负载，
+// 整数为定长小端序，浮点数为小端序IEEE 754（参数与优化器状态按负载开头记录的精度存放，
+// 读取时转换为网络的精度），随机数发生器状态按标准库的文本格式保存。
+// 写入时先写临时文件再重命名，进程在任何时刻被终止都不会留下写了一半的检查点
+bool writeCheckpoint(const std::string& path, const TrainingCheckpoint& checkpoint);
+bool readCheckpoint(const std::string& path, TrainingCheckpoint& checkpoint);
+
+// ========== 后台检查点写入 ==========
+// 训练线程只把状态复制到快照中再提交，序列化与写文件在后台线程完成。
+// 检查点写为 prefix-<step>.ckpt，并记录在 prefix.index 中（每行一个路径，最新的在最后），
+// 只保留最近keep_last个，更早的文件被删除。写入跟不上时未开始写的旧快照被新快照替换
+class CheckpointWriter {
+private:
+    std::string prefix;
+    size_t keep_last;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable pending_cv;  // 有新快照或停止
+    std::condition_variable idle_cv;     // 没有待写与正在写的快照
+    std::unique_ptr<TrainingCheckpoint> pending;  // 等待写出的最新快照
+    std::unique_ptr<TrainingCheckpoint> spare;    // 写完后回收复用的快照
+    bool writing = false;
+    bool stopping = false;
+    size_t written = 0;
+    size_t dropped = 0;
+    size_t failures = 0;
+
+    std::deque<std::string> retained;  // 只由后台线程访问
+
+    void workerLoop();
+    void retain(const std::string& path);
+
+public:
+    explicit CheckpointWriter(const std::string& prefix, size_t keep_last = 3);
+    // 写完已提交的快照后退出
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    // 取一个快照对象填写后提交；复用写完的快照，稳定后不再分配内存
+    std::unique_ptr<TrainingCheckpoint> acquire();
+    void submit(std::unique_ptr<TrainingCheckpoint> checkpoint);
+
+    // 等待已提交的快照全部写完
+    void flush();
+
+    size_t writtenCount();
+    size_t droppedCount();
+    size_t failureCount();
+
+    std::string pathForStep(uint64_t step) const;
+
+    // prefix.index中记录的最新检查点路径，没有时返回空字符串
+    static std::string latest(const std::string& prefix);
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,585 @@
+#include "gzip_stream.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kInputChunk = 1 << 16;
+constexpr size_t kWindowSize = 1 << 15;  // DEFLATE最大回溯距离
+constexpr size_t kWindowMask = kWindowSize - 1;
+
+// 长度码257..285与距离码0..29的基值和附加位数（RFC 1951 3.2.5）
+const uint16_t kLengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t kLengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t kDistanceBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t kDistanceExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// 动态块中码长码的排列顺序
+const uint8_t kCodeLengthOrder[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// slicing-by-8查表：tables[k][b]为字节b后接k个0字节的CRC，每次处理8个字节
+using CrcTables = std::array<std::array<uint32_t, 256>, 8>;
+
+const CrcTables& crcTables() {
+    static const CrcTables tables = [] {
+        CrcTables t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k) {
+                t[k][i] = t[0][t[k - 1][i] & 0xFF] ^ (t[k - 1][i] >> 8);
+            }
+        }
+        return t;
+    }();
+    return tables;
+}
+
+} // namespace
+
+uint32_t crc32Update(uint32_t crc, const unsigned char* data, size_t size) {
+    const CrcTables& t = crcTables();
+    uint32_t c = crc ^ 0xFFFFFFFFu;
+    size_t i = 0;
+    // 按字节组装，与主机字节序无关
+    for (; i + 8 <= size; i += 8) {
+        const unsigned char* p = data + i;
+        uint32_t lo = c ^ (static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+                           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24);
+        c = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+            t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+    }
+    for (; i < size; ++i) {
+        c = t[0][(c ^ data[i]) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+// ========== Huffman码表 ==========
+
+bool GzipStream::Huffman::build(const uint8_t* lengths, int n) {
+    std::fill(std::begin(counts), std::end(counts), 0);
+    for (int s = 0; s < n; ++s) {
+        counts[lengths[s]]++;
+    }
+    counts[0] = 0;
+
+    // 码长超额分配说明数据损坏；不完整的码表是允许的（如只有一个距离码）
+    int left = 1;
+    for (int len = 1; len < 16; ++len) {
+        left <<= 1;
+        left -= counts[len];
+        if (left < 0) {
+            return false;
+        }
+    }
+
+    // 按码长、再按符号值排序，即范式Huffman码的分配顺序
+    uint16_t offsets[16];
+    offsets[1] = 0;
+    for (int len = 1; len < 15; ++len) {
+        offsets[len + 1] = offsets[len] + counts[len];
+    }
+    for (int s = 0; s < n; ++s) {
+        if (lengths[s] != 0) {
+            symbols[offsets[lengths[s]]++] = static_cast<uint16_t>(s);
+        }
+    }
+
+    // DEFLATE按位从低到高存放码字，查找表以位反转后的码字为下标
+    std::fill(std::begin(fast), std::end(fast), 0);
+    uint32_t code = 0;
+    int index = 0;
+    for (int len = 1; len <= kFastBits; ++len) {
+        for (int i = 0; i < counts[len]; ++i, ++code) {
+            uint32_t reversed = 0;
+            for (int b = 0; b < len; ++b) {
+                reversed |= ((code >> b) & 1) << (len - 1 - b);
+            }
+            uint16_t entry = static_cast<uint16_t>((symbols[index++] << 4) | len);
+            for (uint32_t k = reversed; k < (1u << kFastBits); k += (1u << len)) {
+                fast[k] = entry;
+            }
+        }
+        code <<= 1;
+    }
+    return true;
+}
+
+// ========== GzipStream实现 ==========
+
+GzipStream::GzipStream() : input(kInputChunk), window(kWindowSize) {}
+
+bool GzipStream::fail(const std::string& message) {
+    if (error_message.empty()) {
+        error_message = message;
+    }
+    return false;
+}
+
+bool GzipStream::open(const std::string& filename) {
+    file.close();
+    file.clear();
+    input_pos = input_end = 0;
+    input_eof = false;
+    bit_buffer = 0;
+    bit_count = 0;
+    match_length = 0;
+    error_message.clear();
+    state = State::DONE;
+
+    file.open(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return fail("Cannot open file: " + filename);
+    }
+
+    state = State::MEMBER_HEADER;
+    return readMemberHeader();
+}
+
+bool GzipStream::fillInput() {
+    if (input_eof) {
+        return false;
+    }
+    file.read(reinterpret_cast<char*>(input.data()), static_cast<std::streamsize>(input.size()));
+    input_pos = 0;
+    input_end = static_cast<size_t>(file.gcount());
+    if (input_end == 0) {
+        input_eof = true;
+        return false;
+    }
+    return true;
+}
+
+void GzipStream::refill() {
+    while (bit_count <= 56) {
+        if (input_pos == input_end && !fillInput()) {
+            return;
+        }
+        bit_buffer |= static_cast<uint64_t>(input[input_pos++]) << bit_count;
+        bit_count += 8;
+    }
+}
+
+bool GzipStream::needBits(int n) {
+    if (bit_count < n) {
+        refill();
+    }
+    return bit_count >= n;
+}
+
+uint32_t GzipStream::getBits(int n) {
+    uint32_t value = static_cast<uint32_t>(bit_buffer & ((uint64_t(1) << n) - 1));
+    bit_buffer >>= n;
+    bit_count -= n;
+    return value;
+}
+
+int GzipStream::decodeSymbol(const Huffman& h) {
+    if (bit_count < 15) {
+        refill();
+    }
+
+    uint16_t entry = h.fast[bit_buffer & ((1u << Huffman::kFastBits) - 1)];
+    if (entry != 0) {
+        int len = entry & 15;
+        if (len > bit_count) {
+            return -1;
+        }
+        getBits(len);
+        return entry >> 4;
+    }
+
+    // 长码：逐位比较范式码的区间
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int len = 1; len < 16; ++len) {
+        if (bit_count == 0) {
+            return -1;
+        }
+        code |= static_cast<int>(getBits(1));
+        int count = h.counts[len];
+        if (code - first < count) {
+            return h.symbols[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+bool GzipStream::readMemberHeader() {
+    auto readByte = [this](uint32_t& value) {
+        if (!needBits(8)) {
+            return fail("Unexpected end of gzip header");
+        }
+        value = getBits(8);
+        return true;
+    };
+
+    uint32_t header[10];
+    for (uint32_t& b : header) {
+        if (!readByte(b)) {
+            return false;
+        }
+    }
+    if (header[0] != 0x1f || header[1] != 0x8b) {
+        return fail("Not a gzip file");
+    }
+    if (header[2] != 8) {
+        return fail("Unsupported gzip compression method: " + std::to_string(header[2]));
+    }
+
+    uint32_t flags = header[3];
+    if (flags & 0xE0) {
+        return fail("Reserved gzip header flags are set");
+    }
+
+    uint32_t b = 0;
+    if (flags & 0x04) {  // FEXTRA
+        uint32_t lo = 0;
+        uint32_t hi = 0;
+        if (!readByte(lo) || !readByte(hi)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < (lo | (hi << 8)); ++i) {
+            if (!readByte(b)) {
+                return false;
+            }
+        }
+    }
+    for (uint32_t flag : {0x08u, 0x10u}) {  // FNAME、FCOMMENT：以0结尾的字符串
+        if (flags & flag) {
+            do {
+                if (!readByte(b)) {
+                    return false;
+                }
+            } while (b != 0);
+        }
+    }
+    if (flags & 0x02) {  // FHCRC
+        if (!readByte(b) || !readByte(b)) {
+            return false;
+        }
+    }
+
+    crc = 0;
+    member_size = 0;
+    window_pos = 0;
+    match_length = 0;
+    final_block = false;
+    state = State::BLOCK_HEADER;
+    return true;
+}
+
+bool GzipStream::readBlockHeader() {
+    if (!needBits(3)) {
+        return fail("Unexpected end of compressed data");
+    }
+    final_block = getBits(1) != 0;
+    uint32_t type = getBits(2);
+
+    if (type == 0) {
+        // 未压缩块：跳到字节边界，随后是LEN和NLEN
+        getBits(bit_count & 7);
+        if (!needBits(32)) {
+            return fail("Unexpected end of compressed data");
+        }
+        uint32_t len = getBits(16);
+        uint32_t nlen = getBits(16);
+        if (len != (~nlen & 0xFFFF)) {
+            return fail("Corrupted stored block length");
+        }
+        stored_remaining = len;
+        state = State::STORED;
+        return true;
+    }
+
+    if (type == 1) {
+        uint8_t lengths[288 + 30];
+        std::fill(lengths, lengths + 144, 8);
+        std::fill(lengths + 144, lengths + 256, 9);
+        std::fill(lengths + 256, lengths + 280, 7);
+        std::fill(lengths + 280, lengths + 288, 8);
+        std::fill(lengths + 288, lengths + 318, 5);
+        literal_codes.build(lengths, 288);
+        distance_codes.build(lengths + 288, 30);
+        state = State::HUFFMAN;
+        return true;
+    }
+
+    if (type == 2) {
+        if (!readDynamicTables()) {
+            return false;
+        }
+        state = State::HUFFMAN;
+        return true;
+    }
+
+    return fail("Invalid deflate block type");
+}
+
+bool GzipStream::readDynamicTables() {
+    if (!needBits(14)) {
+        return fail("Unexpected end of compressed data");
+    }
+    int nlen = static_cast<int>(getBits(5)) + 257;
+    int ndist = static_cast<int>(getBits(5)) + 1;
+    int ncode = static_cast<int>(getBits(4)) + 4;
+    if (nlen > 286 || ndist > 30) {
+        return fail("Invalid dynamic block code counts");
+    }
+
+    uint8_t lengths[286 + 30] = {};
+    for (int i = 0; i < ncode; ++i) {
+        if (!needBits(3)) {
+            return fail("Unexpected end of compressed data");
+        }
+        lengths[kCodeLengthOrder[i]] = static_cast<uint8_t>(getBits(3));
+    }
+
+    Huffman length_codes;
+    if (!length_codes.build(lengths, 19)) {
+        return fail("Invalid code length code");
+    }
+
+    // 码长序列，16/17/18为重复码
+    int index = 0;
+    while (index < nlen + ndist) {
+        int symbol = decodeSymbol(length_codes);
+        if (symbol < 0) {
+            return fail("Invalid code length symbol");
+        }
+        if (symbol < 16) {
+            lengths[index++] = static_cast<uint8_t>(symbol);
+            continue;
+        }
+
+        uint8_t value = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (index == 0) {
+                return fail("Code length repeat without previous length");
+            }
+            value = lengths[index - 1];
+            if (!needBits(2)) {
+                return fail("Unexpected end of compressed data");
+            }
+            repeat = 3 + static_cast<int>(getBits(2));
+        } else if (symbol == 17) {
+            if (!needBits(3)) {
+                return fail("Unexpected end of compressed data");
+            }
+            repeat = 3 + static_cast<int>(getBits(3));
+        } else {
+            if (!needBits(7)) {
+                return fail("Unexpected end of compressed data");
+            }
+            repeat = 11 + static_cast<int>(getBits(7));
+        }
+        if (index + repeat > nlen + ndist) {
+            return fail("Code length repeat overflows table");
+        }
+        std::fill(lengths + index, lengths + index + repeat, value);
+        index += repeat;
+    }
+
+    if (lengths[256] == 0) {
+        return fail("Missing end-of-block code");
+    }
+    if (!literal_codes.build(lengths, nlen) || !distance_codes.build(lengths + nlen, ndist)) {
+        return fail("Invalid Huffman code lengths");
+    }
+    return true;
+}
+
+bool GzipStream::readMemberTrailer() {
+    // 尾部从字节边界开始：CRC32与原始长度（模2^32），均为小端序
+    getBits(bit_count & 7);
+    uint32_t trailer[2] = {0, 0};
+    for (uint32_t& value : trailer) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            if (!needBits(8)) {
+                return fail("Unexpected end of gzip trailer");
+            }
+            value |= getBits(8) << shift;
+        }
+    }
+    if (trailer[0] != crc) {
+        return fail("CRC32 mismatch in gzip stream");
+    }
+    if (trailer[1] != member_size) {
+        return fail("Length mismatch in gzip stream");
+    }
+
+    // 后面紧跟另一个gzip成员时继续解压，其余尾随数据忽略（与gzip工具一致）
+    refill();
+    if (bit_count >= 16 && (bit_buffer & 0xFFFF) == 0x8B1F) {
+        state = State::MEMBER_HEADER;
+    } else {
+        state = State::DONE;
+    }
+    return true;
+}
+
+size_t GzipStream::copyStored(unsigned char* out, size_t produced, size_t n) {
+    while (produced < n && stored_remaining > 0) {
+        // 位缓冲区中已预读的字节逐个取出，之后直接从输入缓冲区整段拷贝
+        if (bit_count == 0 && input_pos == input_end && !fillInput()) {
+            fail("Unexpected end of compressed data");
+            return produced;
+        }
+        size_t count;
+        if (bit_count > 0) {
+            out[produced] = static_cast<unsigned char>(getBits(8));
+            count = 1;
+        } else {
+            count = std::min({stored_remaining, n - produced, input_end - input_pos});
+            std::memcpy(out + produced, input.data() + input_pos, count);
+            input_pos += count;
+        }
+
+        // 只有最后32KB会被后续块引用
+        for (size_t i = (count > kWindowSize ? count - kWindowSize : 0); i < count; ++i) {
+            window[(window_pos + i) & kWindowMask] = out[produced + i];
+        }
+        window_pos += count;
+        produced += count;
+        stored_remaining -= count;
+    }
+    if (stored_remaining == 0) {
+        state = final_block ? State::MEMBER_TRAILER : State::BLOCK_HEADER;
+    }
+    return produced;
+}
+
+size_t GzipStream::inflateBlock(unsigned char* out, size_t produced, size_t n) {
+    while (produced < n) {
+        // 先输出上一次未完成的匹配
+        if (match_length > 0) {
+            size_t count = std::min(match_length, n - produced);
+            for (size_t i = 0; i < count; ++i) {
+                unsigned char byte = window[(window_pos - match_distance) & kWindowMask];
+                window[window_pos++ & kWindowMask] = byte;
+                out[produced++] = byte;
+            }
+            match_length -= count;
+            continue;
+        }
+
+        int symbol = decodeSymbol(literal_codes);
+        if (symbol < 0) {
+            fail("Invalid literal/length code");
+            return produced;
+        }
+        if (symbol < 256) {
+            unsigned char byte = static_cast<unsigned char>(symbol);
+            window[window_pos++ & kWindowMask] = byte;
+            out[produced++] = byte;
+            continue;
+        }
+        if (symbol == 256) {
+            state = final_block ? State::MEMBER_TRAILER : State::BLOCK_HEADER;
+            return produced;
+        }
+
+        symbol -= 257;
+        if (symbol >= 29) {
+            fail("Invalid length code");
+            return produced;
+        }
+        if (!needBits(kLengthExtra[symbol])) {
+            fail("Unexpected end of compressed data");
+            return produced;
+        }
+        size_t length = kLengthBase[symbol] + getBits(kLengthExtra[symbol]);
+
+        int dist_symbol = decodeSymbol(distance_codes);
+        if (dist_symbol < 0 || dist_symbol >= 30) {
+            fail("Invalid distance code");
+            return produced;
+        }
+        if (!needBits(kDistanceExtra[dist_symbol])) {
+            fail("Unexpected end of compressed data");
+            return produced;
+        }
+        size_t distance = kDistanceBase[dist_symbol] + getBits(kDistanceExtra[dist_symbol]);
+        if (distance > window_pos) {
+            fail("Distance too far back in compressed data");
+            return produced;
+        }
+
+        match_length = length;
+        match_distance = distance;
+    }
+    return produced;
+}
+
+size_t GzipStream::read(unsigned char* out, size_t n) {
+    size_t produced = 0;
+    size_t member_begin = 0;
+
+    // 已输出的数据计入当前成员的CRC32与长度
+    auto account = [&]() {
+        crc = crc32Update(crc, out + member_begin, produced - member_begin);
+        member_size += static_cast<uint32_t>(produced - member_begin);
+        member_begin = produced;
+    };
+
+    while (produced < n && state != State::DONE && !failed()) {
+        switch (state) {
+        case State::MEMBER_HEADER:
+            readMemberHeader();
+            break;
+        case State::BLOCK_HEADER:
+            readBlockHeader();
+            break;
+        case State::STORED:
+            produced = copyStored(out, produced, n);
+            break;
+        case State::HUFFMAN:
+            produced = inflateBlock(out, produced, n);
+            break;
+        case State::MEMBER_TRAILER:
+            account();
+            readMemberTrailer();
+            break;
+        case State::DONE:
+            break;
+        }
+    }
+
+    account();
+    return produced;
+}
+
+bool GzipStream::readExact(unsigned char* out, size_t n) {
+    return read(out, n) == n;
+}
+
+size_t GzipStream::skipToEnd() {
+    std::vector<unsigned char> scratch(kInputChunk);
+    size_t skipped = 0;
+    while (state != State::DONE && !failed()) {
+        skipped += read(scratch.data(), scratch.size());
+    }
+    return skipped;
+}
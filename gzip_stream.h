@@ -0,0 +1,97 @@
+#ifndef GZIP_STREAM_H
+#define GZIP_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// ========== gzip流式解压 ==========
+// 自带的DEFLATE（RFC 1951）解码器与gzip（RFC 1952）容器解析，不依赖zlib。
+// 压缩数据按块从文件读入，解压结果直接写入调用者的缓冲区，
+// 内部只保留32KB的滑动窗口；支持多成员拼接的gzip文件，并校验每个成员的CRC32与长度
+class GzipStream {
+public:
+    GzipStream();
+
+    bool open(const std::string& filename);
+
+    // 读取最多n字节解压数据，返回实际字节数；返回值小于n表示已到结尾或出错
+    size_t read(unsigned char* out, size_t n);
+    // 恰好读取n字节，不足时返回false
+    bool readExact(unsigned char* out, size_t n);
+    // 解压并丢弃剩余数据以校验文件尾，返回丢弃的字节数
+    size_t skipToEnd();
+
+    bool failed() const { return !error_message.empty(); }
+    const std::string& error() const { return error_message; }
+    bool finished() const { return state == State::DONE; }
+
+private:
+    // 范式Huffman码表：短码查表，长码逐位解码
+    struct Huffman {
+        static constexpr int kFastBits = 10;
+        uint16_t counts[16];
+        uint16_t symbols[288];
+        uint16_t fast[1 << kFastBits];  // (symbol << 4) | 码长，0表示码长超过kFastBits
+
+        bool build(const uint8_t* lengths, int n);
+    };
+
+    enum class State {
+        MEMBER_HEADER,  // 读取gzip成员头
+        BLOCK_HEADER,   // 读取DEFLATE块头
+        STORED,         // 未压缩块
+        HUFFMAN,        // 压缩块
+        MEMBER_TRAILER, // 读取CRC32与原始长度
+        DONE
+    };
+
+    std::ifstream file;
+    std::vector<unsigned char> input;  // 压缩数据的读入缓冲区
+    size_t input_pos = 0;
+    size_t input_end = 0;
+    bool input_eof = false;
+
+    uint64_t bit_buffer = 0;
+    int bit_count = 0;
+
+    State state = State::DONE;
+    bool final_block = false;
+    size_t stored_remaining = 0;
+    Huffman literal_codes;
+    Huffman distance_codes;
+
+    // 滑动窗口与尚未输出完的匹配
+    std::vector<unsigned char> window;
+    size_t window_pos = 0;
+    size_t match_length = 0;
+    size_t match_distance = 0;
+
+    uint32_t crc = 0;
+    uint32_t member_size = 0;
+    std::string error_message;
+
+    bool fail(const std::string& message);
+    bool fillInput();
+    void refill();
+    bool needBits(int n);
+    uint32_t getBits(int n);
+    int decodeSymbol(const Huffman& h);
+
+    bool readMemberHeader();
+    bool readBlockHeader();
+    bool readDynamicTables();
+    bool readMemberTrailer();
+
+    // 解压当前块的数据写入out[produced, n)，返回新的produced
+    size_t copyStored(unsigned char* out, size_t produced, size_t n);
+    size_t inflateBlock(unsigned char* out, size_t produced, size_t n);
+};
+
+// CRC-32（IEEE 802.3，gzip与zlib使用的多项式），与zlib的crc32(crc, buf, len)语义相同，
+// 初值为0，可分段累积
+uint32_t crc32Update(uint32_t crc, const unsigned char* data, size_t size);
+
+#endif // GZIP_STREAM_H
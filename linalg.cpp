@@ -0,0 +1,220 @@
+#include "linalg.h"
+#include "simd.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace linalg {
+
+namespace {
+
+// 寄存器分块：MR×NR个累加器常驻寄存器，微内核由simd模块按指令集与标量类型提供
+constexpr size_t MR = simd::kGemmMR;
+
+// 缓存分块：B的KC×NR微面板（16KB）常驻L1，
+// A的MC×KC块（double为128KB）与打包后的B块KC×NC（double为512KB）常驻L2；float各块字节数减半
+constexpr size_t KC = 256;
+constexpr size_t MC = 64;
+constexpr size_t NC = 256;
+
+void checkDims(bool ok, const char* op) {
+    if (!ok) {
+        throw std::invalid_argument(std::string("Matrix dimension mismatch in ") + op);
+    }
+}
+
+// C = beta·C；beta为0时直接清零，避免传播未初始化内容中的NaN
+template<typename T>
+void scale(BasicMatrixView<T> C, T beta) {
+    if (beta == 1) return;
+    for (size_t i = 0; i < C.rows(); ++i) {
+        T* c = C.row(i);
+        if (beta == 0) {
+            std::fill(c, c + C.cols(), T(0));
+        } else {
+            for (size_t j = 0; j < C.cols(); ++j) c[j] *= beta;
+        }
+    }
+}
+
+template<typename T>
+void scale(T* y, size_t n, T beta) {
+    if (beta == 1) return;
+    if (beta == 0) {
+        std::fill(y, y + n, T(0));
+    } else {
+        for (size_t i = 0; i < n; ++i) y[i] *= beta;
+    }
+}
+
+// 处理不足MR×NR的边角
+template<typename T>
+inline void edgeKernel(size_t mr, size_t nr, size_t kc, const T* A, size_t ars, size_t acs,
+                       const T* B, size_t ldb, T* C, size_t ldc) {
+    for (size_t i = 0; i < mr; ++i) {
+        T* c = C + i * ldc;
+        for (size_t k = 0; k < kc; ++k) {
+            T a = A[i * ars + k * acs];
+            const T* b = B + k * ldb;
+            for (size_t j = 0; j < nr; ++j) {
+                c[j] += a * b[j];
+            }
+        }
+    }
+}
+
+// C[M×N] += op(A)[M×K]·B[K×N]，要求B按行连续
+template<typename T>
+void blockedGemm(size_t M, size_t N, size_t K, const T* A, size_t ars, size_t acs,
+                 const T* B, size_t ldb, T* C, size_t ldc) {
+    constexpr size_t NR = simd::kGemmNR<T>;
+    const auto& micro = simd::kernels<T>().gemmMicro;
+    for (size_t kk = 0; kk < K; kk += KC) {
+        size_t kc = std::min(KC, K - kk);
+        for (size_t ii = 0; ii < M; ii += MC) {
+            size_t mc = std::min(MC, M - ii);
+            for (size_t jj = 0; jj < N; jj += NR) {
+                size_t nr = std::min(NR, N - jj);
+                const T* b = B + kk * ldb + jj;
+                for (size_t i = ii; i < ii + mc; i += MR) {
+                    size_t mr = std::min(MR, ii + mc - i);
+                    const T* a = A + i * ars + kk * acs;
+                    T* c = C + i * ldc + jj;
+                    if (nr == NR) {
+                        micro[mr - 1](kc, a, ars, acs, b, ldb, c, ldc);
+                    } else {
+                        edgeKernel(mr, nr, kc, a, ars, acs, b, ldb, c, ldc);
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<typename T>
+void gemvImpl(BasicMatrixView<const T> A, const T* x, T* y, T beta) {
+    const simd::Kernels<T>& k = simd::kernels<T>();
+    size_t M = A.rows();
+    size_t N = A.cols();
+    size_t i = 0;
+
+    // 一次处理4行，x的每个元素只加载一次
+    for (; i + 4 <= M; i += 4) {
+        const T* rows[4] = {A.row(i), A.row(i + 1), A.row(i + 2), A.row(i + 3)};
+        T s[4];
+        k.dot4(rows, x, N, s);
+        for (size_t r = 0; r < 4; ++r) {
+            y[i + r] = beta == 0 ? s[r] : s[r] + beta * y[i + r];
+        }
+    }
+    for (; i < M; ++i) {
+        T s = k.dot(A.row(i), x, N);
+        y[i] = beta == 0 ? s : s + beta * y[i];
+    }
+}
+
+template<typename T>
+void gemvTImpl(BasicMatrixView<const T> A, const T* x, T* y, T beta) {
+    const simd::Kernels<T>& k = simd::kernels<T>();
+    size_t M = A.rows();
+    size_t N = A.cols();
+    scale(y, N, beta);
+
+    // 按行累加（连续访存），一次合并4行以减少y的读写次数
+    size_t i = 0;
+    for (; i + 4 <= M; i += 4) {
+        const T* rows[4] = {A.row(i), A.row(i + 1), A.row(i + 2), A.row(i + 3)};
+        k.axpy4(rows, x + i, y, N);
+    }
+    for (; i < M; ++i) {
+        k.axpy(x[i], A.row(i), y, N);
+    }
+}
+
+template<typename T>
+void gerImpl(T alpha, const T* x, const T* y, BasicMatrixView<T> A) {
+    const simd::Kernels<T>& k = simd::kernels<T>();
+    for (size_t i = 0; i < A.rows(); ++i) {
+        k.axpy(alpha * x[i], y, A.row(i), A.cols());
+    }
+}
+
+template<typename T>
+void gemmNNImpl(BasicMatrixView<const T> A, BasicMatrixView<const T> B, BasicMatrixView<T> C, T beta) {
+    checkDims(A.cols() == B.rows() && C.rows() == A.rows() && C.cols() == B.cols(), "gemmNN");
+    if (A.rows() == 1) {
+        // 单行退化为 yᵀ = xᵀ·B
+        gemvTImpl<T>(B, A.row(0), C.row(0), beta);
+        return;
+    }
+    scale(C, beta);
+    blockedGemm(C.rows(), C.cols(), A.cols(), A.data(), A.stride(), 1,
+                B.data(), B.stride(), C.data(), C.stride());
+}
+
+template<typename T>
+void gemmNTImpl(BasicMatrixView<const T> A, BasicMatrixView<const T> B, BasicMatrixView<T> C, T beta) {
+    checkDims(A.cols() == B.cols() && C.rows() == A.rows() && C.cols() == B.rows(), "gemmNT");
+    if (A.rows() == 1) {
+        // 单行退化为 y = B·x
+        gemvImpl<T>(B, A.row(0), C.row(0), beta);
+        return;
+    }
+    scale(C, beta);
+
+    // 将Bᵀ按KC×NC分块打包成行连续的缓冲区，再复用NN内核
+    thread_local std::vector<T, AlignedAllocator<T>> packed;
+    packed.resize(KC * NC);
+
+    size_t N = B.rows();
+    size_t K = B.cols();
+    for (size_t jj = 0; jj < N; jj += NC) {
+        size_t nc = std::min(NC, N - jj);
+        for (size_t kk = 0; kk < K; kk += KC) {
+            size_t kc = std::min(KC, K - kk);
+            for (size_t j = 0; j < nc; ++j) {
+                const T* b = B.row(jj + j) + kk;
+                for (size_t k = 0; k < kc; ++k) {
+                    packed[k * nc + j] = b[k];
+                }
+            }
+            blockedGemm(C.rows(), nc, kc, A.data() + kk, A.stride(), 1,
+                        packed.data(), nc, C.data() + jj, C.stride());
+        }
+    }
+}
+
+template<typename T>
+void gemmTNImpl(BasicMatrixView<const T> A, BasicMatrixView<const T> B, BasicMatrixView<T> C, T beta) {
+    checkDims(A.rows() == B.rows() && C.rows() == A.cols() && C.cols() == B.cols(), "gemmTN");
+    if (A.rows() == 1) {
+        // 单样本退化为外积更新
+        scale(C, beta);
+        gerImpl<T>(1, A.row(0), B.row(0), C);
+        return;
+    }
+    scale(C, beta);
+    // Aᵀ(i,k) = A(k,i)：沿i方向连续，沿k方向跨一行
+    blockedGemm(C.rows(), C.cols(), A.rows(), A.data(), 1, A.stride(),
+                B.data(), B.stride(), C.data(), C.stride());
+}
+
+} // namespace
+
+// ========== 双精度与单精度接口 ==========
+
+void gemmNN(ConstMatrixView A, ConstMatrixView B, MatrixView C, double beta) { gemmNNImpl<double>(A, B, C, beta); }
+void gemmNT(ConstMatrixView A, ConstMatrixView B, MatrixView C, double beta) { gemmNTImpl<double>(A, B, C, beta); }
+void gemmTN(ConstMatrixView A, ConstMatrixView B, MatrixView C, double beta) { gemmTNImpl<double>(A, B, C, beta); }
+void gemv(ConstMatrixView A, const double* x, double* y, double beta) { gemvImpl<double>(A, x, y, beta); }
+void gemvT(ConstMatrixView A, const double* x, double* y, double beta) { gemvTImpl<double>(A, x, y, beta); }
+void ger(double alpha, const double* x, const double* y, MatrixView A) { gerImpl<double>(alpha, x, y, A); }
+
+void gemmNN(ConstMatrixViewF A, ConstMatrixViewF B, MatrixViewF C, float beta) { gemmNNImpl<float>(A, B, C, beta); }
+void gemmNT(ConstMatrixViewF A, ConstMatrixViewF B, MatrixViewF C, float beta) { gemmNTImpl<float>(A, B, C, beta); }
+void gemmTN(ConstMatrixViewF A, ConstMatrixViewF B, MatrixViewF C, float beta) { gemmTNImpl<float>(A, B, C, beta); }
+void gemv(ConstMatrixViewF A, const float* x, float* y, float beta) { gemvImpl<float>(A, x, y, beta); }
+void gemvT(ConstMatrixViewF A, const float* x, float* y, float beta) { gemvTImpl<float>(A, x, y, beta); }
+void ger(float alpha, const float* x, const float* y, MatrixViewF A) { gerImpl<float>(alpha, x, y, A); }
+
+} // namespace linalg
@@ -0,0 +1,39 @@
+#ifndef LINALG_H
+#define LINALG_H
+
+#include "matrix.h"
+
+// ========== 稠密线性代数内核 ==========
+// 网络热点循环使用的分块GEMM/GEMV/外积更新。所有矩阵均为行主序，
+// 结果写入C（或y），beta为对原有内容的缩放系数（beta为0时不读取原内容）。
+namespace linalg {
+
+// C = A·B + beta·C        A: M×K, B: K×N, C: M×N
+void gemmNN(ConstMatrixView A, ConstMatrixView B, MatrixView C, double beta = 0.0);
+
+// C = A·Bᵀ + beta·C       A: M×K, B: N×K, C: M×N
+void gemmNT(ConstMatrixView A, ConstMatrixView B, MatrixView C, double beta = 0.0);
+
+// C = Aᵀ·B + beta·C       A: K×M, B: K×N, C: M×N
+void gemmTN(ConstMatrixView A, ConstMatrixView B, MatrixView C, double beta = 0.0);
+
+// y = A·x + beta·y        A: M×N, x: N, y: M
+void gemv(ConstMatrixView A, const double* x, double* y, double beta = 0.0);
+
+// y = Aᵀ·x + beta·y       A: M×N, x: M, y: N
+void gemvT(ConstMatrixView A, const double* x, double* y, double beta = 0.0);
+
+// A += alpha·x·yᵀ         A: M×N, x: M, y: N
+void ger(double alpha, const double* x, const double* y, MatrixView A);
+
+// 单精度版本，分块尺寸相同，微内核每行处理的列数加倍
+void gemmNN(ConstMatrixViewF A, ConstMatrixViewF B, MatrixViewF C, float beta = 0.0f);
+void gemmNT(ConstMatrixViewF A, ConstMatrixViewF B, MatrixViewF C, float beta = 0.0f);
+void gemmTN(ConstMatrixViewF A, ConstMatrixViewF B, MatrixViewF C, float beta = 0.0f);
+void gemv(ConstMatrixViewF A, const float* x, float* y, float beta = 0.0f);
+void gemvT(ConstMatrixViewF A, const float* x, float* y, float beta = 0.0f);
+void ger(float alpha, const float* x, const float* y, MatrixViewF A);
+
+} // namespace linalg
+
+#endif // LINALG_H
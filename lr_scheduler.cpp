@@ -0,0 +1,94 @@
+#include "lr_scheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// 按余弦从start过渡到end，progress在[0, 1]
+double cosineBetween(double start, double end, double progress) {
+    return end + (start - end) * 0.5 * (1.0 + std::cos(kPi * progress));
+}
+
+} // namespace
+
+const char* lrScheduleTypeName(LRScheduleType type) {
+    switch (type) {
+        case LRScheduleType::CONSTANT: return "constant";
+        case LRScheduleType::STEP_DECAY: return "step decay";
+        case LRScheduleType::COSINE: return "cosine";
+        case LRScheduleType::ONE_CYCLE: return "one-cycle";
+    }
+    return "unknown";
+}
+
+void LRScheduler::validate(const LRScheduleConfig& config) {
+    switch (config.type) {
+        case LRScheduleType::CONSTANT:
+            break;
+        case LRScheduleType::STEP_DECAY:
+            if (config.step_size == 0 || !(config.gamma > 0 && config.gamma <= 1)) {
+                throw std::invalid_argument("Invalid step decay schedule");
+            }
+            break;
+        case LRScheduleType::COSINE:
+            if (!(config.min_lr >= 0)) {
+                throw std::invalid_argument("Invalid cosine schedule");
+            }
+            break;
+        case LRScheduleType::ONE_CYCLE:
+            if (config.warmup_steps != 0 || !(config.pct_start > 0 && config.pct_start < 1) ||
+                !(config.div_factor >= 1) || !(config.final_div_factor >= 1)) {
+                throw std::invalid_argument("Invalid one-cycle schedule");
+            }
+            break;
+        default:
+            throw std::invalid_argument("Unknown learning rate schedule");
+    }
+}
+
+LRScheduler::LRScheduler(const LRScheduleConfig& config, double peak_lr, uint64_t total_steps)
+    : config(config), peak_lr(peak_lr), total_steps(total_steps) {
+    validate(config);
+    if (!(peak_lr > 0)) {
+        throw std::invalid_argument("Peak learning rate must be positive");
+    }
+    if (config.type == LRScheduleType::COSINE && config.min_lr > peak_lr) {
+        throw std::invalid_argument("Cosine schedule min_lr exceeds the peak learning rate");
+    }
+}
+
+double LRScheduler::learningRate(uint64_t step) const {
+    // 线性预热：第0步为峰值/warmup_steps，第warmup_steps-1步达到峰值
+    if (step < config.warmup_steps) {
+        return peak_lr * static_cast<double>(step + 1) / static_cast<double>(config.warmup_steps);
+    }
+    uint64_t t = step - config.warmup_steps;
+    uint64_t decay_steps = total_steps > config.warmup_steps ? total_steps - config.warmup_steps : 1;
+    double progress = std::min(1.0, static_cast<double>(t) / static_cast<double>(decay_steps));
+
+    switch (config.type) {
+        case LRScheduleType::STEP_DECAY:
+            return peak_lr * std::pow(config.gamma, static_cast<double>(t / config.step_size));
+        case LRScheduleType::COSINE:
+            return cosineBetween(peak_lr, config.min_lr, progress);
+        case LRScheduleType::ONE_CYCLE: {
+            double initial = peak_lr / config.div_factor;
+            double final_lr = initial / config.final_div_factor;
+            // 上升阶段至少1步；以步数计，最后一步取到final_lr
+            double rise = std::max(1.0, config.pct_start * static_cast<double>(total_steps));
+            double last = std::max(rise, static_cast<double>(total_steps) - 1.0);
+            double s = static_cast<double>(step);
+            if (s < rise) {
+                return cosineBetween(initial, peak_lr, s / rise);
+            }
+            double fall = last > rise ? (std::min(s, last) - rise) / (last - rise) : 1.0;
+            return cosineBetween(peak_lr, final_lr, fall);
+        }
+        case LRScheduleType::CONSTANT:
+        default:
+            return peak_lr;
+    }
+}
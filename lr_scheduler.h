@@ -0,0 +1,59 @@
+#ifndef LR_SCHEDULER_H
+#define LR_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 学习率调度方式（数值写入检查点，只能在末尾追加）
+enum class LRScheduleType {
+    CONSTANT,    // 固定为峰值学习率
+    STEP_DECAY,  // 每step_size步乘以gamma
+    COSINE,      // 按余弦从峰值退火到min_lr
+    ONE_CYCLE    // 先从峰值/div_factor按余弦升到峰值，再按余弦降到峰值/(div_factor·final_div_factor)
+};
+
+// 学习率调度参数，步数以训练批为单位（Hogwild按处理的样本数折算成批）。
+// 峰值学习率为优化器设置的学习率；warmup_steps > 0 时先从0线性升到峰值，之后再按type变化
+struct LRScheduleConfig {
+    LRScheduleType type = LRScheduleType::CONSTANT;
+    size_t warmup_steps = 0;         // 线性预热的步数；ONE_CYCLE自带上升阶段，须为0
+    size_t step_size = 1000;         // STEP_DECAY：衰减间隔
+    double gamma = 0.1;              // STEP_DECAY：每次衰减的倍数，(0, 1]
+    double min_lr = 0.0;             // COSINE：退火的终点
+    double pct_start = 0.3;          // ONE_CYCLE：上升阶段占总步数的比例，(0, 1)
+    double div_factor = 25.0;        // ONE_CYCLE：起点为 峰值/div_factor
+    double final_div_factor = 1e4;   // ONE_CYCLE：终点为 起点/final_div_factor
+
+    // 是否不改变学习率（固定且没有预热）
+    bool constant() const { return type == LRScheduleType::CONSTANT && warmup_steps == 0; }
+};
+
+// ========== 学习率调度器 ==========
+// 学习率只由步数决定，不保存中间状态：从检查点恢复时给出相同的配置、峰值与总步数，
+// 并从保存的步数继续，即可得到与不中断训练相同的学习率序列
+class LRScheduler {
+private:
+    LRScheduleConfig config;
+    double peak_lr = 0.0;
+    uint64_t total_steps = 0;
+
+public:
+    LRScheduler() = default;
+    // total_steps为整个训练的步数（COSINE与ONE_CYCLE据此安排退火）；参数不合法时抛出invalid_argument
+    LRScheduler(const LRScheduleConfig& config, double peak_lr, uint64_t total_steps);
+
+    // 检查配置本身是否合法，不合法时抛出invalid_argument
+    static void validate(const LRScheduleConfig& config);
+
+    // 第step步（从0开始）的学习率；超过总步数后保持最后的值
+    double learningRate(uint64_t step) const;
+
+    const LRScheduleConfig& getConfig() const { return config; }
+    double getPeakLearningRate() const { return peak_lr; }
+    uint64_t getTotalSteps() const { return total_steps; }
+};
+
+// 调度方式名称，用于打印
+const char* lrScheduleTypeName(LRScheduleType type);
+
+#endif // LR_SCHEDULER_H
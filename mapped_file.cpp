@@ -0,0 +1,144 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+size_t physicalMemorySize() {
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (!GlobalMemoryStatusEx(&status)) {
+        return 0;
+    }
+    return static_cast<size_t>(status.ullTotalPhys);
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    file_handle = file;
+    mapping_handle = mapping;
+    ptr = static_cast<const unsigned char*>(view);
+    length = static_cast<size_t>(file_size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (ptr) {
+        UnmapViewOfFile(ptr);
+    }
+    if (mapping_handle) {
+        CloseHandle(mapping_handle);
+    }
+    if (file_handle) {
+        CloseHandle(file_handle);
+    }
+    ptr = nullptr;
+    length = 0;
+    mapping_handle = nullptr;
+    file_handle = nullptr;
+}
+
+#else
+
+size_t physicalMemorySize() {
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGE_SIZE);
+    if (pages <= 0 || page_size <= 0) {
+        return 0;
+    }
+    return static_cast<size_t>(pages) * static_cast<size_t>(page_size);
+}
+
+namespace {
+
+// 是否值得预读整个文件：超出内存的文件预读只会把已读入的页挤出去
+bool shouldPrefetch(size_t file_size) {
+    size_t memory = physicalMemorySize();
+    return memory == 0 || file_size <= memory / 2;
+}
+
+} // namespace
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // 映射建立后即可关闭文件描述符
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+
+    // 训练时按打乱的顺序随机访问样本，放得下时提示内核提前读入整个文件
+    if (shouldPrefetch(static_cast<size_t>(st.st_size))) {
+        madvise(view, static_cast<size_t>(st.st_size), MADV_WILLNEED);
+    }
+
+    ptr = static_cast<const unsigned char*>(view);
+    length = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (ptr) {
+        munmap(const_cast<unsigned char*>(ptr), length);
+    }
+    ptr = nullptr;
+    length = 0;
+}
+
+#endif
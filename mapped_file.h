@@ -0,0 +1,39 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// ========== 只读内存映射文件 ==========
+// POSIX下使用mmap，Windows下使用CreateFileMapping/MapViewOfFile。
+// 映射后文件内容按需分页载入，不占用额外的堆内存
+class MappedFile {
+private:
+    const unsigned char* ptr = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 映射整个文件，失败（文件不存在、为空或不支持映射）时返回false。
+    // POSIX下文件不超过物理内存的一半时提示系统预读整个文件，更大的文件按需分页
+    bool open(const std::string& filename);
+    void close();
+
+    bool isOpen() const { return ptr != nullptr; }
+    const unsigned char* data() const { return ptr; }
+    size_t size() const { return length; }
+};
+
+// 物理内存大小（字节），无法获取时返回0
+size_t physicalMemorySize();
+
+#endif // MAPPED_FILE_H
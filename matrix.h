@@ -0,0 +1,157 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <stdexcept>
+#include <string>
+
+// ========== 对齐分配器 ==========
+// 保证缓冲区起始地址按缓存行（64字节）对齐
+template<typename T, std::size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template<typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() noexcept = default;
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n == 0) return nullptr;
+        void* p = ::operator new(n * sizeof(T), std::align_val_t(Alignment));
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t) noexcept {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+};
+
+// ========== 矩阵视图 ==========
+// 不拥有数据的行主序矩阵视图，行与行之间相隔stride个元素
+template<typename T>
+class BasicMatrixView {
+private:
+    T* ptr;
+    std::size_t num_rows;
+    std::size_t num_cols;
+    std::size_t row_stride;
+
+public:
+    BasicMatrixView() : ptr(nullptr), num_rows(0), num_cols(0), row_stride(0) {}
+    BasicMatrixView(T* data, std::size_t rows, std::size_t cols, std::size_t stride)
+        : ptr(data), num_rows(rows), num_cols(cols), row_stride(stride) {}
+
+    // 允许从可写视图隐式转换为只读视图
+    template<typename U, typename = typename std::enable_if<
+        std::is_same<const U, T>::value && !std::is_same<U, T>::value>::type>
+    BasicMatrixView(const BasicMatrixView<U>& other)
+        : ptr(other.data()), num_rows(other.rows()), num_cols(other.cols()), row_stride(other.stride()) {}
+
+    T* data() const { return ptr; }
+    std::size_t rows() const { return num_rows; }
+    std::size_t cols() const { return num_cols; }
+    std::size_t stride() const { return row_stride; }
+    bool empty() const { return num_rows == 0 || num_cols == 0; }
+
+    T* row(std::size_t i) const { return ptr + i * row_stride; }
+    T& operator()(std::size_t i, std::size_t j) const { return ptr[i * row_stride + j]; }
+
+    // 取出[first, first + count)行组成的子视图
+    BasicMatrixView rowRange(std::size_t first, std::size_t count) const {
+        return BasicMatrixView(ptr + first * row_stride, count, num_cols, row_stride);
+    }
+};
+
+// ========== 矩阵 ==========
+// 单块连续、64字节对齐的行主序存储；每行按缓存行补齐，保证每行起点同样对齐
+template<typename T>
+class BasicMatrix {
+public:
+    static constexpr std::size_t kAlignment = 64;
+    static constexpr std::size_t kRowAlignElems = kAlignment / sizeof(T);
+
+private:
+    std::vector<T, AlignedAllocator<T, kAlignment>> storage;
+    std::size_t num_rows;
+    std::size_t num_cols;
+    std::size_t row_stride;
+
+public:
+    BasicMatrix() : num_rows(0), num_cols(0), row_stride(0) {}
+    BasicMatrix(std::size_t rows, std::size_t cols, T value = T()) : num_rows(0), num_cols(0), row_stride(0) {
+        resize(rows, cols, value);
+    }
+
+    static std::size_t paddedStride(std::size_t cols) {
+        return (cols + kRowAlignElems - 1) / kRowAlignElems * kRowAlignElems;
+    }
+
+    // 重新分配并以value填充（原内容不保留），补齐部分始终为0
+    void resize(std::size_t rows, std::size_t cols, T value = T()) {
+        num_rows = rows;
+        num_cols = cols;
+        row_stride = paddedStride(cols);
+        storage.assign(rows * row_stride, T());
+        if (value != T()) fill(value);
+    }
+
+    void fill(T value) {
+        for (std::size_t i = 0; i < num_rows; ++i) {
+            std::fill(row(i), row(i) + num_cols, value);
+        }
+    }
+
+    // 逐行拷贝，维度必须一致
+    void assign(BasicMatrixView<const T> src) {
+        if (src.rows() != num_rows || src.cols() != num_cols) {
+            throw std::invalid_argument("Matrix dimension mismatch. Expected: " +
+                                      std::to_string(num_rows) + "x" + std::to_string(num_cols) +
+                                      ", Got: " + std::to_string(src.rows()) + "x" +
+                                      std::to_string(src.cols()));
+        }
+        for (std::size_t i = 0; i < num_rows; ++i) {
+            std::copy(src.row(i), src.row(i) + num_cols, row(i));
+        }
+    }
+
+    std::size_t rows() const { return num_rows; }
+    std::size_t cols() const { return num_cols; }
+    std::size_t stride() const { return row_stride; }
+    bool empty() const { return num_rows == 0 || num_cols == 0; }
+
+    T* data() { return storage.data(); }
+    const T* data() const { return storage.data(); }
+    T* row(std::size_t i) { return storage.data() + i * row_stride; }
+    const T* row(std::size_t i) const { return storage.data() + i * row_stride; }
+    T& operator()(std::size_t i, std::size_t j) { return storage[i * row_stride + j]; }
+    const T& operator()(std::size_t i, std::size_t j) const { return storage[i * row_stride + j]; }
+
+    BasicMatrixView<T> view() { return BasicMatrixView<T>(data(), num_rows, num_cols, row_stride); }
+    BasicMatrixView<const T> view() const { return BasicMatrixView<const T>(data(), num_rows, num_cols, row_stride); }
+
+    operator BasicMatrixView<T>() { return view(); }
+    operator BasicMatrixView<const T>() const { return view(); }
+};
+
+using Matrix = BasicMatrix<double>;
+using MatrixView = BasicMatrixView<double>;
+using ConstMatrixView = BasicMatrixView<const double>;
+
+using MatrixF = BasicMatrix<float>;
+using MatrixViewF = BasicMatrixView<float>;
+using ConstMatrixViewF = BasicMatrixView<const float>;
+
+#endif // MATRIX_H
@@ -10,6 +10,17 @@ SOURCES += \
     main.cpp \
     mitenetworkmodel.cpp \
     bpnn.cpp \
+    linalg.cpp \
+    simd.cpp \
+    thread_pool.cpp \
+    mapped_file.cpp \
+    gzip_stream.cpp \
+    batch_pipeline.cpp \
+    augmentation.cpp \
+    model_format.cpp \
+    checkpoint.cpp \
+    lr_scheduler.cpp \
+    quantization.cpp \
     mnist_classifier.cpp \
     mnist_reader.cpp \
     mnistmodel.cpp
@@ -17,6 +28,19 @@ SOURCES += \
 HEADERS += \
     mitenetworkmodel.h \
     bpnn.h \
+    matrix.h \
+    linalg.h \
+    simd.h \
+    simd_kernels.inl \
+    thread_pool.h \
+    mapped_file.h \
+    gzip_stream.h \
+    batch_pipeline.h \
+    augmentation.h \
+    model_format.h \
+    checkpoint.h \
+    lr_scheduler.h \
+    quantization.h \
     mnist_classifier.h \
     mnist_reader.h \
     mnistmodel.h
@@ -121,8 +121,12 @@ void MiteNetworkModel::trainNetworkAsync()
         return;
     }
 
-    // 训练一个batch
-    double loss = m_network->trainBatch(m_trainingInputs, m_trainingTargets);
+    // 逐样本训练一个epoch（样本很少，在线SGD收敛更快）
+    double loss = 0.0;
+    for (size_t i = 0; i < m_trainingInputs.size(); ++i) {
+        loss += m_network->train(m_trainingInputs[i], m_trainingTargets[i]);
+    }
+    loss /= m_trainingInputs.size();
     m_currentEpoch++;
 
     // 每50个epoch更新状态 (更频繁的更新)
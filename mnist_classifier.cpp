@@ -3,32 +3,228 @@
 #include <random>
 #include <algorithm>
 #include <iomanip>
+#include <cmath>
+
+namespace {
+
+// 概率最大的类别
+template<typename T>
+int argmax(const T* probabilities, size_t n) {
+    int predicted_class = 0;
+    T max_prob = probabilities[0];
+    
+    for (size_t i = 1; i < n; ++i) {
+        if (probabilities[i] > max_prob) {
+            max_prob = probabilities[i];
+            predicted_class = i;
+        }
+    }
+    
+    return predicted_class;
+}
+
+} // namespace
 
 MNISTClassifier::MNISTClassifier(double learning_rate) 
-    : network(learning_rate, LossType::CROSS_ENTROPY), input_size(784), output_size(10) {
+    : network(learning_rate, LossType::CROSS_ENTROPY), input_size(784), output_size(10),
+      rng(std::random_device{}()), training_mode(TrainingMode::SYNCHRONOUS),
+      pipeline(std::make_unique<BatchPipeline>()), augmentation_enabled(false), augmentation_seed(0),
+      optimizer_type(OptimizerType::ADAM), optimizer_learning_rate(0.001), schedule_step(0),
+      validation_enabled(false), checkpoint_interval(0) {
+    network.setNumThreads(0);
+}
+
+void MNISTClassifier::setPrefetch(size_t queue_depth, size_t num_workers) {
+    pipeline = std::make_unique<BatchPipeline>(queue_depth, num_workers);
+}
+
+void MNISTClassifier::createAugmenter(const MNISTData& data) {
+    augmenter.reset();
+    if (!augmentation_enabled || !augmentation.enabled()) {
+        return;
+    }
+    if (data.sample_shape.size() != 2) {
+        std::cerr << "Warning: Augmentation needs 2-D images, training without augmentation" << std::endl;
+        return;
+    }
+    augmenter = std::make_unique<Augmenter>(augmentation, data.image_rows, data.image_cols);
+}
+
+void MNISTClassifier::updateAugmentation() {
+    if (!augmenter) {
+        pipeline->setTransform(nullptr);
+        return;
+    }
+    
+    uint64_t seed = rng();
+    seed = (seed << 32) | rng();
+    setAugmentationSeed(seed);
+}
+
+void MNISTClassifier::setAugmentationSeed(uint64_t seed) {
+    augmentation_seed = seed;
+    if (!augmenter) {
+        pipeline->setTransform(nullptr);
+        return;
+    }
+    
+    const Augmenter* aug = augmenter.get();
+    pipeline->setTransform([aug, seed](PreparedBatch& batch) {
+        aug->apply(batch.inputs.view().rowRange(0, batch.count), batch.indices, batch.count, seed);
+    });
+}
+
+void MNISTClassifier::createScheduler(double peak_learning_rate, uint64_t total_steps) {
+    scheduler.reset();
+    schedule_step = 0;
+    if (lr_schedule.constant()) {
+        return;
+    }
+    scheduler = std::make_unique<LRScheduler>(lr_schedule, peak_learning_rate, total_steps);
+    
+    const LRScheduleConfig& config = scheduler->getConfig();
+    std::ios_base::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << "LR schedule: " << lrScheduleTypeName(config.type) << ", peak " << std::scientific
+              << std::setprecision(3) << peak_learning_rate << ", warmup " << config.warmup_steps << " of " << total_steps
+              << " steps" << std::endl;
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
+
+void MNISTClassifier::applySchedule(uint64_t step) {
+    if (scheduler) {
+        network.setLearningRate(scheduler->learningRate(step));
+    }
+}
+
+void MNISTClassifier::setValidation(const ValidationConfig& config, bool enabled) {
+    if (!(config.fraction > 0 && config.fraction < 1) || config.patience < 0 || !(config.min_delta >= 0)) {
+        throw std::invalid_argument("Invalid validation config");
+    }
+    validation = config;
+    validation_enabled = enabled;
+}
+
+void MNISTClassifier::setCheckpointing(const std::string& prefix, int every_batches, size_t keep_last) {
+    checkpoint_writer.reset();
+    checkpoint_interval = std::max(every_batches, 0);
+    if (!prefix.empty()) {
+        checkpoint_writer = std::make_unique<CheckpointWriter>(prefix, keep_last);
+    }
+}
+
+bool MNISTClassifier::resumeFrom(const std::string& checkpoint_path) {
+    std::unique_ptr<TrainingCheckpoint> state(new TrainingCheckpoint());
+    if (!readCheckpoint(checkpoint_path, *state)) {
+        return false;
+    }
+    if (state->training_mode > static_cast<uint32_t>(TrainingMode::HOGWILD) || state->network.layers.empty()) {
+        std::cerr << "Error: Invalid checkpoint contents: " << checkpoint_path << std::endl;
+        return false;
+    }
+    
+    try {
+        network.restoreState(state->network);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "Error: " << e.what() << ": " << checkpoint_path << std::endl;
+        return false;
+    }
+    input_size = static_cast<int>(network.getInputSize());
+    output_size = static_cast<int>(network.getOutputSize());
+    rng = state->rng;
+    training_mode = static_cast<TrainingMode>(state->training_mode);
+    
+    // 参数已恢复到网络中，只保留训练进度
+    state->network.layers.clear();
+    std::cout << "Resumed from checkpoint: " << checkpoint_path << " (epoch " << (state->epoch + 1)
+              << ", batch " << state->next_batch << ")" << std::endl;
+    resume_state = std::move(state);
+    return true;
+}
+
+void MNISTClassifier::saveCheckpoint(const std::vector<int>& order, const EpochProgress& progress,
+                                     int batch_size) {
+    std::unique_ptr<TrainingCheckpoint> checkpoint = checkpoint_writer->acquire();
+    network.snapshotState(checkpoint->network);
+    
+    uint64_t batches_per_epoch = (order.size() + batch_size - 1) / batch_size;
+    checkpoint->step = static_cast<uint64_t>(progress.epoch) * batches_per_epoch + progress.next_batch;
+    checkpoint->epoch = static_cast<uint32_t>(progress.epoch);
+    checkpoint->next_batch = progress.next_batch;
+    checkpoint->batch_size = static_cast<uint64_t>(batch_size);
+    checkpoint->epoch_loss_sum = progress.loss_sum;
+    checkpoint->epoch_batches = progress.batches;
+    checkpoint->previous_loss = progress.previous_loss;
+    checkpoint->best_validation_loss = progress.best_loss;
+    checkpoint->best_epoch = static_cast<uint32_t>(progress.best_epoch);
+    checkpoint->stale_epochs = static_cast<uint32_t>(progress.stale_epochs);
+    checkpoint->training_mode = static_cast<uint32_t>(training_mode);
+    checkpoint->augmentation_seed = augmentation_seed;
+    if (scheduler) {
+        checkpoint->lr_schedule = scheduler->getConfig();
+        checkpoint->peak_learning_rate = scheduler->getPeakLearningRate();
+        checkpoint->schedule_total_steps = scheduler->getTotalSteps();
+    } else {
+        checkpoint->lr_schedule = LRScheduleConfig();
+        checkpoint->peak_learning_rate = 0.0;
+        checkpoint->schedule_total_steps = 0;
+    }
+    checkpoint->order.assign(order.begin(), order.end());
+    checkpoint->rng = rng;
+    
+    checkpoint_writer->submit(std::move(checkpoint));
+}
+
+void MNISTClassifier::setSeed(unsigned seed) {
+    rng.seed(seed);
+    network.setSeed(seed);
 }
 
 void MNISTClassifier::buildNetwork() {
-    // 构建网络结构：784 -> 128 -> 64 -> 10
-    network.addLayer(128, ActivationType::RELU);    // 隐藏层1
-    network.addLayer(64, ActivationType::RELU);     // 隐藏层2  
-    network.addLayer(10, ActivationType::SOFTMAX);  // 输出层
+    // 构建网络结构：输入 -> 128 -> 64 -> 类别数（MNIST为784 -> 128 -> 64 -> 10）
+    network.addLayer(128, ActivationType::RELU);             // 隐藏层1
+    network.addLayer(64, ActivationType::RELU);              // 隐藏层2  
+    network.addLayer(output_size, ActivationType::SOFTMAX);  // 输出层
     
-    // 使用Adam优化器
-    network.setOptimizer(OptimizerType::ADAM, 0.001);
+    // 默认使用Adam优化器（见setOptimizer）
+    network.setOptimizer(optimizer_type, optimizer_learning_rate, optimizer_config);
+    network.setInputSize(input_size);
     
     std::cout << "Network architecture built:" << std::endl;
     network.printNetworkInfo();
 }
 
+void MNISTClassifier::buildNetwork(const MNISTData& data) {
+    input_size = static_cast<int>(data.imageSize());
+    output_size = data.num_classes;
+    buildNetwork();
+}
+
+bool MNISTClassifier::checkDataShape(const MNISTData& data) const {
+    if (data.imageSize() != static_cast<size_t>(input_size)) {
+        std::cerr << "Error: Image size " << data.imageSize() 
+                  << " does not match network input size " << input_size << std::endl;
+        return false;
+    }
+    if (data.num_classes > output_size) {
+        std::cerr << "Error: Data has " << data.num_classes
+                  << " classes but the network only has " << output_size << " outputs" << std::endl;
+        return false;
+    }
+    return true;
+}
+
 void MNISTClassifier::train(const MNISTData& train_data, int epochs, int batch_size) {
+    if (!checkDataShape(train_data)) {
+        return;
+    }
+    
     std::cout << "Starting training..." << std::endl;
-    std::cout << "Training samples: " << train_data.num_images << std::endl;
     std::cout << "Epochs: " << epochs << std::endl;
     std::cout << "Batch size: " << batch_size << std::endl;
-    
-    // 转换标签为one-hot编码
-    auto one_hot_labels = MNISTReader::labelsToOneHot(train_data.labels);
+    std::cout << "Threads: " << network.getNumThreads() << std::endl;
+    std::cout << "Mode: " << (training_mode == TrainingMode::HOGWILD ? "Hogwild" : "Synchronous") << std::endl;
     
     // 创建训练索引
     std::vector<int> indices(train_data.num_images);
@@ -36,80 +232,456 @@ void MNISTClassifier::train(const MNISTData& train_data, int epochs, int batch_s
         indices[i] = i;
     }
     
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    // 一次性分配训练缓冲区，之后的训练步不再分配内存
+    network.reserveWorkspace(batch_size);
+    pipeline->resetStats();
+    createAugmenter(train_data);
+    if (augmenter) {
+        std::cout << "Augmentation: shift " << augmentation.max_shift << "px, rotation "
+                  << augmentation.max_rotation << " deg, scale " << augmentation.max_scale
+                  << ", elastic " << augmentation.elastic_alpha << "px, noise "
+                  << augmentation.noise_stddev << std::endl;
+    }
+    
+    // 从检查点继续：沿用保存的样本顺序与进度，随机数发生器已由resumeFrom恢复。
+    // 检查点只保存训练部分的顺序，其余样本即为验证集
+    bool validating = validation_enabled && train_data.num_images >= 2;
+    std::vector<int> validation_indices;
+    double peak_learning_rate = optimizer_learning_rate;
+    uint64_t total_steps = 0;
+    EpochProgress progress;
+    if (resume_state) {
+        const TrainingCheckpoint& state = *resume_state;
+        bool valid = validating ? state.order.size() < indices.size() : state.order.size() == indices.size();
+        std::vector<char> in_order(indices.size(), 0);
+        for (size_t i = 0; valid && i < state.order.size(); ++i) {
+            valid = state.order[i] >= 0 && state.order[i] < train_data.num_images && !in_order[state.order[i]];
+            if (valid) {
+                in_order[state.order[i]] = 1;
+            }
+        }
+        if (!valid) {
+            std::cerr << "Error: Checkpoint does not match the training data" << std::endl;
+            return;
+        }
+        for (int i = 0; validating && i < train_data.num_images; ++i) {
+            if (!in_order[i]) {
+                validation_indices.push_back(i);
+            }
+        }
+        if (state.next_batch > 0 && state.batch_size != static_cast<uint64_t>(batch_size)) {
+            std::cerr << "Error: Checkpoint was saved with batch size " << state.batch_size << std::endl;
+            return;
+        }
+        indices = state.order;
+        progress.epoch = static_cast<int>(state.epoch);
+        progress.next_batch = static_cast<size_t>(state.next_batch);
+        progress.loss_sum = state.epoch_loss_sum;
+        progress.batches = static_cast<size_t>(state.epoch_batches);
+        progress.previous_loss = state.previous_loss;
+        progress.best_loss = state.best_validation_loss;
+        progress.best_epoch = static_cast<int>(state.best_epoch);
+        progress.stale_epochs = static_cast<int>(state.stale_epochs);
+        augmentation_seed = state.augmentation_seed;
+        // 沿用保存的学习率调度，续训的学习率序列与不中断时相同
+        lr_schedule = state.lr_schedule;
+        peak_learning_rate = state.peak_learning_rate;
+        total_steps = state.schedule_total_steps;
+        std::cout << "Resuming at epoch " << (progress.epoch + 1) << ", batch " << progress.next_batch << std::endl;
+        resume_state.reset();
+    } else if (validating) {
+        // 随机划出验证集，按下标排序后批量评估时顺序读取
+        size_t count = static_cast<size_t>(std::lround(validation.fraction * train_data.num_images));
+        count = std::min(std::max<size_t>(count, 1), indices.size() - 1);
+        std::shuffle(indices.begin(), indices.end(), rng);
+        validation_indices.assign(indices.end() - count, indices.end());
+        indices.resize(indices.size() - count);
+        std::sort(validation_indices.begin(), validation_indices.end());
+    }
+    std::cout << "Training samples: " << indices.size() << std::endl;
+    if (validating) {
+        std::cout << "Validation samples: " << validation_indices.size() << " (patience "
+                  << validation.patience << ")" << std::endl;
+    }
+    
+    uint64_t batches_per_epoch = (indices.size() + batch_size - 1) / batch_size;
+    if (total_steps == 0) {
+        total_steps = static_cast<uint64_t>(epochs) * batches_per_epoch;
+    }
+    createScheduler(peak_learning_rate, total_steps);
+    
+    // Hogwild模式下损失超过 上一epoch损失×kDivergenceFactor + kDivergenceMargin 即视为发散
+    constexpr double kDivergenceFactor = 1.5;
+    constexpr double kDivergenceMargin = 0.05;
+    ParameterSnapshotF snapshot;
+    
+    // Hogwild收敛检查：每个epoch前后用串行的批量推理在固定样本上计算损失并比较，
+    // 不依赖无锁更新过程中统计的损失。有验证集时使用验证集，否则从训练数据中均匀抽取
+    std::vector<int> check_indices;
+    double serial_loss = std::numeric_limits<double>::quiet_NaN();  // 当前参数在check_indices上的损失
+    if (training_mode == TrainingMode::HOGWILD) {
+        if (validating) {
+            check_indices = validation_indices;
+        } else {
+            constexpr size_t kCheckSamples = 1000;
+            size_t total = static_cast<size_t>(train_data.num_images);
+            check_indices.resize(std::min(kCheckSamples, total));
+            for (size_t i = 0; i < check_indices.size(); ++i) {
+                check_indices[i] = static_cast<int>(i * total / check_indices.size());
+            }
+        }
+    }
+    ParameterSnapshotF best_parameters;  // 验证损失最低时的参数
     
+    for (int epoch = progress.epoch; epoch < epochs; ++epoch) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        progress.epoch = epoch;
+        schedule_step = static_cast<uint64_t>(epoch) * batches_per_epoch + progress.next_batch;
+        double previous_loss = progress.previous_loss;
+        
+        if (progress.next_batch == 0) {
+            // 打乱训练数据
+            std::shuffle(indices.begin(), indices.end(), rng);
+            updateAugmentation();
+        } else {
+            setAugmentationSeed(augmentation_seed);
+        }
+        
+        double avg_loss;
+        ValidationResult hogwild_check;
+        bool hogwild_checked = false;
+        if (training_mode == TrainingMode::HOGWILD) {
+            if (!std::isfinite(serial_loss)) {
+                serial_loss = validate(train_data, check_indices).loss;
+            }
+            // 记录epoch开始前的参数，异步更新发散时回滚
+            network.snapshotParameters(snapshot);
+            avg_loss = trainEpochHogwild(train_data, indices, batch_size);
+            
+            // 串行推理在固定样本上的损失明显高于epoch开始前，或Hogwild自身统计的损失
+            // 出现非有限值、明显高于上一epoch时视为发散，回滚本epoch并在剩余的训练中改用同步训练
+            hogwild_check = validate(train_data, check_indices);
+            bool diverged = !std::isfinite(avg_loss) || !std::isfinite(hogwild_check.loss) ||
+                            hogwild_check.loss > kDivergenceFactor * serial_loss + kDivergenceMargin ||
+                            (epoch > 0 && avg_loss > kDivergenceFactor * previous_loss + kDivergenceMargin);
+            if (diverged) {
+                std::cerr << "Warning: Hogwild training diverged (loss " << avg_loss << ", serial check loss "
+                          << serial_loss << " -> " << hogwild_check.loss << "), rolling back epoch " << (epoch + 1)
+                          << " and switching to synchronous training" << std::endl;
+                network.restoreParameters(snapshot);
+                training_mode = TrainingMode::SYNCHRONOUS;
+                avg_loss = trainEpochSynchronous(train_data, indices, batch_size, &progress);
+            } else {
+                serial_loss = hogwild_check.loss;
+                hogwild_checked = true;
+            }
+        } else {
+            avg_loss = trainEpochSynchronous(train_data, indices, batch_size, &progress);
+        }
+        
+        // 在验证集上评估，损失改善时记下参数
+        ValidationResult validation_result;
+        if (validating) {
+            // Hogwild检查已在验证集上评估过当前参数
+            validation_result = hogwild_checked ? hogwild_check : validate(train_data, validation_indices);
+            if (validation_result.loss < progress.best_loss - validation.min_delta) {
+                progress.best_loss = validation_result.loss;
+                progress.best_epoch = epoch;
+                progress.stale_epochs = 0;
+                if (validation.restore_best) {
+                    network.snapshotParameters(best_parameters);
+                }
+            } else {
+                progress.stale_epochs++;
+            }
+        }
+        
+        // 下一个epoch从头开始
+        EpochProgress next;
+        next.epoch = epoch + 1;
+        next.previous_loss = avg_loss;
+        next.best_loss = progress.best_loss;
+        next.best_epoch = progress.best_epoch;
+        next.stale_epochs = progress.stale_epochs;
+        progress = next;
+        if (checkpoint_writer) {
+            saveCheckpoint(indices, progress, batch_size);
+        }
+        
+        // 没有验证集时在训练样本上估计准确率（每5个epoch计算一次）
+        double accuracy = 0.0;
+        if (!validating && (epoch % 5 == 0 || epoch == epochs - 1)) {
+            int sample_size = std::min(1000, train_data.num_images); // 采样1000个样本计算准确率
+            accuracy = static_cast<double>(countCorrect(train_data, 0, sample_size)) / sample_size;
+        }
+        
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+        
+        printProgress(epoch + 1, epochs, avg_loss, accuracy, validating ? &validation_result : nullptr);
+        std::cout << " [" << duration.count() << "ms]" << std::endl;
+        
+        if (validating && validation.patience > 0 && progress.stale_epochs >= validation.patience) {
+            std::cout << "Early stopping: validation loss has not improved for " << progress.stale_epochs
+                      << " epochs" << std::endl;
+            break;
+        }
+    }
+    
+    if (validating && validation.restore_best) {
+        if (!best_parameters.empty()) {
+            network.restoreParameters(best_parameters);
+            std::cout << "Restored parameters from epoch " << (progress.best_epoch + 1) << " (validation loss "
+                      << std::fixed << std::setprecision(6) << progress.best_loss << ")" << std::endl;
+        } else if (std::isfinite(progress.best_loss)) {
+            // 最佳参数在恢复训练之前取得，不在内存中
+            std::cerr << "Warning: Best parameters from epoch " << (progress.best_epoch + 1)
+                      << " are not available after resuming, keeping the final parameters" << std::endl;
+        }
+    }
+    
+    if (checkpoint_writer) {
+        // 等最后的检查点写完，返回后即可安全退出
+        checkpoint_writer->flush();
+    }
+    std::cout << "Training completed!" << std::endl;
+    printPipelineStats();
+}
+
+bool MNISTClassifier::trainStreaming(const std::string& images_file, const std::string& labels_file,
+                                     int epochs, int batch_size, size_t chunk_size) {
+    MNISTStream stream;
+    if (!stream.open(images_file, labels_file)) {
+        return false;
+    }
+    
+    if (network.getOutputSize() == 0) {
+        input_size = static_cast<int>(stream.sampleSize());
+        output_size = stream.numClasses();
+        buildNetwork();
+    }
+    
+    std::cout << "Starting streaming training..." << std::endl;
+    std::cout << "Training samples: " << stream.size() << std::endl;
+    std::cout << "Chunk size: " << chunk_size << std::endl;
+    std::cout << "Epochs: " << epochs << std::endl;
+    std::cout << "Batch size: " << batch_size << std::endl;
+    std::cout << "Threads: " << network.getNumThreads() << std::endl;
+    if (validation_enabled) {
+        std::cerr << "Warning: Streaming training does not hold out a validation set, "
+                  << "validation settings are ignored" << std::endl;
+    }
+    
+    network.reserveWorkspace(batch_size);
+    pipeline->resetStats();
+    
+    // 每块单独分批，总步数按各块的批数累计
+    uint64_t steps_per_epoch = 0;
+    size_t batch = static_cast<size_t>(batch_size);
+    for (size_t remaining = static_cast<size_t>(stream.size()); chunk_size > 0 && remaining > 0;) {
+        size_t count = std::min(remaining, chunk_size);
+        steps_per_epoch += (count + batch - 1) / batch;
+        remaining -= count;
+    }
+    createScheduler(optimizer_learning_rate, static_cast<uint64_t>(epochs) * steps_per_epoch);
+    
+    MNISTData chunk;
+    bool augmenter_ready = false;
+    std::vector<int> indices;
     for (int epoch = 0; epoch < epochs; ++epoch) {
         auto start_time = std::chrono::high_resolution_clock::now();
         
-        // 打乱训练数据
-        std::shuffle(indices.begin(), indices.end(), gen);
+        // 每个epoch重新打开文件，从头顺序读取
+        if (epoch > 0 && !stream.open(images_file, labels_file)) {
+            return false;
+        }
         
         double total_loss = 0.0;
-        int num_batches = (train_data.num_images + batch_size - 1) / batch_size;
-        
-        for (int batch = 0; batch < num_batches; ++batch) {
-            int start_idx = batch * batch_size;
-            int end_idx = std::min(start_idx + batch_size, train_data.num_images);
+        int samples = 0;
+        while (size_t count = stream.next(chunk, chunk_size)) {
+            if (!checkDataShape(chunk)) {
+                return false;
+            }
             
-            std::vector<std::vector<double>> batch_images;
-            std::vector<std::vector<double>> batch_labels;
+            if (!augmenter_ready) {
+                createAugmenter(chunk);
+                augmenter_ready = true;
+            }
             
-            for (int i = start_idx; i < end_idx; ++i) {
-                int idx = indices[i];
-                batch_images.push_back(train_data.images[idx]);
-                batch_labels.push_back(one_hot_labels[idx]);
+            // 块内打乱
+            indices.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                indices[i] = static_cast<int>(i);
             }
+            std::shuffle(indices.begin(), indices.end(), rng);
+            updateAugmentation();
             
-            double batch_loss = network.trainBatch(batch_images, batch_labels);
-            total_loss += batch_loss;
+            total_loss += trainEpochSynchronous(chunk, indices, batch_size) * count;
+            samples += static_cast<int>(count);
+        }
+        if (stream.failed() || samples != stream.size()) {
+            std::cerr << "Error: Failed to read " << images_file << std::endl;
+            return false;
         }
         
-        double avg_loss = total_loss / num_batches;
-        
-        // 计算训练准确率（每5个epoch计算一次）
+        // 用最后一块的前1000个样本估计训练准确率
         double accuracy = 0.0;
         if (epoch % 5 == 0 || epoch == epochs - 1) {
-            int correct = 0;
-            int sample_size = std::min(1000, train_data.num_images); // 采样1000个样本计算准确率
-            
-            for (int i = 0; i < sample_size; ++i) {
-                int prediction = predict(train_data.images[i]);
-                if (prediction == train_data.labels[i]) {
-                    correct++;
-                }
-            }
-            accuracy = static_cast<double>(correct) / sample_size;
+            int sample_size = std::min(1000, chunk.num_images);
+            accuracy = static_cast<double>(countCorrect(chunk, 0, sample_size)) / sample_size;
         }
         
         auto end_time = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
         
-        printProgress(epoch + 1, epochs, avg_loss, accuracy);
+        printProgress(epoch + 1, epochs, samples > 0 ? total_loss / samples : 0.0, accuracy);
         std::cout << " [" << duration.count() << "ms]" << std::endl;
     }
     
     std::cout << "Training completed!" << std::endl;
+    printPipelineStats();
+    return true;
+}
+
+double MNISTClassifier::trainEpochSynchronous(const MNISTData& train_data,
+                                              const std::vector<int>& indices, int batch_size,
+                                              EpochProgress* progress) {
+    double total_loss = progress ? progress->loss_sum : 0.0;
+    size_t num_batches = progress ? progress->batches : 0;
+    
+    // 流水线在后台准备后续批次（样本转换为float并收集标签），缓冲区在各epoch间复用；
+    // 直接按类别下标计算损失与梯度，不构造one-hot目标
+    pipeline->start(train_data, indices, batch_size, progress ? progress->next_batch : 0);
+    while (const PreparedBatch* batch = pipeline->next()) {
+        applySchedule(schedule_step++);
+        double batch_loss = network.trainBatch(batch->inputs.view().rowRange(0, batch->count),
+                                               batch->labels.data());
+        total_loss += batch_loss;
+        num_batches++;
+        
+        if (progress) {
+            progress->next_batch = batch->batch_index + 1;
+            progress->loss_sum = total_loss;
+            progress->batches = num_batches;
+            if (checkpoint_writer && checkpoint_interval > 0 &&
+                progress->next_batch % checkpoint_interval == 0) {
+                saveCheckpoint(indices, *progress, batch_size);
+            }
+        }
+    }
+    
+    return num_batches > 0 ? total_loss / num_batches : 0.0;
+}
+
+double MNISTClassifier::trainEpochHogwild(const MNISTData& train_data,
+                                          const std::vector<int>& indices, int batch_size) {
+    // 按打乱后的顺序分块打包成连续矩阵，每块内各线程无锁并行训练；
+    // 块足够大，块间的同步开销可以忽略；下一块由流水线在后台准备
+    constexpr int kChunkSize = 4096;
+    
+    double total_loss = 0.0;
+    size_t samples_done = 0;
+    pipeline->start(train_data, indices, kChunkSize);
+    while (const PreparedBatch* chunk = pipeline->next()) {
+        // 块内使用同一个学习率；不修改schedule_step，发散回滚后同步训练从epoch开头重新调度
+        applySchedule(schedule_step + samples_done / batch_size);
+        samples_done += chunk->count;
+        ConstMatrixViewF images = chunk->inputs.view().rowRange(0, chunk->count);
+        total_loss += network.trainHogwild(images, chunk->labels.data()) * chunk->count;
+    }
+    
+    // 启用验证集时indices只包含训练部分
+    return samples_done > 0 ? total_loss / samples_done : 0.0;
+}
+
+ValidationResult MNISTClassifier::validate(const MNISTData& data, const std::vector<int>& indices) const {
+    ValidationResult result;
+    if (indices.empty()) {
+        return result;
+    }
+    
+    // 每次批量推理1000个样本，缓冲区在各块间复用
+    constexpr size_t kBlockSize = 1000;
+    size_t block = std::min(kBlockSize, indices.size());
+    MatrixF images(block, input_size);
+    MatrixF probabilities(block, output_size);
+    
+    // 与训练时的交叉熵相同地限制概率下限，防止log(0)
+    constexpr double kEpsilon = 1e-15;
+    double total_loss = 0.0;
+    size_t correct = 0;
+    for (size_t begin = 0; begin < indices.size(); begin += block) {
+        size_t count = std::min(block, indices.size() - begin);
+        MatrixViewF batch_images = images.view().rowRange(0, count);
+        MatrixViewF batch_probabilities = probabilities.view().rowRange(0, count);
+        data.gatherImages(indices.data() + begin, count, batch_images);
+        network.predictBatch(batch_images, batch_probabilities);
+        
+        for (size_t i = 0; i < count; ++i) {
+            const float* p = batch_probabilities.row(i);
+            int label = data.labels[indices[begin + i]];
+            total_loss -= std::log(std::max(kEpsilon, static_cast<double>(p[label])));
+            if (argmax(p, output_size) == label) {
+                correct++;
+            }
+        }
+    }
+    
+    result.loss = total_loss / indices.size();
+    result.accuracy = static_cast<double>(correct) / indices.size();
+    return result;
+}
+
+int MNISTClassifier::countCorrect(const MNISTData& data, int begin, int count,
+                                  const QuantizedNetwork* quantized) const {
+    if (count <= 0) return 0;
+    
+    // 转换为连续的float矩阵后批量推理
+    MatrixF images(count, input_size);
+    data.copyImages(begin, count, images);
+    
+    std::vector<int> predictions;
+    if (quantized) {
+        MatrixF probabilities(count, output_size);
+        quantized->predictBatch(images, probabilities);
+        predictions.resize(count);
+        for (int i = 0; i < count; ++i) {
+            predictions[i] = argmax(probabilities.row(i), output_size);
+        }
+    } else {
+        predictions = predictBatch(images);
+    }
+    
+    int correct = 0;
+    for (int i = 0; i < count; ++i) {
+        if (predictions[i] == data.labels[begin + i]) {
+            correct++;
+        }
+    }
+    return correct;
 }
 
 double MNISTClassifier::test(const MNISTData& test_data) {
+    if (!checkDataShape(test_data)) {
+        return 0.0;
+    }
+    
     std::cout << "Testing model..." << std::endl;
     
     int correct = 0;
     int total = test_data.num_images;
     
-    for (int i = 0; i < total; ++i) {
-        int prediction = predict(test_data.images[i]);
-        if (prediction == test_data.labels[i]) {
-            correct++;
-        }
+    // 每次批量预测1000个样本
+    constexpr int kBlockSize = 1000;
+    for (int begin = 0; begin < total; begin += kBlockSize) {
+        int count = std::min(kBlockSize, total - begin);
+        correct += countCorrect(test_data, begin, count);
         
         // 显示进度
-        if ((i + 1) % 1000 == 0 || i == total - 1) {
-            std::cout << "Processed: " << (i + 1) << "/" << total 
-                      << " (" << std::fixed << std::setprecision(1) 
-                      << (100.0 * (i + 1)) / total << "%)" << std::endl;
-        }
+        int processed = begin + count;
+        std::cout << "Processed: " << processed << "/" << total 
+                  << " (" << std::fixed << std::setprecision(1) 
+                  << (100.0 * processed) / total << "%)" << std::endl;
     }
     
     double accuracy = static_cast<double>(correct) / total;
@@ -122,24 +694,96 @@ double MNISTClassifier::test(const MNISTData& test_data) {
 }
 
 int MNISTClassifier::predict(const std::vector<double>& image) {
-    auto output = network.predict(image);
+    auto output = network.predict(std::vector<float>(image.begin(), image.end()));
     
     // 找到最大概率的类别
-    int predicted_class = 0;
-    double max_prob = output[0];
+    return argmax(output.data(), output.size());
+}
+
+int MNISTClassifier::predict(const std::vector<float>& image, InferenceContextF& ctx) const {
+    ConstMatrixViewF output = network.predict(image, ctx);
+    return argmax(output.row(0), output.cols());
+}
+
+ConstMatrixViewF MNISTClassifier::getPredictionProbabilities(const std::vector<float>& image,
+                                                             InferenceContextF& ctx) const {
+    return network.predict(image, ctx);
+}
+
+std::vector<double> MNISTClassifier::getPredictionProbabilities(const std::vector<double>& image) {
+    std::vector<float> output = network.predict(std::vector<float>(image.begin(), image.end()));
+    return std::vector<double>(output.begin(), output.end());
+}
+
+std::vector<int> MNISTClassifier::predictBatch(ConstMatrixViewF images) const {
+    MatrixF probabilities(images.rows(), output_size);
+    return predictBatch(images, probabilities);
+}
+
+std::vector<int> MNISTClassifier::predictBatch(ConstMatrixViewF images, MatrixViewF probabilities) const {
+    network.predictBatch(images, probabilities);
     
-    for (size_t i = 1; i < output.size(); ++i) {
-        if (output[i] > max_prob) {
-            max_prob = output[i];
-            predicted_class = i;
-        }
+    std::vector<int> predictions(images.rows());
+    for (size_t i = 0; i < images.rows(); ++i) {
+        predictions[i] = argmax(probabilities.row(i), probabilities.cols());
     }
-    
-    return predicted_class;
+    return predictions;
 }
 
-std::vector<double> MNISTClassifier::getPredictionProbabilities(const std::vector<double>& image) {
-    return network.predict(image);
+QuantizationReport MNISTClassifier::quantize(const MNISTData& calibration_data, const MNISTData& test_data,
+                                             const QuantizationConfig& config) {
+    QuantizationReport report;
+    if (!checkDataShape(calibration_data) || !checkDataShape(test_data)) {
+        return report;
+    }
+    if (calibration_data.num_images == 0 || config.calibration_samples == 0) {
+        throw std::invalid_argument("No calibration samples");
+    }
+    
+    // 均匀抽取校准样本，覆盖整个数据集而不只是开头的几个类别
+    size_t total = static_cast<size_t>(calibration_data.num_images);
+    size_t count = std::min(config.calibration_samples, total);
+    std::vector<int> indices(count);
+    for (size_t i = 0; i < count; ++i) {
+        indices[i] = static_cast<int>(i * total / count);
+    }
+    MatrixF calibration(count, input_size);
+    calibration_data.gatherImages(indices.data(), count, calibration);
+    
+    std::cout << "Quantizing to int8 (" << count << " calibration samples, percentile "
+              << config.percentile << ")..." << std::endl;
+    quantized_network.quantize(network, calibration, config.percentile);
+    
+    // 浮点与量化网络在测试集上逐块比较
+    int float_correct = 0;
+    int quantized_correct = 0;
+    int test_total = test_data.num_images;
+    constexpr int kBlockSize = 1000;
+    for (int begin = 0; begin < test_total; begin += kBlockSize) {
+        int block = std::min(kBlockSize, test_total - begin);
+        float_correct += countCorrect(test_data, begin, block);
+        quantized_correct += countCorrect(test_data, begin, block, &quantized_network);
+    }
+    
+    if (test_total > 0) {
+        report.float_accuracy = static_cast<double>(float_correct) / test_total;
+        report.quantized_accuracy = static_cast<double>(quantized_correct) / test_total;
+    }
+    report.float_bytes = quantized_network.parameterCount() * sizeof(float);
+    report.quantized_bytes = quantized_network.parameterBytes();
+    
+    std::ios_base::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << "Float accuracy: " << std::fixed << std::setprecision(2)
+              << report.float_accuracy * 100 << "%" << std::endl;
+    std::cout << "Int8 accuracy:  " << report.quantized_accuracy * 100 << "% (delta "
+              << std::showpos << report.accuracyDelta() * 100 << std::noshowpos << "%)" << std::endl;
+    std::cout << "Parameter bytes: " << report.float_bytes << " -> " << report.quantized_bytes
+              << " (" << static_cast<double>(report.float_bytes) / report.quantized_bytes << "x smaller)"
+              << std::endl;
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+    return report;
 }
 
 bool MNISTClassifier::saveModel(const std::string& filename) {
@@ -147,10 +791,18 @@ bool MNISTClassifier::saveModel(const std::string& filename) {
 }
 
 bool MNISTClassifier::loadModel(const std::string& filename) {
-    return network.loadModel(filename);
+    if (!network.loadModel(filename)) {
+        return false;
+    }
+    
+    // 输入维度与类别数以模型为准
+    input_size = static_cast<int>(network.getInputSize());
+    output_size = static_cast<int>(network.getOutputSize());
+    return true;
 }
 
-void MNISTClassifier::printProgress(int epoch, int total_epochs, double loss, double accuracy) {
+void MNISTClassifier::printProgress(int epoch, int total_epochs, double loss, double accuracy,
+                                    const ValidationResult* validation_result) {
     std::cout << "Epoch " << std::setw(3) << epoch << "/" << total_epochs
               << " - Loss: " << std::fixed << std::setprecision(6) << loss;
     
@@ -158,4 +810,19 @@ void MNISTClassifier::printProgress(int epoch, int total_epochs, double loss, do
         std::cout << " - Accuracy: " << std::fixed << std::setprecision(4) 
                   << accuracy * 100 << "%";
     }
+    if (validation_result) {
+        std::cout << " - Val loss: " << std::fixed << std::setprecision(6) << validation_result->loss
+                  << " - Val accuracy: " << std::setprecision(4) << validation_result->accuracy * 100 << "%";
+    }
+    if (scheduler) {
+        std::cout << " - LR: " << std::scientific << std::setprecision(3) << network.getLearningRate()
+                  << std::fixed;
+    }
+}
+
+void MNISTClassifier::printPipelineStats() const {
+    const PipelineStats& stats = pipeline->stats();
+    std::cout << "Data pipeline: " << stats.batches << " batches, " << stats.stalls << " stalls ("
+              << std::fixed << std::setprecision(1) << stats.stall_seconds * 1000.0 << "ms waiting, "
+              << stats.prepare_seconds * 1000.0 << "ms preparing)" << std::endl;
 }
\ No newline at end of file
@@ -3,33 +3,220 @@
 
 #include "bpnn.h"
 #include "mnist_reader.h"
+#include "batch_pipeline.h"
+#include "augmentation.h"
+#include "checkpoint.h"
+#include "lr_scheduler.h"
+#include "quantization.h"
 #include <chrono>
+#include <limits>
+#include <memory>
+#include <random>
+
+// 训练方式
+enum class TrainingMode {
+    SYNCHRONOUS,  // 小批量同步训练，多线程时数据并行，结果可复现
+    HOGWILD       // 逐样本无锁异步训练，发散时自动回滚并改用同步训练
+};
+
+// 验证集与提前停止
+struct ValidationConfig {
+    double fraction = 0.1;     // 从训练数据中留作验证集的比例，(0, 1)
+    int patience = 5;          // 验证损失连续patience个epoch没有改善即停止训练，0表示不提前停止
+    double min_delta = 1e-4;   // 验证损失至少下降min_delta才算改善
+    bool restore_best = true;  // 训练结束时恢复验证损失最低时的参数
+};
+
+// 一次验证的结果
+struct ValidationResult {
+    double loss = 0.0;      // 平均交叉熵
+    double accuracy = 0.0;
+};
 
 // MNIST分类器
+// 网络以单精度训练与推理：像素只有8位精度，float对精度没有影响，而内存带宽减半、SIMD宽度加倍
 class MNISTClassifier {
 private:
-    NeuralNetwork network;
+    NeuralNetworkF network;
     int input_size;
     int output_size;
+    std::mt19937 rng;  // 打乱训练数据使用的随机数发生器
+    TrainingMode training_mode;
+    std::unique_ptr<BatchPipeline> pipeline;  // 后台准备训练批次
+    AugmentationConfig augmentation;
+    bool augmentation_enabled;
+    std::unique_ptr<Augmenter> augmenter;     // 训练期间按数据的图像尺寸创建
+    uint64_t augmentation_seed;               // 当前epoch的增强种子
+    
+    // buildNetwork时设置的优化器
+    OptimizerType optimizer_type;
+    double optimizer_learning_rate;
+    OptimizerConfig optimizer_config;
+    
+    // 学习率调度：训练开始时按总步数创建，固定学习率时为空，网络的学习率保持不变
+    LRScheduleConfig lr_schedule;
+    std::unique_ptr<LRScheduler> scheduler;
+    uint64_t schedule_step;  // 下一个训练批在整个训练中的序号
+    
+    ValidationConfig validation;
+    bool validation_enabled;
+    
+    // 检查点
+    std::unique_ptr<CheckpointWriter> checkpoint_writer;
+    int checkpoint_interval;                          // 同步训练中每多少批写一次，0表示只在epoch结束时写
+    std::unique_ptr<TrainingCheckpoint> resume_state; // resumeFrom读入的进度，由下一次train使用
+    
+    QuantizedNetwork quantized_network;  // quantize生成的int8网络
+    
+    // 当前epoch的训练进度，写检查点时一并保存
+    struct EpochProgress {
+        int epoch = 0;
+        size_t next_batch = 0;
+        double loss_sum = 0.0;
+        size_t batches = 0;
+        double previous_loss = 0.0;
+        // 提前停止的进度，跨epoch保留
+        double best_loss = std::numeric_limits<double>::infinity();
+        int best_epoch = 0;
+        int stale_epochs = 0;
+    };
+    
+    // 单个epoch的两种训练方式，返回平均损失。
+    // 给出progress时从progress->next_batch继续，并按checkpoint_interval写检查点
+    double trainEpochSynchronous(const MNISTData& train_data, const std::vector<int>& indices, int batch_size,
+                                 EpochProgress* progress = nullptr);
+    // 批量推理indices中的样本，计算平均交叉熵与准确率
+    ValidationResult validate(const MNISTData& data, const std::vector<int>& indices) const;
+    // Hogwild每块按已处理的样本数折算成批来调度学习率
+    double trainEpochHogwild(const MNISTData& train_data, const std::vector<int>& indices, int batch_size);
+    
+    // 复制当前状态提交给后台写入，训练线程只承担复制的开销
+    void saveCheckpoint(const std::vector<int>& order, const EpochProgress& progress, int batch_size);
+
+    // 检查数据的样本大小与类别数是否与网络一致
+    bool checkDataShape(const MNISTData& data) const;
+    
+    // 训练开始时按数据创建增强器；每个epoch（流式训练为每块）开始前从rng取新的种子
+    // 设置流水线的增强变换，未启用增强时清除变换
+    void createAugmenter(const MNISTData& data);
+    void updateAugmentation();
+    void setAugmentationSeed(uint64_t seed);
+    
+    // 按lr_schedule与给定的峰值、总步数创建调度器；applySchedule在第step个训练批之前设置学习率
+    void createScheduler(double peak_learning_rate, uint64_t total_steps);
+    void applySchedule(uint64_t step);
+    
+    // 批量预测第 [begin, begin + count) 个样本，返回预测正确的个数；
+    // 给出quantized时用量化网络预测
+    int countCorrect(const MNISTData& data, int begin, int count,
+                     const QuantizedNetwork* quantized = nullptr) const;
     
 public:
     MNISTClassifier(double learning_rate = 0.001);
     
-    // 构建网络结构
+    // 设置随机种子（权重初始化与数据打乱），应在buildNetwork之前调用；
+    // 相同种子与线程数下训练结果完全一致
+    void setSeed(unsigned seed);
+    
+    // 设置训练线程数，0表示使用全部硬件线程（默认）
+    void setNumThreads(size_t threads) { network.setNumThreads(threads); }
+    
+    void setTrainingMode(TrainingMode mode) { training_mode = mode; }
+    // 设置优化器（默认Adam，学习率0.001），应在buildNetwork之前调用；
+    // 多线程大批量训练可改用LAMB并相应增大学习率
+    void setOptimizer(OptimizerType type, double learning_rate, const OptimizerConfig& config = OptimizerConfig()) {
+        optimizer_type = type;
+        optimizer_learning_rate = learning_rate;
+        optimizer_config = config;
+    }
+    // 学习率调度（默认固定学习率）：峰值为setOptimizer的学习率，步数以训练批为单位，
+    // 总步数由train的epochs与批大小决定。调度写入检查点，恢复训练时沿用保存的调度。
+    // 配置不合法时抛出invalid_argument
+    void setLRSchedule(const LRScheduleConfig& config) {
+        LRScheduler::validate(config);
+        lr_schedule = config;
+    }
+    double getLearningRate() const { return network.getLearningRate(); }
+    // 混合精度训练：激活值以bf16保存，主权重与优化器状态仍为float（见MixedPrecisionConfig）
+    void setMixedPrecision(const MixedPrecisionConfig& config) { network.setMixedPrecision(config); }
+    
+    // 设置数据流水线：训练当前批时提前准备好queue_depth个批次（默认2，1即双缓冲），
+    // 使用num_workers个后台线程（默认1，0表示在训练线程上同步准备）
+    void setPrefetch(size_t queue_depth, size_t num_workers = 1);
+    // 在线数据增强：训练时由流水线的生产者线程对每批做随机仿射、弹性形变与噪声，
+    // 每个样本的随机数由setSeed决定的种子与样本下标派生，结果与线程数无关。
+    // 多个生产者线程（setPrefetch）可并行增强不同的批
+    void setAugmentation(const AugmentationConfig& config, bool enabled = true) {
+        augmentation = config;
+        augmentation_enabled = enabled;
+    }
+    
+    // 验证集：训练开始时用setSeed决定的随机数从训练数据中划出config.fraction的样本不参与训练，
+    // 每个epoch结束后在其上批量评估损失与准确率（代替在训练样本上估计的准确率）。
+    // patience > 0 时验证损失连续patience个epoch没有改善即提前结束训练；restore_best时结束后
+    // 恢复验证损失最低时的参数（快照只在内存中，从检查点恢复后须重新取得最佳值）。
+    // 检查点保存训练部分的样本顺序，恢复时其余样本即为验证集。配置不合法时抛出invalid_argument
+    void setValidation(const ValidationConfig& config, bool enabled = true);
+    
+    // 训练检查点：每个epoch结束时（同步训练还每every_batches批）把参数、优化器状态、
+    // 随机数发生器状态与训练进度写入 prefix-<step>.ckpt，只保留最近keep_last个。
+    // 写入在后台线程进行；prefix为空时关闭。流式训练不写检查点
+    void setCheckpointing(const std::string& prefix, int every_batches = 0, size_t keep_last = 3);
+    // 从检查点恢复网络、优化器状态与随机数发生器，下一次train从保存的epoch与批继续
+    // （train的epochs为包括已完成部分在内的总epoch数，数据须与保存时相同）
+    bool resumeFrom(const std::string& checkpoint_path);
+    // prefix下最新的检查点路径，没有时返回空字符串
+    static std::string latestCheckpoint(const std::string& prefix) { return CheckpointWriter::latest(prefix); }
+    
+    // 最近一次训练的流水线统计，停顿次数多说明数据准备跟不上计算
+    const PipelineStats& getPipelineStats() const { return pipeline->stats(); }
+    
+    // 构建网络结构：输入维度与类别数默认为MNIST的784与10
     void buildNetwork();
+    // 按数据的样本大小与类别数构建网络
+    void buildNetwork(const MNISTData& data);
+    
+    int getInputSize() const { return input_size; }
+    int getNumClasses() const { return output_size; }
     
     // 训练模型
     void train(const MNISTData& train_data, int epochs = 10, int batch_size = 32);
     
+    // 流式训练：数据集超出内存时使用，每个epoch从文件顺序读取，
+    // 每次载入chunk_size个样本并在块内打乱。网络尚未构建时按数据自动构建。
+    // 总是同步训练（Hogwild的发散回滚需要整个epoch的数据）。
+    // 不划分验证集，也不提前停止：setValidation只对train生效
+    bool trainStreaming(const std::string& images_file, const std::string& labels_file,
+                        int epochs = 10, int batch_size = 32, size_t chunk_size = 65536);
+    
     // 测试模型
     double test(const MNISTData& test_data);
     
-    // 预测单个图像
+    // 预测单个图像（转换为float后推理）
     int predict(const std::vector<double>& image);
     
     // 获取预测概率
     std::vector<double> getPredictionProbabilities(const std::vector<double>& image);
     
+    // 只读推理：每个线程使用自己的InferenceContextF即可并发调用，不加锁、不分配内存
+    void prepareContext(InferenceContextF& ctx) const { network.prepareContext(ctx); }
+    int predict(const std::vector<float>& image, InferenceContextF& ctx) const;
+    // 返回 1 x 类别数 的概率视图，在下次使用ctx前有效
+    ConstMatrixViewF getPredictionProbabilities(const std::vector<float>& image, InferenceContextF& ctx) const;
+    
+    // 批量预测：images为连续的 N x 输入维度 矩阵，返回每个样本的类别
+    std::vector<int> predictBatch(ConstMatrixViewF images) const;
+    // 同时写出 N x 类别数 的概率
+    std::vector<int> predictBatch(ConstMatrixViewF images, MatrixViewF probabilities) const;
+    
+    // 训练后int8量化：从calibration_data（通常为训练集）均匀抽取样本，统计各层激活范围，
+    // 按输出通道量化权重，并在test_data上比较量化前后的准确率。
+    // 当前网络保持不变，量化结果由getQuantizedNetwork取得
+    QuantizationReport quantize(const MNISTData& calibration_data, const MNISTData& test_data,
+                                const QuantizationConfig& config = QuantizationConfig());
+    const QuantizedNetwork& getQuantizedNetwork() const { return quantized_network; }
+    bool saveQuantizedModel(const std::string& filename) const { return quantized_network.saveModel(filename); }
+    
     // 保存模型
     bool saveModel(const std::string& filename);
     
@@ -37,7 +224,10 @@ public:
     bool loadModel(const std::string& filename);
     
     // 打印训练进度
-    void printProgress(int epoch, int total_epochs, double loss, double accuracy);
+    // 给出validation_result时一并打印验证损失与准确率
+    void printProgress(int epoch, int total_epochs, double loss, double accuracy,
+                       const ValidationResult* validation_result = nullptr);
+    void printPipelineStats() const;
 };
 
 #endif // MNIST_CLASSIFIER_H
\ No newline at end of file
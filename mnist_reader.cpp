@@ -1,8 +1,402 @@
 #include "mnist_reader.h"
+#include "mapped_file.h"
+#include "gzip_stream.h"
 #include <iostream>
 #include <algorithm>
 #include <iomanip>
 #include <cstring>
+#include <climits>
+
+namespace {
+
+uint16_t loadBigEndian16(const unsigned char* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint32_t loadBigEndian32(const unsigned char* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+uint64_t loadBigEndian64(const unsigned char* p) {
+    return (static_cast<uint64_t>(loadBigEndian32(p)) << 32) | loadBigEndian32(p + 4);
+}
+
+// 将count个大端序编码的元素解码并乘以scale，按double计算后转换为T
+template<typename T>
+void decodeElements(const unsigned char* src, IdxType type, size_t count, double scale, T* out) {
+    switch (type) {
+    case IdxType::UBYTE:
+        for (size_t j = 0; j < count; ++j) {
+            out[j] = static_cast<T>(src[j] * scale);
+        }
+        break;
+    case IdxType::SBYTE:
+        for (size_t j = 0; j < count; ++j) {
+            out[j] = static_cast<T>(static_cast<signed char>(src[j]) * scale);
+        }
+        break;
+    case IdxType::SHORT:
+        for (size_t j = 0; j < count; ++j) {
+            out[j] = static_cast<T>(static_cast<int16_t>(loadBigEndian16(src + 2 * j)) * scale);
+        }
+        break;
+    case IdxType::INT:
+        for (size_t j = 0; j < count; ++j) {
+            out[j] = static_cast<T>(static_cast<int32_t>(loadBigEndian32(src + 4 * j)) * scale);
+        }
+        break;
+    case IdxType::FLOAT:
+        for (size_t j = 0; j < count; ++j) {
+            uint32_t bits = loadBigEndian32(src + 4 * j);
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            out[j] = static_cast<T>(value * scale);
+        }
+        break;
+    case IdxType::DOUBLE:
+        for (size_t j = 0; j < count; ++j) {
+            uint64_t bits = loadBigEndian64(src + 8 * j);
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            out[j] = static_cast<T>(value * scale);
+        }
+        break;
+    }
+}
+
+// 带溢出检查的乘法
+bool multiplyChecked(size_t a, size_t b, size_t& result) {
+    if (a != 0 && b > SIZE_MAX / a) {
+        return false;
+    }
+    result = a * b;
+    return true;
+}
+
+// 标签必须是非负整数；上限防止损坏的文件把输出层撑到不合理的大小
+constexpr int kMaxClasses = 1 << 16;
+
+bool decodeLabels(IdxReader& reader, std::vector<int>& labels, int& num_classes) {
+    IdxType type = reader.type();
+    if (type == IdxType::FLOAT || type == IdxType::DOUBLE) {
+        std::cerr << "Error: Labels must be integers" << std::endl;
+        return false;
+    }
+    
+    std::shared_ptr<const void> storage;
+    const unsigned char* src = reader.loadAll(storage);
+    if (!src) {
+        return false;
+    }
+    
+    size_t count = reader.count();
+    size_t element_size = idxTypeSize(type);
+    num_classes = 0;
+    try {
+        labels.resize(count);
+        
+        for (size_t i = 0; i < count; ++i) {
+            const unsigned char* p = src + i * element_size;
+            long long label;
+            switch (type) {
+            case IdxType::UBYTE: label = p[0]; break;
+            case IdxType::SBYTE: label = static_cast<signed char>(p[0]); break;
+            case IdxType::SHORT: label = static_cast<int16_t>(loadBigEndian16(p)); break;
+            default:             label = static_cast<int32_t>(loadBigEndian32(p)); break;
+            }
+            if (label < 0 || label >= kMaxClasses) {
+                std::cerr << "Error: Invalid label value: " << label << " at label " << i << std::endl;
+                labels.clear();
+                return false;
+            }
+            labels[i] = static_cast<int>(label);
+            num_classes = std::max(num_classes, labels[i] + 1);
+        }
+    } catch (const std::bad_alloc& e) {
+        std::cerr << "Error: Failed to allocate memory for labels: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// ========== MNISTData实现 ==========
+
+void MNISTData::copyImage(int index, double* out) const {
+    decodeElements(image(index), pixel_type, imageSize(), pixel_scale, out);
+}
+
+void MNISTData::copyImage(int index, float* out) const {
+    decodeElements(image(index), pixel_type, imageSize(), pixel_scale, out);
+}
+
+std::vector<double> MNISTData::getImage(int index) const {
+    std::vector<double> out(imageSize());
+    copyImage(index, out.data());
+    return out;
+}
+
+void MNISTData::gatherImages(const int* indices, size_t count, MatrixView batch) const {
+    for (size_t i = 0; i < count; ++i) {
+        copyImage(indices[i], batch.row(i));
+    }
+}
+
+void MNISTData::gatherImages(const int* indices, size_t count, MatrixViewF batch) const {
+    for (size_t i = 0; i < count; ++i) {
+        copyImage(indices[i], batch.row(i));
+    }
+}
+
+void MNISTData::copyImages(int begin, size_t count, MatrixView batch) const {
+    for (size_t i = 0; i < count; ++i) {
+        copyImage(begin + static_cast<int>(i), batch.row(i));
+    }
+}
+
+void MNISTData::copyImages(int begin, size_t count, MatrixViewF batch) const {
+    for (size_t i = 0; i < count; ++i) {
+        copyImage(begin + static_cast<int>(i), batch.row(i));
+    }
+}
+
+// ========== IdxReader实现 ==========
+
+IdxReader::IdxReader() = default;
+IdxReader::~IdxReader() = default;
+
+bool IdxReader::read(unsigned char* out, size_t n, const char* what) {
+    if (gzip) {
+        if (!gzip->readExact(out, n)) {
+            if (gzip->failed()) {
+                std::cerr << "Error: Corrupted gzip file " << name << ": " << gzip->error() << std::endl;
+            } else {
+                std::cerr << "Error: Unexpected end of decompressed " << what << " in " << name << std::endl;
+            }
+            read_failed = true;
+            return false;
+        }
+        return true;
+    }
+    if (size - offset < n) {
+        std::cerr << "Error: Unexpected end of file while reading " << what << ": expected " << n
+                  << " bytes, got " << (size - offset) << std::endl;
+        read_failed = true;
+        return false;
+    }
+    std::memcpy(out, bytes + offset, n);
+    offset += n;
+    return true;
+}
+
+bool IdxReader::open(const std::string& filename) {
+    name = filename;
+    gzip.reset();
+    storage.reset();
+    bytes = nullptr;
+    size = offset = consumed = 0;
+    read_failed = false;
+    dimensions.clear();
+    sample_size = 0;
+    
+    if (MNISTReader::isGzipFile(filename)) {
+        // gzip文件流式解压：数据区在读取时才解压
+        gzip = std::make_unique<GzipStream>();
+        if (!gzip->open(filename)) {
+            std::cerr << "Error: Cannot decompress " << filename << ": " << gzip->error() << std::endl;
+            return false;
+        }
+    } else {
+        auto mapping = std::make_shared<MappedFile>();
+        if (mapping->open(filename)) {
+            bytes = mapping->data();
+            size = mapping->size();
+            storage = mapping;
+        } else {
+            // 无法映射（如管道或特殊文件系统）时一次性读入内存
+            std::ifstream file(filename, std::ios::binary);
+            if (!file.is_open()) {
+                std::cerr << "Cannot open file: " << filename << std::endl;
+                return false;
+            }
+            auto buffer = std::make_shared<std::vector<unsigned char>>(
+                (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            bytes = buffer->data();
+            size = buffer->size();
+            storage = buffer;
+        }
+    }
+    
+    // 魔数：两个0字节、元素类型、维数；随后每维一个大端序32位无符号整数
+    unsigned char header[4 * 256];
+    if (!read(header, 4, "IDX header")) {
+        return false;
+    }
+    magic_number = static_cast<int>(loadBigEndian32(header));
+    element_type = static_cast<IdxType>(header[2]);
+    int num_dims = header[3];
+    if (header[0] != 0 || header[1] != 0 || idxTypeSize(element_type) == 0 || num_dims == 0) {
+        std::cerr << "Error: Invalid IDX magic number " << magic_number << " in " << filename << std::endl;
+        return false;
+    }
+    
+    if (!read(header, 4 * num_dims, "IDX header")) {
+        return false;
+    }
+    dimensions.resize(num_dims);
+    sample_size = 1;
+    for (int d = 0; d < num_dims; ++d) {
+        dimensions[d] = loadBigEndian32(header + 4 * d);
+        if (d > 0 && !multiplyChecked(sample_size, dimensions[d], sample_size)) {
+            std::cerr << "Error: IDX dimensions overflow in " << filename << std::endl;
+            return false;
+        }
+    }
+    size_t total;
+    if (!multiplyChecked(sampleBytes(), count(), total)) {
+        std::cerr << "Error: IDX dimensions overflow in " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool IdxReader::finishGzip() {
+    // 解压到结尾以校验CRC32和长度
+    size_t trailing = gzip->skipToEnd();
+    if (gzip->failed()) {
+        std::cerr << "Error: Corrupted gzip file " << name << ": " << gzip->error() << std::endl;
+        read_failed = true;
+        return false;
+    }
+    if (trailing > 0) {
+        std::cerr << "Warning: Ignoring " << trailing << " extra bytes after IDX data in "
+                  << name << std::endl;
+    }
+    return true;
+}
+
+const unsigned char* IdxReader::loadAll(std::shared_ptr<const void>& owner) {
+    size_t payload = payloadBytes() - consumed * sampleBytes();
+    if (!gzip) {
+        // 直接指向文件内容，不做拷贝
+        if (size - offset < payload) {
+            std::cerr << "Error: Unexpected end of file: expected " << payload
+                      << " data bytes, got " << (size - offset) << std::endl;
+            read_failed = true;
+            return nullptr;
+        }
+        owner = storage;
+        consumed = count();
+        return bytes + offset;
+    }
+    
+    std::shared_ptr<std::vector<unsigned char>> buffer;
+    try {
+        buffer = std::make_shared<std::vector<unsigned char>>(payload);
+    } catch (const std::bad_alloc& e) {
+        std::cerr << "Error: Failed to allocate " << payload << " bytes for " << name << ": "
+                  << e.what() << std::endl;
+        read_failed = true;
+        return nullptr;
+    }
+    
+    // 分块解压到缓冲区
+    const size_t chunk = 1 << 20;
+    for (size_t done = 0; done < payload; done += chunk) {
+        if (!read(buffer->data() + done, std::min(chunk, payload - done), "data")) {
+            return nullptr;
+        }
+    }
+    consumed = count();
+    if (!finishGzip()) {
+        return nullptr;
+    }
+    owner = buffer;
+    return buffer->data();
+}
+
+size_t IdxReader::readSamples(unsigned char* out, size_t max_count) {
+    size_t n = std::min(max_count, count() - consumed);
+    if (n == 0 || read_failed) {
+        return 0;
+    }
+    if (!read(out, n * sampleBytes(), "data")) {
+        return 0;
+    }
+    consumed += n;
+    if (gzip && consumed == count() && !finishGzip()) {
+        return 0;
+    }
+    return n;
+}
+
+// ========== MNISTStream实现 ==========
+
+bool MNISTStream::open(const std::string& images_file, const std::string& labels_file, bool normalize) {
+    position = 0;
+    labels.clear();
+    
+    IdxReader label_reader;
+    if (!images.open(images_file) || !label_reader.open(labels_file)) {
+        return false;
+    }
+    if (images.dims().size() < 2 || label_reader.dims().size() != 1) {
+        std::cerr << "Error: Expected an image file with at least 2 dimensions and a 1-D label file"
+                  << std::endl;
+        return false;
+    }
+    if (images.count() != label_reader.count()) {
+        std::cerr << "Error: Number of images (" << images.count()
+                  << ") and labels (" << label_reader.count() << ") don't match!" << std::endl;
+        return false;
+    }
+    if (images.count() > static_cast<size_t>(INT_MAX) || images.sampleSize() > static_cast<size_t>(INT_MAX)) {
+        std::cerr << "Error: Dataset too large: " << images.count() << " samples of "
+                  << images.sampleSize() << " elements" << std::endl;
+        return false;
+    }
+    if (!decodeLabels(label_reader, labels, num_classes)) {
+        return false;
+    }
+    
+    pixel_scale = normalize ? MNISTReader::normalizationScale(images.type()) : 1.0;
+    return true;
+}
+
+size_t MNISTStream::next(MNISTData& chunk, size_t max_count) {
+    size_t n = std::min(max_count, labels.size() - position);
+    if (n == 0) {
+        return 0;
+    }
+    
+    // 缓冲区按块大小分配一次，之后每块复用
+    size_t chunk_bytes = n * images.sampleBytes();
+    if (!buffer || buffer->size() < chunk_bytes) {
+        buffer = std::make_shared<std::vector<unsigned char>>(chunk_bytes);
+    }
+    if (images.readSamples(buffer->data(), n) != n) {
+        return 0;
+    }
+    
+    const std::vector<size_t>& dims = images.dims();
+    chunk.storage = buffer;
+    chunk.pixels = buffer->data();
+    chunk.pixel_type = images.type();
+    chunk.sample_shape.assign(dims.begin() + 1, dims.end());
+    chunk.image_rows = static_cast<int>(dims[1]);
+    chunk.image_cols = static_cast<int>(images.sampleSize() / std::max<size_t>(dims[1], 1));
+    chunk.num_images = static_cast<int>(n);
+    chunk.num_classes = num_classes;
+    chunk.pixel_scale = pixel_scale;
+    chunk.labels.assign(labels.begin() + position, labels.begin() + position + n);
+    
+    position += n;
+    return n;
+}
+
+// ========== MNISTReader实现 ==========
 
 int MNISTReader::reverseInt(int i) {
     unsigned char c1, c2, c3, c4;
@@ -14,34 +408,39 @@ int MNISTReader::reverseInt(int i) {
 }
 
 bool MNISTReader::checkMagicNumber(int magic, bool is_images) {
+    // IDX魔数：高两个字节为0，第3个字节为元素类型，最低字节为维数
+    // （MNIST图像为2051 = 0x0803，标签为2049 = 0x0801）
+    if ((magic >> 16) != 0 || idxTypeSize(static_cast<IdxType>((magic >> 8) & 0xFF)) == 0) {
+        return false;
+    }
+    int num_dims = magic & 0xFF;
     if (is_images) {
-        return magic == 2051; // MNIST图像文件的魔数
-    } else {
-        return magic == 2049; // MNIST标签文件的魔数
+        return num_dims >= 2;
     }
+    IdxType type = static_cast<IdxType>((magic >> 8) & 0xFF);
+    return num_dims == 1 && type != IdxType::FLOAT && type != IdxType::DOUBLE;
 }
 
-bool MNISTReader::checkMemoryRequirement(int num_images, int rows, int cols) {
-    // 检查是否为合理的MNIST数据尺寸
-    if (num_images < 0 || num_images > 100000) {
-        std::cerr << "Error: Invalid number of images: " << num_images << std::endl;
-        return false;
-    }
-    
-    if (rows != 28 || cols != 28) {
-        std::cerr << "Error: Invalid image dimensions: " << rows << "x" << cols << std::endl;
-        std::cerr << "Expected: 28x28" << std::endl;
-        return false;
+int MNISTReader::readBigEndian(const unsigned char* bytes) {
+    return static_cast<int>(loadBigEndian32(bytes));
+}
+
+bool MNISTReader::checkMemoryRequirement(size_t bytes, bool in_memory) {
+    size_t memory_mb = bytes / (1024 * 1024);
+    if (!in_memory) {
+        // 内存映射的文件由系统按需分页，超出物理内存也可以随机访问
+        std::cout << "Data size: " << memory_mb << " MB (memory-mapped, paged on demand)" << std::endl;
+        return true;
     }
     
-    // 估算内存需求（每个像素8字节，加上一些额外开销）
-    long long memory_needed = static_cast<long long>(num_images) * rows * cols * sizeof(double);
-    long long memory_mb = memory_needed / (1024 * 1024);
-    
     std::cout << "Estimated memory requirement: " << memory_mb << " MB" << std::endl;
     
-    if (memory_mb > 5000) { // 如果需要超过5GB内存，警告用户
-        std::cerr << "Warning: This will require more than 5GB of memory!" << std::endl;
+    size_t physical = physicalMemorySize();
+    if (physical != 0 && bytes > physical) {
+        std::cerr << "Error: Decompressed data (" << memory_mb << " MB) exceeds physical memory ("
+                  << physical / (1024 * 1024) << " MB)." << std::endl;
+        std::cerr << "Decompress the file to disk so it can be memory-mapped, or train from it "
+                     "with MNISTStream / MNISTClassifier::trainStreaming." << std::endl;
         return false;
     }
     
@@ -63,32 +462,38 @@ bool MNISTReader::isGzipFile(const std::string& filename) {
 }
 
 bool MNISTReader::validateMNISTFormat(const std::string& filename, bool is_images) {
+    int magic_number;
     if (isGzipFile(filename)) {
-        std::cerr << "Error: File " << filename << " appears to be a GZIP compressed file." << std::endl;
-        std::cerr << "Please extract the file first using: gunzip " << filename << std::endl;
-        return false;
-    }
-    
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Error: Cannot open file " << filename << std::endl;
-        return false;
+        // 压缩文件只解压出魔数所在的前4个字节
+        GzipStream gzip;
+        unsigned char bytes[4];
+        if (!gzip.open(filename) || !gzip.readExact(bytes, sizeof(bytes))) {
+            std::cerr << "Error: Cannot decompress " << filename << ": "
+                      << (gzip.failed() ? gzip.error() : "file too short") << std::endl;
+            return false;
+        }
+        magic_number = readBigEndian(bytes);
+    } else {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Error: Cannot open file " << filename << std::endl;
+            return false;
+        }
+        
+        file.read(reinterpret_cast<char*>(&magic_number), sizeof(magic_number));
+        magic_number = reverseInt(magic_number);
+        file.close();
     }
     
-    int magic_number;
-    file.read(reinterpret_cast<char*>(&magic_number), sizeof(magic_number));
-    magic_number = reverseInt(magic_number);
-    
     if (!checkMagicNumber(magic_number, is_images)) {
         std::cerr << "Error: Invalid magic number in " << filename << std::endl;
-        std::cerr << "Expected: " << (is_images ? "2051" : "2049") 
+        std::cerr << "Expected: " << (is_images ? "an IDX file with at least 2 dimensions (e.g. 2051)"
+                                                : "a 1-D integer IDX file (e.g. 2049)")
                   << ", Got: " << magic_number << std::endl;
         std::cerr << "This file may be corrupted or in wrong format." << std::endl;
-        file.close();
         return false;
     }
     
-    file.close();
     return true;
 }
 
@@ -98,83 +503,50 @@ bool MNISTReader::readImages(const std::string& filename, MNISTData& data) {
         return false;
     }
     
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Cannot open file: " << filename << std::endl;
+    IdxReader reader;
+    if (!reader.open(filename)) {
         return false;
     }
     
-    int magic_number = 0;
-    int number_of_images = 0;
-    int n_rows = 0;
-    int n_cols = 0;
-    
-    file.read(reinterpret_cast<char*>(&magic_number), sizeof(magic_number));
-    magic_number = reverseInt(magic_number);
-    
-    file.read(reinterpret_cast<char*>(&number_of_images), sizeof(number_of_images));
-    number_of_images = reverseInt(number_of_images);
-    
-    file.read(reinterpret_cast<char*>(&n_rows), sizeof(n_rows));
-    n_rows = reverseInt(n_rows);
-    
-    file.read(reinterpret_cast<char*>(&n_cols), sizeof(n_cols));
-    n_cols = reverseInt(n_cols);
-    
+    const std::vector<size_t>& dims = reader.dims();
     std::cout << "Image file info:" << std::endl;
-    std::cout << "  Magic number: " << magic_number << std::endl;
-    std::cout << "  Number of images: " << number_of_images << std::endl;
-    std::cout << "  Rows: " << n_rows << std::endl;
-    std::cout << "  Cols: " << n_cols << std::endl;
+    std::cout << "  Magic number: " << reader.magic() << std::endl;
+    std::cout << "  Number of images: " << reader.count() << std::endl;
+    std::cout << "  Sample shape: ";
+    for (size_t d = 1; d < dims.size(); ++d) {
+        std::cout << (d > 1 ? "x" : "") << dims[d];
+    }
+    std::cout << " (" << idxTypeSize(reader.type()) << "-byte elements)" << std::endl;
     
-    // 验证数据合理性
-    if (!checkMemoryRequirement(number_of_images, n_rows, n_cols)) {
-        file.close();
+    // 样本下标使用int
+    if (reader.count() > static_cast<size_t>(INT_MAX) || reader.sampleSize() > static_cast<size_t>(INT_MAX)) {
+        std::cerr << "Error: Dataset too large: " << reader.count() << " samples of "
+                  << reader.sampleSize() << " elements" << std::endl;
         return false;
     }
     
-    data.num_images = number_of_images;
-    data.image_rows = n_rows;
-    data.image_cols = n_cols;
+    // 验证数据能否载入
+    if (!checkMemoryRequirement(reader.payloadBytes(), reader.compressed())) {
+        return false;
+    }
     
-    try {
-        data.images.clear();
-        data.images.reserve(number_of_images); // 预分配内存
-        
-        std::cout << "Loading images..." << std::endl;
-        
-        for (int i = 0; i < number_of_images; ++i) {
-            std::vector<double> image;
-            image.reserve(n_rows * n_cols);
-            
-            for (int r = 0; r < n_rows; ++r) {
-                for (int c = 0; c < n_cols; ++c) {
-                    unsigned char temp = 0;
-                    file.read(reinterpret_cast<char*>(&temp), sizeof(temp));
-                    if (file.eof()) {
-                        std::cerr << "Error: Unexpected end of file at image " << i << std::endl;
-                        file.close();
-                        return false;
-                    }
-                    image.push_back(static_cast<double>(temp));
-                }
-            }
-            data.images.push_back(std::move(image));
-            
-            // 显示进度
-            if ((i + 1) % 10000 == 0 || i == number_of_images - 1) {
-                std::cout << "Loaded " << (i + 1) << "/" << number_of_images 
-                          << " images (" << ((i + 1) * 100 / number_of_images) << "%)" << std::endl;
-            }
-        }
-    } catch (const std::bad_alloc& e) {
-        std::cerr << "Error: Failed to allocate memory for images: " << e.what() << std::endl;
-        file.close();
+    // 未压缩时样本直接指向文件内容，不做拷贝和类型转换
+    std::shared_ptr<const void> storage;
+    const unsigned char* pixels = reader.loadAll(storage);
+    if (!pixels) {
         return false;
     }
     
-    file.close();
-    std::cout << "Successfully loaded " << number_of_images << " images." << std::endl;
+    data.storage = storage;
+    data.pixels = pixels;
+    data.pixel_type = reader.type();
+    data.sample_shape.assign(dims.begin() + 1, dims.end());
+    data.num_images = static_cast<int>(reader.count());
+    data.image_rows = static_cast<int>(dims[1]);
+    data.image_cols = static_cast<int>(reader.sampleSize() / std::max<size_t>(dims[1], 1));
+    data.pixel_scale = 1.0;
+    
+    std::cout << "Successfully loaded " << data.num_images << " images." << std::endl;
     return true;
 }
 
@@ -184,68 +556,26 @@ bool MNISTReader::readLabels(const std::string& filename, MNISTData& data) {
         return false;
     }
     
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Cannot open file: " << filename << std::endl;
+    IdxReader reader;
+    if (!reader.open(filename)) {
         return false;
     }
     
-    int magic_number = 0;
-    int number_of_labels = 0;
-    
-    file.read(reinterpret_cast<char*>(&magic_number), sizeof(magic_number));
-    magic_number = reverseInt(magic_number);
-    
-    file.read(reinterpret_cast<char*>(&number_of_labels), sizeof(number_of_labels));
-    number_of_labels = reverseInt(number_of_labels);
-    
     std::cout << "Label file info:" << std::endl;
-    std::cout << "  Magic number: " << magic_number << std::endl;
-    std::cout << "  Number of labels: " << number_of_labels << std::endl;
+    std::cout << "  Magic number: " << reader.magic() << std::endl;
+    std::cout << "  Number of labels: " << reader.count() << std::endl;
     
-    if (number_of_labels < 0 || number_of_labels > 100000) {
-        std::cerr << "Error: Invalid number of labels: " << number_of_labels << std::endl;
-        file.close();
+    if (reader.count() > static_cast<size_t>(INT_MAX)) {
+        std::cerr << "Error: Invalid number of labels: " << reader.count() << std::endl;
         return false;
     }
     
-    try {
-        data.labels.clear();
-        data.labels.reserve(number_of_labels);
-        
-        std::cout << "Loading labels..." << std::endl;
-        
-        for (int i = 0; i < number_of_labels; ++i) {
-            unsigned char temp = 0;
-            file.read(reinterpret_cast<char*>(&temp), sizeof(temp));
-            if (file.eof()) {
-                std::cerr << "Error: Unexpected end of file at label " << i << std::endl;
-                file.close();
-                return false;
-            }
-            
-            if (temp > 9) {
-                std::cerr << "Error: Invalid label value: " << static_cast<int>(temp) << std::endl;
-                file.close();
-                return false;
-            }
-            
-            data.labels.push_back(static_cast<int>(temp));
-            
-            // 显示进度
-            if ((i + 1) % 10000 == 0 || i == number_of_labels - 1) {
-                std::cout << "Loaded " << (i + 1) << "/" << number_of_labels 
-                          << " labels (" << ((i + 1) * 100 / number_of_labels) << "%)" << std::endl;
-            }
-        }
-    } catch (const std::bad_alloc& e) {
-        std::cerr << "Error: Failed to allocate memory for labels: " << e.what() << std::endl;
-        file.close();
+    if (!decodeLabels(reader, data.labels, data.num_classes)) {
         return false;
     }
     
-    file.close();
-    std::cout << "Successfully loaded " << number_of_labels << " labels." << std::endl;
+    std::cout << "Successfully loaded " << data.labels.size() << " labels ("
+              << data.num_classes << " classes)." << std::endl;
     return true;
 }
 
@@ -269,24 +599,29 @@ bool MNISTReader::loadMNIST(const std::string& images_file,
         return false;
     }
     
-    if (data.images.size() != data.labels.size()) {
-        std::cerr << "Error: Number of images (" << data.images.size() 
+    if (static_cast<size_t>(data.num_images) != data.labels.size()) {
+        std::cerr << "Error: Number of images (" << data.num_images 
                   << ") and labels (" << data.labels.size() << ") don't match!" << std::endl;
         return false;
     }
     
     std::cout << "Successfully loaded MNIST dataset!" << std::endl;
-    std::cout << "Total samples: " << data.images.size() << std::endl;
+    std::cout << "Total samples: " << data.num_images << std::endl;
     return true;
 }
 
-void MNISTReader::normalizeImages(MNISTData& data) {
-    std::cout << "Normalizing images..." << std::endl;
-    for (auto& image : data.images) {
-        for (auto& pixel : image) {
-            pixel /= 255.0; // 归一化到[0,1]范围
-        }
+double MNISTReader::normalizationScale(IdxType type) {
+    switch (type) {
+    case IdxType::UBYTE: return 1.0 / 255.0;
+    case IdxType::SBYTE: return 1.0 / 128.0;
+    case IdxType::SHORT: return 1.0 / 32768.0;
+    default:             return 1.0;  // int32与浮点数的取值范围无法从类型推断
     }
+}
+
+void MNISTReader::normalizeImages(MNISTData& data) {
+    // 样本保持原始编码不变，只记录缩放系数，在取样本转换为double时归一化
+    data.pixel_scale = normalizationScale(data.pixel_type);
     std::cout << "Images normalized." << std::endl;
 }
 
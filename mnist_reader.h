@@ -4,28 +4,142 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <memory>
+#include "matrix.h"
+
+// IDX元素类型（魔数的第3个字节），多字节类型按大端序存储
+enum class IdxType : unsigned char {
+    UBYTE = 0x08,
+    SBYTE = 0x09,
+    SHORT = 0x0B,
+    INT = 0x0C,
+    FLOAT = 0x0D,
+    DOUBLE = 0x0E
+};
+
+// 元素字节数，不支持的类型返回0
+inline size_t idxTypeSize(IdxType type) {
+    switch (type) {
+    case IdxType::UBYTE:
+    case IdxType::SBYTE:  return 1;
+    case IdxType::SHORT:  return 2;
+    case IdxType::INT:
+    case IdxType::FLOAT:  return 4;
+    case IdxType::DOUBLE: return 8;
+    }
+    return 0;
+}
 
 // MNIST数据结构
+// 样本以IDX原始编码连续存储（num_images x imageSize()个元素），通常直接指向内存映射的
+// IDX文件，不做拷贝（.gz文件解压到自有缓冲区）；取样本时才解码并按pixel_scale转换为double或float
+// （归一化延迟到使用时进行）。支持任意样本维度与元素类型，MNIST为28x28的uint8
 struct MNISTData {
-    std::vector<std::vector<double>> images;
+    const unsigned char* pixels;   // 第一个样本的首字节
+    std::shared_ptr<const void> storage;  // 持有pixels所在的映射文件或缓冲区
     std::vector<int> labels;
-    int image_rows;
-    int image_cols;
+    IdxType pixel_type;
+    std::vector<size_t> sample_shape;  // 每个样本的维度，如MNIST为 {28, 28}
+    int image_rows;   // 样本第一维；一维样本为1
+    int image_cols;   // 其余维度之积
     int num_images;
+    int num_classes;  // 最大标签值+1
+    double pixel_scale;  // 元素值转换为double时乘的系数，归一化后按类型取值（uint8为1/255）
     
     // 构造函数
-    MNISTData() : image_rows(0), image_cols(0), num_images(0) {}
+    MNISTData() : pixels(nullptr), pixel_type(IdxType::UBYTE), image_rows(0), image_cols(0),
+                  num_images(0), num_classes(0), pixel_scale(1.0) {}
+    
+    // 每个样本的元素数
+    size_t imageSize() const { return static_cast<size_t>(image_rows) * image_cols; }
+    // 每个样本的字节数
+    size_t sampleBytes() const { return imageSize() * idxTypeSize(pixel_type); }
+    
+    // 第index个样本的原始字节
+    const unsigned char* image(int index) const { return pixels + static_cast<size_t>(index) * sampleBytes(); }
+    
+    // 将第index个图像转换为double或float写入out（长度为imageSize()）
+    void copyImage(int index, double* out) const;
+    void copyImage(int index, float* out) const;
+    std::vector<double> getImage(int index) const;
+    
+    // 将indices指定的count个图像转换后写入batch的前count行
+    void gatherImages(const int* indices, size_t count, MatrixView batch) const;
+    void gatherImages(const int* indices, size_t count, MatrixViewF batch) const;
+    // 将第 [begin, begin + count) 个图像转换后写入batch的前count行
+    void copyImages(int begin, size_t count, MatrixView batch) const;
+    void copyImages(int begin, size_t count, MatrixViewF batch) const;
     
     // 清理数据
     void clear() {
-        images.clear();
+        pixels = nullptr;
+        storage.reset();
         labels.clear();
+        pixel_type = IdxType::UBYTE;
+        sample_shape.clear();
         image_rows = 0;
         image_cols = 0;
         num_images = 0;
+        num_classes = 0;
+        pixel_scale = 1.0;
     }
 };
 
+class GzipStream;
+class MappedFile;
+
+// ========== IDX文件读取 ==========
+// 解析文件头（元素类型与各维大小），第一维为样本数。数据区可以一次性取得
+// （未压缩文件直接指向内存映射，gzip文件解压到新缓冲区），也可以按样本顺序流式读取，
+// 两种方式只能选其一
+class IdxReader {
+public:
+    IdxReader();
+    ~IdxReader();
+    
+    IdxReader(const IdxReader&) = delete;
+    IdxReader& operator=(const IdxReader&) = delete;
+    
+    // 打开文件并读取文件头，失败时输出错误信息
+    bool open(const std::string& filename);
+    
+    int magic() const { return magic_number; }
+    IdxType type() const { return element_type; }
+    const std::vector<size_t>& dims() const { return dimensions; }
+    size_t count() const { return dimensions.empty() ? 0 : dimensions[0]; }
+    // 每个样本的元素数与字节数
+    size_t sampleSize() const { return sample_size; }
+    size_t sampleBytes() const { return sample_size * idxTypeSize(element_type); }
+    // 数据区总字节数
+    size_t payloadBytes() const { return count() * sampleBytes(); }
+    bool compressed() const { return gzip != nullptr; }
+    
+    // 取得整个数据区，owner持有其所在的内存
+    const unsigned char* loadAll(std::shared_ptr<const void>& owner);
+    
+    // 顺序读取接下来最多max_count个样本的原始字节，返回实际个数；读完或出错时返回0
+    size_t readSamples(unsigned char* out, size_t max_count);
+    bool failed() const { return read_failed; }
+    
+private:
+    std::string name;
+    std::unique_ptr<GzipStream> gzip;
+    std::shared_ptr<const void> storage;  // 未压缩文件的映射或缓冲区
+    const unsigned char* bytes = nullptr;
+    size_t size = 0;
+    size_t offset = 0;      // 未压缩文件的读取位置
+    size_t consumed = 0;    // 已读取的样本数
+    bool read_failed = false;
+    
+    int magic_number = 0;
+    IdxType element_type = IdxType::UBYTE;
+    std::vector<size_t> dimensions;
+    size_t sample_size = 0;
+    
+    bool read(unsigned char* out, size_t n, const char* what);
+    bool finishGzip();
+};
+
 // MNIST数据读取器
 class MNISTReader {
 public:
@@ -40,16 +154,19 @@ public:
                          const std::string& labels_file, 
                          MNISTData& data);
     
-    // 数据预处理：归一化
+    // 数据预处理：按元素类型归一化（只记录缩放系数，取样本时才转换）；
+    // uint8归一化到[0,1]，有符号整数到[-1,1)，int32与浮点数保持原值
     static void normalizeImages(MNISTData& data);
+    static double normalizationScale(IdxType type);
     
-    // 将标签转换为one-hot编码
+    // 将标签转换为one-hot编码（num_labels x num_classes个double，只用于需要稠密目标的场合；
+    // 训练接口可直接接收类别下标，见NeuralNetwork::trainBatch(inputs, labels)）
     static std::vector<std::vector<double>> labelsToOneHot(const std::vector<int>& labels, int num_classes = 10);
     
     // 显示图像（ASCII艺术）
     static void displayImage(const std::vector<double>& image, int rows, int cols);
     
-    // 检查文件是否为GZIP格式
+    // 检查文件是否为GZIP格式（读取时自动流式解压）
     static bool isGzipFile(const std::string& filename);
     
     // 验证MNIST文件格式
@@ -59,11 +176,40 @@ private:
     // 字节序转换函数
     static int reverseInt(int i);
     
-    // 检查魔数
+    // 检查魔数：图像文件至少两维，标签文件为一维整数
     static bool checkMagicNumber(int magic, bool is_images);
     
-    // 安全的内存分配检查
-    static bool checkMemoryRequirement(int num_images, int rows, int cols);
+    // 读取大端序的32位整数
+    static int readBigEndian(const unsigned char* bytes);
+    
+    // 检查数据区能否放入内存；内存映射的文件按需分页，不受物理内存限制
+    static bool checkMemoryRequirement(size_t bytes, bool in_memory);
+};
+
+// ========== 流式读取 ==========
+// 数据集超出内存时按块顺序读取样本：图像文件只保留当前块，
+// 标签（每个样本只有几个字节）在打开时一次性读入
+class MNISTStream {
+public:
+    // normalize为true时按元素类型设置每块的归一化系数
+    bool open(const std::string& images_file, const std::string& labels_file, bool normalize = true);
+    
+    // 读取接下来最多max_count个样本到chunk，返回样本数，读完或出错时返回0。
+    // chunk的像素缓冲区由本对象持有并在每次调用时复用
+    size_t next(MNISTData& chunk, size_t max_count);
+    
+    int size() const { return static_cast<int>(labels.size()); }
+    size_t sampleSize() const { return images.sampleSize(); }
+    int numClasses() const { return num_classes; }
+    bool failed() const { return images.failed(); }
+    
+private:
+    IdxReader images;
+    std::vector<int> labels;
+    int num_classes = 0;
+    size_t position = 0;
+    double pixel_scale = 1.0;
+    std::shared_ptr<std::vector<unsigned char>> buffer;
 };
 
 #endif // MNIST_READER_H
\ No newline at end of file
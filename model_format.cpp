@@ -0,0 +1,154 @@
+#include "model_format.h"
+#include "gzip_stream.h"
+#include <cstdio>
+#include <limits>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+namespace model_format {
+
+bool hasMagic(const unsigned char* data, size_t size) {
+    return size >= sizeof(kMagic) && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+// 文件头布局：
+//   0 magic[8]  8 version  12 num_layers  16 file_size(u64)  24 learning_rate(f64)
+//   32 loss_type  36 optimizer_type  40..60 保留（0）  60 crc
+void encodeHeader(const Header& header, unsigned char* out) {
+    std::memset(out, 0, kHeaderSize);
+    std::memcpy(out, kMagic, sizeof(kMagic));
+    storeU32(out + 8, header.version);
+    storeU32(out + 12, header.num_layers);
+    storeU64(out + 16, header.file_size);
+    storeF64(out + 24, header.learning_rate);
+    storeU32(out + 32, header.loss_type);
+    storeU32(out + 36, header.optimizer_type);
+    storeU32(out + kCrcOffset, header.crc);
+}
+
+// 层记录布局：
+//   0 activation  4 dtype  8 rows  16 cols  24 stride  32 weights_offset  40 biases_offset
+//   48 scales_offset  56 input_scale(f32)  60 input_zero_point   （后三项仅INT8层使用，其余为0）
+void encodeLayerRecord(const LayerRecord& record, unsigned char* out) {
+    std::memset(out, 0, kLayerRecordSize);
+    storeU32(out, record.activation);
+    storeU32(out + 4, static_cast<uint32_t>(record.dtype));
+    storeU64(out + 8, record.rows);
+    storeU64(out + 16, record.cols);
+    storeU64(out + 24, record.stride);
+    storeU64(out + 32, record.weights_offset);
+    storeU64(out + 40, record.biases_offset);
+    if (record.dtype == DataType::INT8) {
+        storeU64(out + 48, record.scales_offset);
+        storeF32(out + 56, record.input_scale);
+        storeU32(out + 60, record.input_zero_point);
+    }
+}
+
+LayerRecord decodeLayerRecord(const unsigned char* p) {
+    LayerRecord record;
+    record.activation = loadU32(p);
+    record.dtype = static_cast<DataType>(loadU32(p + 4));
+    record.rows = loadU64(p + 8);
+    record.cols = loadU64(p + 16);
+    record.stride = loadU64(p + 24);
+    record.weights_offset = loadU64(p + 32);
+    record.biases_offset = loadU64(p + 40);
+    if (record.dtype == DataType::INT8) {
+        record.scales_offset = loadU64(p + 48);
+        record.input_scale = loadF32(p + 56);
+        record.input_zero_point = loadU32(p + 60);
+    }
+    return record;
+}
+
+uint32_t fileCrc(const unsigned char* data, size_t size) {
+    uint32_t crc = crc32Update(0, data, kCrcOffset);
+    return crc32Update(crc, data + kHeaderSize, size - kHeaderSize);
+}
+
+bool decodeHeader(const unsigned char* data, size_t size, Header& header, std::string& error) {
+    if (size < kHeaderSize || !hasMagic(data, size)) {
+        error = "Not a model file";
+        return false;
+    }
+    header.version = loadU32(data + 8);
+    header.num_layers = loadU32(data + 12);
+    header.file_size = loadU64(data + 16);
+    header.learning_rate = loadF64(data + 24);
+    header.loss_type = loadU32(data + 32);
+    header.optimizer_type = loadU32(data + 36);
+    header.crc = loadU32(data + kCrcOffset);
+
+    if (header.version != kVersion) {
+        error = "Unsupported model format version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.file_size != size) {
+        error = "Model file size mismatch (truncated or corrupted file)";
+        return false;
+    }
+    if (header.num_layers > (size - kHeaderSize) / kLayerRecordSize) {
+        error = "Invalid layer count";
+        return false;
+    }
+    if (fileCrc(data, size) != header.crc) {
+        error = "Model file checksum mismatch";
+        return false;
+    }
+    return true;
+}
+
+bool checkLayerRecord(const LayerRecord& record, uint64_t file_size, std::string& error) {
+    size_t element_size = dataTypeSize(record.dtype);
+    if (element_size == 0) {
+        error = "Unsupported tensor data type " + std::to_string(static_cast<uint32_t>(record.dtype));
+        return false;
+    }
+    if (record.rows == 0 || record.cols == 0 || record.stride < record.cols) {
+        error = "Invalid layer dimensions";
+        return false;
+    }
+    bool quantized = record.dtype == DataType::INT8;
+    if (record.weights_offset % kAlignment != 0 || record.biases_offset % kAlignment != 0 ||
+        (quantized && record.scales_offset % kAlignment != 0)) {
+        error = "Misaligned tensor data";
+        return false;
+    }
+    if (quantized && (!(record.input_scale > 0.0f) || record.input_zero_point > 255)) {
+        error = "Invalid input quantization parameters";
+        return false;
+    }
+
+    // 先用除法检查乘法是否溢出，再检查数据是否位于文件内
+    const uint64_t max = std::numeric_limits<uint64_t>::max();
+    if (record.rows > max / record.stride || record.rows * record.stride > max / element_size) {
+        error = "Layer too large";
+        return false;
+    }
+    uint64_t weights_bytes = record.rows * record.stride * element_size;
+    // INT8层的偏置与缩放因子为float32
+    uint64_t biases_bytes = record.rows * (quantized ? 4 : element_size);
+    uint64_t scales_bytes = quantized ? record.rows * 4 : 0;
+    if (record.weights_offset > file_size || weights_bytes > file_size - record.weights_offset ||
+        record.biases_offset > file_size || biases_bytes > file_size - record.biases_offset ||
+        record.scales_offset > file_size || scales_bytes > file_size - record.scales_offset) {
+        error = "Tensor data out of file bounds";
+        return false;
+    }
+    return true;
+}
+
+bool replaceFile(const std::string& temp_path, const std::string& path) {
+#ifdef _WIN32
+    return MoveFileExA(temp_path.c_str(), path.c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(temp_path.c_str(), path.c_str()) == 0;
+#endif
+}
+
+} // namespace model_format
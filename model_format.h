@@ -0,0 +1,175 @@
+#ifndef MODEL_FORMAT_H
+#define MODEL_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// ========== 模型文件格式 ==========
+// 版本化的二进制模型文件，所有整数为定长小端序，浮点数为小端序IEEE 754：
+//   [0, 64)              文件头（魔数、版本、文件长度、训练配置、CRC）
+//   [64, 64 + 64 x L)    L条层记录，每条64字节
+//   之后                 各层的权重与偏置，起点按64字节对齐。权重按行跨度stride存储、行尾补0，
+//                        与Matrix的内存布局一致，映射到内存后可直接作为矩阵视图使用
+// INT8层（量化模型）的权重为有符号8位整数，偏置与每行的缩放因子为float32，
+// 层记录中另有该层输入的量化参数
+// CRC-32覆盖文件中除CRC字段以外的全部字节
+namespace model_format {
+
+constexpr char kMagic[8] = {'B', 'P', 'N', 'N', 'M', 'O', 'D', 'L'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 64;
+constexpr size_t kLayerRecordSize = 64;
+constexpr size_t kAlignment = 64;
+constexpr size_t kCrcOffset = 60;  // 文件头最后4字节
+
+// 张量元素类型，即保存模型的网络的精度；浮点类型读取时可转换为另一种精度
+enum class DataType : uint32_t {
+    FLOAT64 = 1,
+    FLOAT32 = 2,
+    INT8 = 3
+};
+
+inline size_t dataTypeSize(DataType type) {
+    switch (type) {
+        case DataType::FLOAT64: return 8;
+        case DataType::FLOAT32: return 4;
+        case DataType::INT8: return 1;
+        default: return 0;
+    }
+}
+
+// 标量类型对应的元素类型
+template<typename T>
+DataType dataTypeOf();
+template<>
+inline DataType dataTypeOf<double>() { return DataType::FLOAT64; }
+template<>
+inline DataType dataTypeOf<float>() { return DataType::FLOAT32; }
+
+inline const char* dataTypeName(DataType type) {
+    switch (type) {
+        case DataType::FLOAT64: return "float64";
+        case DataType::FLOAT32: return "float32";
+        case DataType::INT8: return "int8";
+        default: return "unknown";
+    }
+}
+
+struct Header {
+    uint32_t version = kVersion;
+    uint32_t num_layers = 0;
+    uint64_t file_size = 0;
+    double learning_rate = 0.0;
+    uint32_t loss_type = 0;
+    uint32_t optimizer_type = 0;
+    uint32_t crc = 0;
+};
+
+struct LayerRecord {
+    uint32_t activation = 0;
+    DataType dtype = DataType::FLOAT64;
+    uint64_t rows = 0;            // 输出维度
+    uint64_t cols = 0;            // 输入维度
+    uint64_t stride = 0;          // 权重的行跨度（元素数），不小于cols
+    uint64_t weights_offset = 0;  // 权重数据在文件中的偏移，64字节对齐
+    uint64_t biases_offset = 0;   // 偏置数据在文件中的偏移，64字节对齐
+    
+    // 以下仅用于INT8层
+    uint64_t scales_offset = 0;     // 每行权重缩放因子（float32）的偏移，64字节对齐
+    float input_scale = 0.0f;       // 输入的量化步长：x ≈ (q - zero_point) * input_scale
+    uint32_t input_zero_point = 0;  // 输入的零点（0..255）
+};
+
+// ========== 小端序读写 ==========
+inline bool hostIsLittleEndian() {
+    const uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+inline void storeU32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+inline void storeU64(unsigned char* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+inline void storeF64(unsigned char* p, double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, 8);
+    storeU64(p, bits);
+}
+
+inline void storeF32(unsigned char* p, float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, 4);
+    storeU32(p, bits);
+}
+
+// 按值的类型写出（double为8字节，float为4字节）
+inline void storeScalar(unsigned char* p, double v) { storeF64(p, v); }
+inline void storeScalar(unsigned char* p, float v) { storeF32(p, v); }
+
+inline uint32_t loadU32(const unsigned char* p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+inline uint64_t loadU64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+inline double loadF64(const unsigned char* p) {
+    uint64_t bits = loadU64(p);
+    double v;
+    std::memcpy(&v, &bits, 8);
+    return v;
+}
+
+inline float loadF32(const unsigned char* p) {
+    uint32_t bits = loadU32(p);
+    float v;
+    std::memcpy(&v, &bits, 4);
+    return v;
+}
+
+// 读取一个type类型的元素；float转换为double是精确的
+inline double loadScalar(const unsigned char* p, DataType type) {
+    return type == DataType::FLOAT32 ? loadF32(p) : loadF64(p);
+}
+
+inline uint64_t alignUp(uint64_t offset) {
+    return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// ========== 编码与校验 ==========
+// 文件以魔数开头即视为本格式，否则按旧格式读取
+bool hasMagic(const unsigned char* data, size_t size);
+
+void encodeHeader(const Header& header, unsigned char* out);
+void encodeLayerRecord(const LayerRecord& record, unsigned char* out);
+LayerRecord decodeLayerRecord(const unsigned char* p);
+
+// 解析并校验文件头：魔数、版本、文件长度与CRC，失败时返回false并写入error
+bool decodeHeader(const unsigned char* data, size_t size, Header& header, std::string& error);
+
+// 校验层记录：元素类型、维度、对齐以及数据是否完全位于文件内
+bool checkLayerRecord(const LayerRecord& record, uint64_t file_size, std::string& error);
+
+// 整个文件的CRC（跳过CRC字段）
+uint32_t fileCrc(const unsigned char* data, size_t size);
+
+// 用临时文件替换目标文件（先写临时文件再重命名），
+// 已映射或正在读取旧文件的进程不受影响，也不会读到写了一半的文件
+bool replaceFile(const std::string& temp_path, const std::string& path);
+
+} // namespace model_format
+
+#endif // MODEL_FORMAT_H
@@ -0,0 +1,485 @@
+#include "quantization.h"
+#include "simd.h"
+#include "mapped_file.h"
+#include "model_format.h"
+#include "gzip_stream.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// int8内核的int32累加在输入维度不超过该值时不会溢出（见simd::Int8Kernels）
+constexpr size_t kMaxQuantizedInputSize = 65535;
+
+// 统计一层输入的取值范围：percentile为1时只记录最小/最大值，否则保留全部取值以求分位数
+class RangeObserver {
+public:
+    explicit RangeObserver(double percentile) : percentile(percentile) {}
+
+    template<typename T>
+    void observe(BasicMatrixView<const T> values) {
+        for (size_t i = 0; i < values.rows(); ++i) {
+            const T* row = values.row(i);
+            for (size_t j = 0; j < values.cols(); ++j) {
+                float v = static_cast<float>(row[j]);
+                lo = std::min(lo, v);
+                hi = std::max(hi, v);
+                if (percentile < 1.0) {
+                    samples.push_back(v);
+                }
+            }
+        }
+    }
+
+    // 量化参数：范围总是包含0，使0（ReLU输出、图像背景）能被精确表示
+    void quantization(float& scale, uint8_t& zero_point) {
+        float low = lo;
+        float high = hi;
+        if (percentile < 1.0 && samples.size() > 1) {
+            size_t k = static_cast<size_t>((1.0 - percentile) * (samples.size() - 1));
+            std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+            low = samples[k];
+            std::nth_element(samples.begin(), samples.end() - 1 - k, samples.end());
+            high = samples[samples.size() - 1 - k];
+        }
+        low = std::min(low, 0.0f);
+        high = std::max(high, 0.0f);
+        float range = high - low;
+        if (!(range > 0.0f) || !std::isfinite(range)) {
+            range = 1.0f;
+        }
+        scale = range / 255.0f;
+        float zp = std::round(-low / scale);
+        zero_point = static_cast<uint8_t>(std::min(std::max(zp, 0.0f), 255.0f));
+    }
+
+private:
+    double percentile;
+    float lo = std::numeric_limits<float>::max();
+    float hi = std::numeric_limits<float>::lowest();
+    std::vector<float> samples;
+};
+
+// 对称量化一行权重，返回缩放因子
+template<typename T>
+float quantizeRow(const T* w, size_t n, int8_t* q) {
+    float max_abs = 0.0f;
+    for (size_t j = 0; j < n; ++j) {
+        max_abs = std::max(max_abs, std::abs(static_cast<float>(w[j])));
+    }
+    float scale = max_abs > 0.0f ? max_abs / 127.0f : 1.0f;
+    for (size_t j = 0; j < n; ++j) {
+        float v = std::round(static_cast<float>(w[j]) / scale);
+        q[j] = static_cast<int8_t>(std::min(std::max(v, -127.0f), 127.0f));
+    }
+    return scale;
+}
+
+// x -> clamp(round(x / scale) + zero_point, 0, 255)；先钳位再加0.5截断，循环可向量化
+void quantizeInput(const float* x, size_t n, float inv_scale, float zero_point, uint8_t* q) {
+    for (size_t j = 0; j < n; ++j) {
+        float v = x[j] * inv_scale + zero_point;
+        v = std::min(std::max(v, 0.0f), 255.0f);
+        q[j] = static_cast<uint8_t>(v + 0.5f);
+    }
+}
+
+} // namespace
+
+// ========== 量化 ==========
+template<typename T>
+void QuantizedNetwork::quantize(const BasicNeuralNetwork<T>& network, ConstMatrixViewF calibration,
+                                double percentile) {
+    if (network.getOutputSize() == 0) {
+        throw std::invalid_argument("Network has no layers");
+    }
+    if (calibration.rows() == 0 || calibration.cols() != network.getInputSize()) {
+        throw std::invalid_argument("Calibration data size mismatch");
+    }
+    if (!(percentile > 0.0 && percentile <= 1.0)) {
+        throw std::invalid_argument("Calibration percentile must be in (0, 1]");
+    }
+
+    BasicNetworkState<T> state;
+    network.snapshotState(state);
+    for (const auto& layer : state.layers) {
+        if (layer.weights.cols() > kMaxQuantizedInputSize) {
+            throw std::invalid_argument("Layer input size too large for int8 accumulation");
+        }
+    }
+
+    // 分块前向传播：第0层的输入是校准样本，第i层的输入是第i-1层的输出
+    std::vector<RangeObserver> observers(state.layers.size(), RangeObserver(percentile));
+    constexpr size_t kChunkRows = 256;
+    BasicMatrix<T> chunk;
+    BasicInferenceContext<T> ctx;
+    for (size_t begin = 0; begin < calibration.rows(); begin += kChunkRows) {
+        size_t count = std::min(kChunkRows, calibration.rows() - begin);
+        chunk.resize(count, calibration.cols());
+        for (size_t b = 0; b < count; ++b) {
+            const float* src = calibration.row(begin + b);
+            std::copy(src, src + calibration.cols(), chunk.row(b));
+        }
+        network.predict(chunk.view(), ctx);
+        observers[0].observe(calibration.rowRange(begin, count));
+        for (size_t i = 1; i < observers.size(); ++i) {
+            observers[i].observe(ctx.layerOutput(i - 1, count));
+        }
+    }
+
+    std::vector<QuantizedLayer> quantized(state.layers.size());
+    for (size_t i = 0; i < state.layers.size(); ++i) {
+        const auto& src = state.layers[i];
+        QuantizedLayer& layer = quantized[i];
+        size_t rows = src.weights.rows();
+        size_t cols = src.weights.cols();
+        layer.activation = src.activation;
+        layer.weights.resize(rows, cols);
+        layer.scales.resize(rows);
+        layer.biases.assign(src.biases.begin(), src.biases.end());
+        for (size_t r = 0; r < rows; ++r) {
+            layer.scales[r] = quantizeRow(src.weights.row(r), cols, layer.weights.row(r));
+        }
+        computeRowSums(layer);
+        observers[i].quantization(layer.input_scale, layer.input_zero_point);
+    }
+
+    layers = std::move(quantized);
+    learning_rate = state.learning_rate;
+    loss_type = state.loss_type;
+    optimizer_type = state.optimizer_type;
+}
+
+void QuantizedNetwork::computeRowSums(QuantizedLayer& layer) {
+    layer.row_sums.assign(layer.weights.rows(), 0);
+    for (size_t r = 0; r < layer.weights.rows(); ++r) {
+        const int8_t* w = layer.weights.row(r);
+        int32_t sum = 0;
+        for (size_t j = 0; j < layer.weights.cols(); ++j) {
+            sum += w[j];
+        }
+        layer.row_sums[r] = sum;
+    }
+}
+
+size_t QuantizedNetwork::parameterCount() const {
+    size_t count = 0;
+    for (const QuantizedLayer& layer : layers) {
+        count += layer.weights.rows() * layer.weights.cols() + layer.biases.size();
+    }
+    return count;
+}
+
+size_t QuantizedNetwork::parameterBytes() const {
+    size_t bytes = 0;
+    for (const QuantizedLayer& layer : layers) {
+        bytes += layer.weights.rows() * layer.weights.cols() * sizeof(int8_t);
+        bytes += (layer.scales.size() + layer.biases.size()) * sizeof(float);
+    }
+    return bytes;
+}
+
+// ========== 推理 ==========
+void QuantizedNetwork::prepareContext(QuantizedInferenceContext& ctx, size_t batch_size) const {
+    size_t max_input = 0;
+    for (const QuantizedLayer& layer : layers) {
+        max_input = std::max(max_input, layer.weights.cols());
+    }
+    if (ctx.codes.rows() < batch_size || ctx.codes.cols() != max_input) {
+        ctx.codes.resize(std::max(batch_size, ctx.codes.rows()), max_input);
+    }
+
+    ctx.activations.resize(layers.size());
+    for (size_t i = 0; i < layers.size(); ++i) {
+        MatrixF& a = ctx.activations[i];
+        size_t output_size = layers[i].weights.rows();
+        if (a.rows() < batch_size || a.cols() != output_size) {
+            a.resize(std::max(batch_size, a.rows()), output_size);
+        }
+    }
+}
+
+ConstMatrixViewF QuantizedNetwork::predict(ConstMatrixViewF inputs, QuantizedInferenceContext& ctx) const {
+    if (layers.empty()) {
+        throw std::invalid_argument("Quantized network has no layers");
+    }
+    if (inputs.cols() != getInputSize()) {
+        throw std::invalid_argument("Input size mismatch");
+    }
+
+    prepareContext(ctx, inputs.rows());
+    const simd::Int8Kernels& kernels = simd::int8Kernels();
+    ConstMatrixViewF current = inputs;
+    for (size_t i = 0; i < layers.size(); ++i) {
+        const QuantizedLayer& layer = layers[i];
+        size_t n = layer.weights.rows();
+        size_t k = layer.weights.cols();
+        float inv_scale = 1.0f / layer.input_scale;
+        int32_t zero_point = layer.input_zero_point;
+        MatrixViewF output = ctx.activations[i].view().rowRange(0, inputs.rows());
+
+        // 每个样本：量化输入，整数GEMV（4行一组共用输入的加载），换算回float后施加激活
+        for (size_t b = 0; b < inputs.rows(); ++b) {
+            uint8_t* q = ctx.codes.row(b);
+            quantizeInput(current.row(b), k, inv_scale, static_cast<float>(zero_point), q);
+
+            float* z = output.row(b);
+            auto dequantize = [&](size_t r, int32_t acc) {
+                int64_t centered = static_cast<int64_t>(acc) - static_cast<int64_t>(zero_point) * layer.row_sums[r];
+                z[r] = static_cast<float>(centered) * (layer.scales[r] * layer.input_scale) + layer.biases[r];
+            };
+
+            size_t r = 0;
+            int32_t acc[4];
+            for (; r + 4 <= n; r += 4) {
+                const int8_t* w[4] = {layer.weights.row(r), layer.weights.row(r + 1),
+                                      layer.weights.row(r + 2), layer.weights.row(r + 3)};
+                kernels.dot4(w, q, k, acc);
+                for (size_t t = 0; t < 4; ++t) {
+                    dequantize(r + t, acc[t]);
+                }
+            }
+            for (; r < n; ++r) {
+                dequantize(r, kernels.dot(q, layer.weights.row(r), k));
+            }
+
+            BasicActivationFunction<float>::applyInPlace(layer.activation, z, n);
+        }
+        current = output;
+    }
+
+    return current;
+}
+
+void QuantizedNetwork::predictBatch(ConstMatrixViewF inputs, MatrixViewF outputs) const {
+    if (outputs.rows() != inputs.rows() || outputs.cols() != getOutputSize()) {
+        throw std::invalid_argument("Output buffer size mismatch");
+    }
+
+    // 与浮点网络一样分块，每块的中间结果可常驻缓存
+    constexpr size_t kChunkRows = 256;
+    QuantizedInferenceContext ctx;
+    for (size_t begin = 0; begin < inputs.rows(); begin += kChunkRows) {
+        size_t count = std::min(kChunkRows, inputs.rows() - begin);
+        ConstMatrixViewF result = predict(inputs.rowRange(begin, count), ctx);
+        for (size_t b = 0; b < count; ++b) {
+            std::copy(result.row(b), result.row(b) + result.cols(), outputs.row(begin + b));
+        }
+    }
+}
+
+// ========== 保存与读取 ==========
+bool QuantizedNetwork::saveModel(const std::string& filename) const {
+    using namespace model_format;
+
+    if (layers.empty()) {
+        std::cerr << "Error: Quantized network has no layers" << std::endl;
+        return false;
+    }
+
+    // 先写临时文件，完整写入后再替换目标文件
+    std::string temp_path = filename + ".tmp";
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Cannot open file for saving: " << temp_path << std::endl;
+        return false;
+    }
+
+    std::cout << "Saving quantized model to: " << filename << std::endl;
+
+    Header header;
+    header.num_layers = static_cast<uint32_t>(layers.size());
+    header.learning_rate = learning_rate;
+    header.loss_type = static_cast<uint32_t>(loss_type);
+    header.optimizer_type = static_cast<uint32_t>(optimizer_type);
+
+    // 布局：每层依次存放权重、偏置与缩放因子，各自按64字节对齐
+    std::vector<LayerRecord> records(layers.size());
+    uint64_t offset = kHeaderSize + kLayerRecordSize * layers.size();
+    for (size_t i = 0; i < layers.size(); ++i) {
+        const QuantizedLayer& layer = layers[i];
+        LayerRecord& record = records[i];
+        record.activation = static_cast<uint32_t>(layer.activation);
+        record.dtype = DataType::INT8;
+        record.rows = layer.weights.rows();
+        record.cols = layer.weights.cols();
+        record.stride = layer.weights.stride();
+        record.weights_offset = alignUp(offset);
+        offset = record.weights_offset + record.rows * record.stride;
+        record.biases_offset = alignUp(offset);
+        offset = record.biases_offset + record.rows * 4;
+        record.scales_offset = alignUp(offset);
+        offset = record.scales_offset + record.rows * 4;
+        record.input_scale = layer.input_scale;
+        record.input_zero_point = layer.input_zero_point;
+    }
+    header.file_size = offset;
+
+    // 顺序写出并累积CRC（跳过CRC字段），最后回填CRC
+    uint32_t crc = 0;
+    uint64_t written = 0;
+    auto emit = [&](const unsigned char* data, size_t size) {
+        file.write(reinterpret_cast<const char*>(data), size);
+        crc = crc32Update(crc, data, size);
+        written += size;
+    };
+    auto padTo = [&](uint64_t target) {
+        static const unsigned char zeros[kAlignment] = {};
+        emit(zeros, static_cast<size_t>(target - written));
+    };
+    auto emitFloats = [&](const std::vector<float>& values) {
+        std::vector<unsigned char> buffer(values.size() * 4);
+        for (size_t j = 0; j < values.size(); ++j) {
+            storeF32(buffer.data() + j * 4, values[j]);
+        }
+        emit(buffer.data(), buffer.size());
+    };
+
+    unsigned char block[kHeaderSize];
+    encodeHeader(header, block);
+    file.write(reinterpret_cast<const char*>(block), kHeaderSize);
+    crc = crc32Update(crc, block, kCrcOffset);
+    written = kHeaderSize;
+    for (const LayerRecord& record : records) {
+        encodeLayerRecord(record, block);
+        emit(block, kLayerRecordSize);
+    }
+
+    for (size_t i = 0; i < layers.size(); ++i) {
+        const QuantizedLayer& layer = layers[i];
+        // int8没有字节序问题，行尾的补齐部分为0，整块写出
+        padTo(records[i].weights_offset);
+        emit(reinterpret_cast<const unsigned char*>(layer.weights.data()),
+             layer.weights.rows() * layer.weights.stride());
+        padTo(records[i].biases_offset);
+        emitFloats(layer.biases);
+        padTo(records[i].scales_offset);
+        emitFloats(layer.scales);
+    }
+
+    storeU32(block, crc);
+    file.seekp(kCrcOffset);
+    file.write(reinterpret_cast<const char*>(block), 4);
+    file.close();
+    if (!file) {
+        std::cerr << "Error: Failed to write model file: " << temp_path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    if (!replaceFile(temp_path, filename)) {
+        std::cerr << "Error: Cannot replace model file: " << filename << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    std::cout << "Quantized model saved successfully! (" << header.file_size << " bytes)" << std::endl;
+    return true;
+}
+
+bool QuantizedNetwork::loadModel(const std::string& filename) {
+    MappedFile mapping;
+    if (mapping.open(filename)) {
+        return loadFromMemory(mapping.data(), mapping.size());
+    }
+
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        std::cerr << "Error: Cannot open file for loading: " << filename << std::endl;
+        return false;
+    }
+    std::vector<unsigned char> contents(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(contents.data()), contents.size());
+    if (!file) {
+        std::cerr << "Error: Failed to read model file: " << filename << std::endl;
+        return false;
+    }
+    return loadFromMemory(contents.data(), contents.size());
+}
+
+bool QuantizedNetwork::loadFromMemory(const unsigned char* data, size_t size) {
+    using namespace model_format;
+
+    std::string error;
+    Header header;
+    if (!decodeHeader(data, size, header, error)) {
+        std::cerr << "Error loading quantized model: " << error << std::endl;
+        return false;
+    }
+    if (header.loss_type > static_cast<uint32_t>(LossType::CROSS_ENTROPY) ||
+        header.optimizer_type > static_cast<uint32_t>(OptimizerType::LAMB)) {
+        std::cerr << "Error loading quantized model: Invalid training configuration" << std::endl;
+        return false;
+    }
+
+    // 全部层校验通过后才替换当前网络；权重复制到对齐的矩阵中，不保留映射
+    std::vector<QuantizedLayer> loaded(header.num_layers);
+    for (size_t i = 0; i < header.num_layers; ++i) {
+        LayerRecord record = decodeLayerRecord(data + kHeaderSize + i * kLayerRecordSize);
+        if (!checkLayerRecord(record, size, error)) {
+            std::cerr << "Error loading quantized model: Layer " << i << ": " << error << std::endl;
+            return false;
+        }
+        if (record.dtype != DataType::INT8) {
+            std::cerr << "Error loading quantized model: Layer " << i << ": "
+                      << dataTypeName(record.dtype) << " layer, not a quantized model" << std::endl;
+            return false;
+        }
+        if (record.activation > static_cast<uint32_t>(ActivationType::SOFTMAX) ||
+            record.cols > kMaxQuantizedInputSize ||
+            (i > 0 && record.cols != loaded[i - 1].weights.rows())) {
+            std::cerr << "Error loading quantized model: Layer " << i << ": Invalid layer" << std::endl;
+            return false;
+        }
+
+        QuantizedLayer& layer = loaded[i];
+        size_t rows = static_cast<size_t>(record.rows);
+        size_t cols = static_cast<size_t>(record.cols);
+        layer.activation = static_cast<ActivationType>(record.activation);
+        layer.weights.resize(rows, cols);
+        for (size_t r = 0; r < rows; ++r) {
+            const unsigned char* src = data + record.weights_offset + r * record.stride;
+            std::memcpy(layer.weights.row(r), src, cols);
+        }
+        layer.biases.resize(rows);
+        layer.scales.resize(rows);
+        for (size_t r = 0; r < rows; ++r) {
+            layer.biases[r] = loadF32(data + record.biases_offset + r * 4);
+            layer.scales[r] = loadF32(data + record.scales_offset + r * 4);
+        }
+        layer.input_scale = record.input_scale;
+        layer.input_zero_point = static_cast<uint8_t>(record.input_zero_point);
+        computeRowSums(layer);
+    }
+
+    layers = std::move(loaded);
+    learning_rate = header.learning_rate;
+    loss_type = static_cast<LossType>(header.loss_type);
+    optimizer_type = static_cast<OptimizerType>(header.optimizer_type);
+    std::cout << "Quantized model loaded successfully! (" << layers.size() << " layers)" << std::endl;
+    return true;
+}
+
+void QuantizedNetwork::printInfo() const {
+    std::cout << "Quantized Network Information:" << std::endl;
+    std::cout << "Number of layers: " << layers.size() << std::endl;
+    std::cout << "Precision: int8 weights (per-channel), uint8 activations" << std::endl;
+    for (size_t i = 0; i < layers.size(); ++i) {
+        const QuantizedLayer& layer = layers[i];
+        std::cout << "Layer " << i << ": " << layer.weights.cols() << " -> " << layer.weights.rows()
+                  << " (input scale " << layer.input_scale
+                  << ", zero point " << static_cast<int>(layer.input_zero_point) << ")" << std::endl;
+    }
+    std::cout << "Parameter bytes: " << parameterBytes() << std::endl;
+    std::cout << "Int8 kernels: " << simd::isaName(simd::int8Kernels().isa) << std::endl;
+}
+
+// ========== 显式实例化 ==========
+template void QuantizedNetwork::quantize<float>(const NeuralNetworkF&, ConstMatrixViewF, double);
+template void QuantizedNetwork::quantize<double>(const NeuralNetwork&, ConstMatrixViewF, double);
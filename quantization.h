@@ -0,0 +1,99 @@
+#ifndef QUANTIZATION_H
+#define QUANTIZATION_H
+
+#include "bpnn.h"
+#include "matrix.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ========== 训练后int8量化 ==========
+// 权重：每个输出通道（权重矩阵的一行）一个缩放因子的对称int8，w ≈ q·scale，q ∈ [-127, 127]
+// 激活：每层的输入一组缩放因子与零点的非对称uint8，x ≈ (q - zero_point)·scale，
+//       范围由校准样本前向传播时统计的各层激活分布确定
+// 加权和以int32累加，再换算回float加上偏置并施加激活：
+//   z_i = scale_i·input_scale·(Σ q_w·q_x - zero_point·Σ q_w) + b_i
+// 其中 Σ q_w（每行权重量化值之和）在量化时预先算好
+
+struct QuantizationConfig {
+    size_t calibration_samples = 1000;  // 校准样本数，从训练集中均匀抽取
+    double percentile = 1.0;            // 以激活分布的该分位数作为范围（1.0即最小/最大值），小于1时剔除离群值
+};
+
+struct QuantizationReport {
+    double float_accuracy = 0.0;
+    double quantized_accuracy = 0.0;
+    size_t float_bytes = 0;      // 浮点模型参数（权重与偏置）的字节数
+    size_t quantized_bytes = 0;  // 量化模型参数（含每行缩放因子）的字节数
+
+    double accuracyDelta() const { return quantized_accuracy - float_accuracy; }
+};
+
+// 量化推理的中间结果，与InferenceContext一样每个线程一份
+class QuantizedInferenceContext {
+public:
+    QuantizedInferenceContext() = default;
+
+    // 当前可容纳的最大批大小
+    size_t capacity() const { return activations.empty() ? 0 : activations[0].rows(); }
+
+private:
+    friend class QuantizedNetwork;
+    BasicMatrix<uint8_t> codes;      // 当前层输入的量化值，capacity x 最大输入维度
+    std::vector<MatrixF> activations;  // 每层输出一份 capacity x output_size
+};
+
+// int8量化网络：只用于推理，由浮点网络量化得到或从量化模型文件读取
+class QuantizedNetwork {
+public:
+    QuantizedNetwork() = default;
+
+    // 用calibration（每行一个样本）做前向传播，统计各层输入的范围，并按行量化权重。
+    // percentile含义同QuantizationConfig
+    template<typename T>
+    void quantize(const BasicNeuralNetwork<T>& network, ConstMatrixViewF calibration, double percentile = 1.0);
+
+    bool empty() const { return layers.empty(); }
+    size_t getInputSize() const { return layers.empty() ? 0 : layers.front().weights.cols(); }
+    size_t getOutputSize() const { return layers.empty() ? 0 : layers.back().weights.rows(); }
+    size_t getNumLayers() const { return layers.size(); }
+    // 参数个数（权重与偏置，与原浮点网络相同）
+    size_t parameterCount() const;
+    // 参数占用的字节数（int8权重、float缩放因子与偏置）
+    size_t parameterBytes() const;
+
+    // 预先按批大小分配ctx的缓冲区
+    void prepareContext(QuantizedInferenceContext& ctx, size_t batch_size = 1) const;
+    // 只读推理：inputs每行一个样本，返回ctx中输出的视图（在下次使用ctx前有效）
+    ConstMatrixViewF predict(ConstMatrixViewF inputs, QuantizedInferenceContext& ctx) const;
+    // 批量推理：结果写入 N x 输出维度 的outputs
+    void predictBatch(ConstMatrixViewF inputs, MatrixViewF outputs) const;
+
+    // 以INT8层保存为版本化模型文件；浮点网络读取该文件时会提示改用QuantizedNetwork
+    bool saveModel(const std::string& filename) const;
+    bool loadModel(const std::string& filename);
+
+    void printInfo() const;
+
+private:
+    struct QuantizedLayer {
+        ActivationType activation = ActivationType::SIGMOID;
+        BasicMatrix<int8_t> weights;   // output_size x input_size，行跨度按64字节对齐
+        std::vector<float> scales;     // 每行权重的缩放因子
+        std::vector<float> biases;
+        std::vector<int32_t> row_sums; // 每行权重量化值之和，用于扣除输入零点
+        float input_scale = 1.0f;
+        uint8_t input_zero_point = 0;
+    };
+
+    std::vector<QuantizedLayer> layers;
+    // 原网络的训练配置，随模型文件保存
+    double learning_rate = 0.0;
+    LossType loss_type = LossType::MEAN_SQUARED_ERROR;
+    OptimizerType optimizer_type = OptimizerType::SGD;
+
+    static void computeRowSums(QuantizedLayer& layer);
+    bool loadFromMemory(const unsigned char* data, size_t size);
+};
+
+#endif // QUANTIZATION_H
@@ -0,0 +1,660 @@
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BPNN_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace simd {
+
+// ========== 标量实现 ==========
+namespace scalar {
+
+struct OpsF64 {
+    using Scalar = double;
+    using Vec = double;
+    using Mask = bool;
+    static constexpr std::size_t W = 1;
+
+    static Vec load(const double* p) { return *p; }
+    static void store(double* p, Vec v) { *p = v; }
+    static Vec set1(double x) { return x; }
+    static Vec zero() { return 0.0; }
+    static Vec add(Vec a, Vec b) { return a + b; }
+    static Vec sub(Vec a, Vec b) { return a - b; }
+    static Vec mul(Vec a, Vec b) { return a * b; }
+    static Vec div(Vec a, Vec b) { return a / b; }
+    static Vec fmadd(Vec a, Vec b, Vec c) { return a * b + c; }
+    static Vec fnmadd(Vec a, Vec b, Vec c) { return c - a * b; }
+    static Vec max(Vec a, Vec b) { return a > b ? a : b; }
+    static Vec min(Vec a, Vec b) { return a < b ? a : b; }
+    static Vec sqrt(Vec a) { return std::sqrt(a); }
+    static double hsum(Vec a) { return a; }
+    static Mask gt(Vec a, Vec b) { return a > b; }
+    static Mask lt(Vec a, Vec b) { return a < b; }
+    static Vec select(Mask m, Vec a, Vec b) { return m ? a : b; }
+    static Vec pow2i(Vec n) {
+        std::int64_t bits = (static_cast<std::int64_t>(n) + 1023) << 52;
+        double result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+};
+
+struct OpsF32 {
+    using Scalar = float;
+    using Vec = float;
+    using Mask = bool;
+    static constexpr std::size_t W = 1;
+
+    static Vec load(const float* p) { return *p; }
+    static void store(float* p, Vec v) { *p = v; }
+    static Vec set1(float x) { return x; }
+    static Vec zero() { return 0.0f; }
+    static Vec add(Vec a, Vec b) { return a + b; }
+    static Vec sub(Vec a, Vec b) { return a - b; }
+    static Vec mul(Vec a, Vec b) { return a * b; }
+    static Vec div(Vec a, Vec b) { return a / b; }
+    static Vec fmadd(Vec a, Vec b, Vec c) { return a * b + c; }
+    static Vec fnmadd(Vec a, Vec b, Vec c) { return c - a * b; }
+    static Vec max(Vec a, Vec b) { return a > b ? a : b; }
+    static Vec min(Vec a, Vec b) { return a < b ? a : b; }
+    static Vec sqrt(Vec a) { return std::sqrt(a); }
+    static float hsum(Vec a) { return a; }
+    static Mask gt(Vec a, Vec b) { return a > b; }
+    static Mask lt(Vec a, Vec b) { return a < b; }
+    static Vec select(Mask m, Vec a, Vec b) { return m ? a : b; }
+    static Vec pow2i(Vec n) {
+        std::int32_t bits = (static_cast<std::int32_t>(n) + 127) << 23;
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+};
+
+struct OpsI8 {
+    using Acc = std::int32_t;
+    static constexpr std::size_t W = 1;
+
+    static Acc zero() { return 0; }
+    static Acc madd(Acc acc, const std::uint8_t* x, const std::int8_t* w) {
+        return acc + static_cast<std::int32_t>(*x) * *w;
+    }
+    static std::int32_t hsum(Acc acc) { return acc; }
+};
+
+struct OpsBf16 {
+    static constexpr std::size_t W = 1;
+
+    static void encode(const float* x, std::uint16_t* y) { *y = toBf16(*x); }
+    static void decode(const std::uint16_t* x, float* y) { *y = fromBf16(*x); }
+    static void round(const float* x, float* y) { *y = fromBf16(toBf16(*x)); }
+};
+
+#include "simd_kernels.inl"
+
+} // namespace scalar
+
+#if BPNN_SIMD_X86
+
+// 2^52 + 1023：加到整数值n上后，低52位即为n + 1023（IEEE754指数偏置）
+#define BPNN_POW2_MAGIC 4503599627371519.0
+// 2^23 + 127：单精度的对应常数，低23位即为n + 127
+#define BPNN_POW2_MAGIC_F 8388735.0f
+
+// ========== SSE2实现 ==========
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+namespace sse2 {
+
+struct OpsF64 {
+    using Scalar = double;
+    using Vec = __m128d;
+    using Mask = __m128d;
+    static constexpr std::size_t W = 2;
+
+    static Vec load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, Vec v) { _mm_storeu_pd(p, v); }
+    static Vec set1(double x) { return _mm_set1_pd(x); }
+    static Vec zero() { return _mm_setzero_pd(); }
+    static Vec add(Vec a, Vec b) { return _mm_add_pd(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm_sub_pd(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm_mul_pd(a, b); }
+    static Vec div(Vec a, Vec b) { return _mm_div_pd(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static Vec fnmadd(Vec a, Vec b, Vec c) { return _mm_sub_pd(c, _mm_mul_pd(a, b)); }
+    static Vec max(Vec a, Vec b) { return _mm_max_pd(a, b); }
+    static Vec min(Vec a, Vec b) { return _mm_min_pd(a, b); }
+    static Vec sqrt(Vec a) { return _mm_sqrt_pd(a); }
+    static double hsum(Vec a) { return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a))); }
+    static Mask gt(Vec a, Vec b) { return _mm_cmpgt_pd(a, b); }
+    static Mask lt(Vec a, Vec b) { return _mm_cmplt_pd(a, b); }
+    static Vec select(Mask m, Vec a, Vec b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+    static Vec pow2i(Vec n) {
+        __m128i bits = _mm_castpd_si128(_mm_add_pd(n, _mm_set1_pd(BPNN_POW2_MAGIC)));
+        return _mm_castsi128_pd(_mm_slli_epi64(bits, 52));
+    }
+};
+
+struct OpsF32 {
+    using Scalar = float;
+    using Vec = __m128;
+    using Mask = __m128;
+    static constexpr std::size_t W = 4;
+
+    static Vec load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, Vec v) { _mm_storeu_ps(p, v); }
+    static Vec set1(float x) { return _mm_set1_ps(x); }
+    static Vec zero() { return _mm_setzero_ps(); }
+    static Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+    static Vec div(Vec a, Vec b) { return _mm_div_ps(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static Vec fnmadd(Vec a, Vec b, Vec c) { return _mm_sub_ps(c, _mm_mul_ps(a, b)); }
+    static Vec max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+    static Vec min(Vec a, Vec b) { return _mm_min_ps(a, b); }
+    static Vec sqrt(Vec a) { return _mm_sqrt_ps(a); }
+    static float hsum(Vec a) {
+        __m128 pairs = _mm_add_ps(a, _mm_movehl_ps(a, a));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+    static Mask gt(Vec a, Vec b) { return _mm_cmpgt_ps(a, b); }
+    static Mask lt(Vec a, Vec b) { return _mm_cmplt_ps(a, b); }
+    static Vec select(Mask m, Vec a, Vec b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    static Vec pow2i(Vec n) {
+        __m128i bits = _mm_castps_si128(_mm_add_ps(n, _mm_set1_ps(BPNN_POW2_MAGIC_F)));
+        return _mm_castsi128_ps(_mm_slli_epi32(bits, 23));
+    }
+};
+
+// u8零扩展、i8符号扩展为16位（SSE2没有pmovsx，用解包后算术右移实现），pmaddwd相乘并两两相加
+struct OpsI8 {
+    using Acc = __m128i;
+    static constexpr std::size_t W = 16;
+
+    static Acc zero() { return _mm_setzero_si128(); }
+    static Acc madd(Acc acc, const std::uint8_t* x, const std::int8_t* w) {
+        __m128i xv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x));
+        __m128i wv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w));
+        __m128i zero = _mm_setzero_si128();
+        __m128i x_lo = _mm_unpacklo_epi8(xv, zero);
+        __m128i x_hi = _mm_unpackhi_epi8(xv, zero);
+        __m128i w_lo = _mm_srai_epi16(_mm_unpacklo_epi8(wv, wv), 8);
+        __m128i w_hi = _mm_srai_epi16(_mm_unpackhi_epi8(wv, wv), 8);
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(x_lo, w_lo));
+        return _mm_add_epi32(acc, _mm_madd_epi16(x_hi, w_hi));
+    }
+    static std::int32_t hsum(Acc acc) {
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(acc);
+    }
+};
+
+// 舍入在32位整数通道上进行：加上0x7FFF与保留位的最低位后取高16位；NaN只置静默位
+struct OpsBf16 {
+    static constexpr std::size_t W = 8;
+
+    static __m128i roundBits(__m128 x) {
+        __m128i bits = _mm_castps_si128(x);
+        __m128i lsb = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(1));
+        __m128i rounded = _mm_add_epi32(bits, _mm_add_epi32(lsb, _mm_set1_epi32(0x7FFF)));
+        __m128i nan = _mm_castps_si128(_mm_cmpunord_ps(x, x));
+        __m128i quiet = _mm_or_si128(bits, _mm_set1_epi32(0x00400000));
+        return _mm_or_si128(_mm_and_si128(nan, quiet), _mm_andnot_si128(nan, rounded));
+    }
+    // 高16位算术右移后落在int16范围内，有符号饱和打包不会改变数值
+    static void encode(const float* x, std::uint16_t* y) {
+        __m128i lo = _mm_srai_epi32(roundBits(_mm_loadu_ps(x)), 16);
+        __m128i hi = _mm_srai_epi32(roundBits(_mm_loadu_ps(x + 4)), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y), _mm_packs_epi32(lo, hi));
+    }
+    static void decode(const std::uint16_t* x, float* y) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x));
+        __m128i zero = _mm_setzero_si128();
+        _mm_storeu_ps(y, _mm_castsi128_ps(_mm_unpacklo_epi16(zero, v)));
+        _mm_storeu_ps(y + 4, _mm_castsi128_ps(_mm_unpackhi_epi16(zero, v)));
+    }
+    static void round(const float* x, float* y) {
+        __m128i mask = _mm_set1_epi32(static_cast<int>(0xFFFF0000u));
+        _mm_storeu_ps(y, _mm_castsi128_ps(_mm_and_si128(roundBits(_mm_loadu_ps(x)), mask)));
+        _mm_storeu_ps(y + 4, _mm_castsi128_ps(_mm_and_si128(roundBits(_mm_loadu_ps(x + 4)), mask)));
+    }
+};
+
+#include "simd_kernels.inl"
+
+} // namespace sse2
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+// ========== AVX2实现 ==========
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+namespace avx2 {
+
+struct OpsF64 {
+    using Scalar = double;
+    using Vec = __m256d;
+    using Mask = __m256d;
+    static constexpr std::size_t W = 4;
+
+    static Vec load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, Vec v) { _mm256_storeu_pd(p, v); }
+    static Vec set1(double x) { return _mm256_set1_pd(x); }
+    static Vec zero() { return _mm256_setzero_pd(); }
+    static Vec add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+    static Vec div(Vec a, Vec b) { return _mm256_div_pd(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) { return _mm256_fmadd_pd(a, b, c); }
+    static Vec fnmadd(Vec a, Vec b, Vec c) { return _mm256_fnmadd_pd(a, b, c); }
+    static Vec max(Vec a, Vec b) { return _mm256_max_pd(a, b); }
+    static Vec min(Vec a, Vec b) { return _mm256_min_pd(a, b); }
+    static Vec sqrt(Vec a) { return _mm256_sqrt_pd(a); }
+    static double hsum(Vec a) {
+        __m128d lo = _mm256_castpd256_pd128(a);
+        __m128d hi = _mm256_extractf128_pd(a, 1);
+        lo = _mm_add_pd(lo, hi);
+        return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+    }
+    static Mask gt(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    static Mask lt(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_pd(b, a, m); }
+    static Vec pow2i(Vec n) {
+        __m256i bits = _mm256_castpd_si256(_mm256_add_pd(n, _mm256_set1_pd(BPNN_POW2_MAGIC)));
+        return _mm256_castsi256_pd(_mm256_slli_epi64(bits, 52));
+    }
+};
+
+struct OpsF32 {
+    using Scalar = float;
+    using Vec = __m256;
+    using Mask = __m256;
+    static constexpr std::size_t W = 8;
+
+    static Vec load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, Vec v) { _mm256_storeu_ps(p, v); }
+    static Vec set1(float x) { return _mm256_set1_ps(x); }
+    static Vec zero() { return _mm256_setzero_ps(); }
+    static Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+    static Vec div(Vec a, Vec b) { return _mm256_div_ps(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) { return _mm256_fmadd_ps(a, b, c); }
+    static Vec fnmadd(Vec a, Vec b, Vec c) { return _mm256_fnmadd_ps(a, b, c); }
+    static Vec max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+    static Vec min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+    static Vec sqrt(Vec a) { return _mm256_sqrt_ps(a); }
+    static float hsum(Vec a) {
+        __m128 lo = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+        __m128 pairs = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+    static Mask gt(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static Mask lt(Vec a, Vec b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_ps(b, a, m); }
+    static Vec pow2i(Vec n) {
+        __m256i bits = _mm256_castps_si256(_mm256_add_ps(n, _mm256_set1_ps(BPNN_POW2_MAGIC_F)));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(bits, 23));
+    }
+};
+
+struct OpsI8 {
+    using Acc = __m256i;
+    static constexpr std::size_t W = 16;
+
+    static Acc zero() { return _mm256_setzero_si256(); }
+    static Acc madd(Acc acc, const std::uint8_t* x, const std::int8_t* w) {
+        __m256i xv = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x)));
+        __m256i wv = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w)));
+        return _mm256_add_epi32(acc, _mm256_madd_epi16(xv, wv));
+    }
+    static std::int32_t hsum(Acc acc) {
+        __m128i v = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(v);
+    }
+};
+
+struct OpsBf16 {
+    static constexpr std::size_t W = 16;
+
+    static __m256i roundBits(__m256 x) {
+        __m256i bits = _mm256_castps_si256(x);
+        __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+        __m256i rounded = _mm256_add_epi32(bits, _mm256_add_epi32(lsb, _mm256_set1_epi32(0x7FFF)));
+        __m256i nan = _mm256_castps_si256(_mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+        __m256i quiet = _mm256_or_si256(bits, _mm256_set1_epi32(0x00400000));
+        return _mm256_blendv_epi8(rounded, quiet, nan);
+    }
+    // packus按128位通道交错两个输入，再按64位重排回原顺序
+    static void encode(const float* x, std::uint16_t* y) {
+        __m256i lo = _mm256_srli_epi32(roundBits(_mm256_loadu_ps(x)), 16);
+        __m256i hi = _mm256_srli_epi32(roundBits(_mm256_loadu_ps(x + 8)), 16);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y), packed);
+    }
+    static void decode(const std::uint16_t* x, float* y) {
+        __m256i lo = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x)));
+        __m256i hi = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + 8)));
+        _mm256_storeu_ps(y, _mm256_castsi256_ps(_mm256_slli_epi32(lo, 16)));
+        _mm256_storeu_ps(y + 8, _mm256_castsi256_ps(_mm256_slli_epi32(hi, 16)));
+    }
+    static void round(const float* x, float* y) {
+        __m256i mask = _mm256_set1_epi32(static_cast<int>(0xFFFF0000u));
+        _mm256_storeu_ps(y, _mm256_castsi256_ps(_mm256_and_si256(roundBits(_mm256_loadu_ps(x)), mask)));
+        _mm256_storeu_ps(y + 8, _mm256_castsi256_ps(_mm256_and_si256(roundBits(_mm256_loadu_ps(x + 8)), mask)));
+    }
+};
+
+#include "simd_kernels.inl"
+
+} // namespace avx2
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+// ========== AVX-512实现 ==========
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+// GCC 12的avx512fintrin.h会对内部未初始化的占位参数误报
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+
+namespace avx512 {
+
+struct OpsF64 {
+    using Scalar = double;
+    using Vec = __m512d;
+    using Mask = __mmask8;
+    static constexpr std::size_t W = 8;
+
+    static Vec load(const double* p) { return _mm512_loadu_pd(p); }
+    static void store(double* p, Vec v) { _mm512_storeu_pd(p, v); }
+    static Vec set1(double x) { return _mm512_set1_pd(x); }
+    static Vec zero() { return _mm512_setzero_pd(); }
+    static Vec add(Vec a, Vec b) { return _mm512_add_pd(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm512_sub_pd(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm512_mul_pd(a, b); }
+    static Vec div(Vec a, Vec b) { return _mm512_div_pd(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) { return _mm512_fmadd_pd(a, b, c); }
+    static Vec fnmadd(Vec a, Vec b, Vec c) { return _mm512_fnmadd_pd(a, b, c); }
+    static Vec max(Vec a, Vec b) { return _mm512_max_pd(a, b); }
+    static Vec min(Vec a, Vec b) { return _mm512_min_pd(a, b); }
+    static Vec sqrt(Vec a) { return _mm512_sqrt_pd(a); }
+    static double hsum(Vec a) {
+        alignas(64) double lanes[8];
+        _mm512_store_pd(lanes, a);
+        return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+    }
+    static Mask gt(Vec a, Vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+    static Mask lt(Vec a, Vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+    static Vec select(Mask m, Vec a, Vec b) { return _mm512_mask_blend_pd(m, b, a); }
+    static Vec pow2i(Vec n) {
+        __m512i bits = _mm512_castpd_si512(_mm512_add_pd(n, _mm512_set1_pd(BPNN_POW2_MAGIC)));
+        return _mm512_castsi512_pd(_mm512_slli_epi64(bits, 52));
+    }
+};
+
+struct OpsF32 {
+    using Scalar = float;
+    using Vec = __m512;
+    using Mask = __mmask16;
+    static constexpr std::size_t W = 16;
+
+    static Vec load(const float* p) { return _mm512_loadu_ps(p); }
+    static void store(float* p, Vec v) { _mm512_storeu_ps(p, v); }
+    static Vec set1(float x) { return _mm512_set1_ps(x); }
+    static Vec zero() { return _mm512_setzero_ps(); }
+    static Vec add(Vec a, Vec b) { return _mm512_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm512_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm512_mul_ps(a, b); }
+    static Vec div(Vec a, Vec b) { return _mm512_div_ps(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) { return _mm512_fmadd_ps(a, b, c); }
+    static Vec fnmadd(Vec a, Vec b, Vec c) { return _mm512_fnmadd_ps(a, b, c); }
+    static Vec max(Vec a, Vec b) { return _mm512_max_ps(a, b); }
+    static Vec min(Vec a, Vec b) { return _mm512_min_ps(a, b); }
+    static Vec sqrt(Vec a) { return _mm512_sqrt_ps(a); }
+    static float hsum(Vec a) {
+        alignas(64) float lanes[16];
+        _mm512_store_ps(lanes, a);
+        float quarter[4];
+        for (int i = 0; i < 4; ++i) {
+            quarter[i] = (lanes[i] + lanes[i + 8]) + (lanes[i + 4] + lanes[i + 12]);
+        }
+        return (quarter[0] + quarter[2]) + (quarter[1] + quarter[3]);
+    }
+    static Mask gt(Vec a, Vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    static Mask lt(Vec a, Vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static Vec select(Mask m, Vec a, Vec b) { return _mm512_mask_blend_ps(m, b, a); }
+    static Vec pow2i(Vec n) {
+        __m512i bits = _mm512_castps_si512(_mm512_add_ps(n, _mm512_set1_ps(BPNN_POW2_MAGIC_F)));
+        return _mm512_castsi512_ps(_mm512_slli_epi32(bits, 23));
+    }
+};
+
+// vpmovdw（32位截断为16位）属于AVX-512F
+struct OpsBf16 {
+    static constexpr std::size_t W = 16;
+
+    static __m512i roundBits(__m512 x) {
+        __m512i bits = _mm512_castps_si512(x);
+        __m512i lsb = _mm512_and_si512(_mm512_srli_epi32(bits, 16), _mm512_set1_epi32(1));
+        __m512i rounded = _mm512_add_epi32(bits, _mm512_add_epi32(lsb, _mm512_set1_epi32(0x7FFF)));
+        __mmask16 nan = _mm512_cmp_ps_mask(x, x, _CMP_UNORD_Q);
+        return _mm512_mask_blend_epi32(nan, rounded, _mm512_or_si512(bits, _mm512_set1_epi32(0x00400000)));
+    }
+    static void encode(const float* x, std::uint16_t* y) {
+        __m512i high = _mm512_srli_epi32(roundBits(_mm512_loadu_ps(x)), 16);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y), _mm512_cvtepi32_epi16(high));
+    }
+    static void decode(const std::uint16_t* x, float* y) {
+        __m512i v = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x)));
+        _mm512_storeu_ps(y, _mm512_castsi512_ps(_mm512_slli_epi32(v, 16)));
+    }
+    static void round(const float* x, float* y) {
+        __m512i mask = _mm512_set1_epi32(static_cast<int>(0xFFFF0000u));
+        _mm512_storeu_ps(y, _mm512_castsi512_ps(_mm512_and_si512(roundBits(_mm512_loadu_ps(x)), mask)));
+    }
+};
+
+#include "simd_kernels.inl"
+
+} // namespace avx512
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+#endif
+
+#undef BPNN_POW2_MAGIC
+#undef BPNN_POW2_MAGIC_F
+
+#endif // BPNN_SIMD_X86
+
+// ========== 运行时分派 ==========
+
+namespace {
+
+bool isaSupported(Isa isa, Isa best) {
+    return static_cast<int>(isa) <= static_cast<int>(best);
+}
+
+template<typename T>
+Kernels<T> kernelsFor(Isa isa) {
+    switch (isa) {
+#if BPNN_SIMD_X86
+        case Isa::AVX512: return avx512::makeKernels<T>(Isa::AVX512);
+        case Isa::AVX2: return avx2::makeKernels<T>(Isa::AVX2);
+        case Isa::SSE2: return sse2::makeKernels<T>(Isa::SSE2);
+#endif
+        default: return scalar::makeKernels<T>(Isa::SCALAR);
+    }
+}
+
+Isa isaFromEnvironment(Isa best) {
+    const char* env = std::getenv("BPNN_SIMD");
+    if (!env) return best;
+
+    std::string name(env);
+    Isa requested = best;
+    if (name == "scalar") requested = Isa::SCALAR;
+    else if (name == "sse2") requested = Isa::SSE2;
+    else if (name == "avx2") requested = Isa::AVX2;
+    else if (name == "avx512") requested = Isa::AVX512;
+
+    return isaSupported(requested, best) ? requested : best;
+}
+
+Int8Kernels int8KernelsFor(Isa isa) {
+    switch (isa) {
+#if BPNN_SIMD_X86
+        case Isa::AVX512:
+        case Isa::AVX2: return avx2::Int8KernelSet<avx2::OpsI8>::make(Isa::AVX2);
+        case Isa::SSE2: return sse2::Int8KernelSet<sse2::OpsI8>::make(Isa::SSE2);
+#endif
+        default: return scalar::Int8KernelSet<scalar::OpsI8>::make(Isa::SCALAR);
+    }
+}
+
+Bf16Kernels bf16KernelsFor(Isa isa) {
+    switch (isa) {
+#if BPNN_SIMD_X86
+        case Isa::AVX512: return avx512::Bf16KernelSet<avx512::OpsBf16>::make(Isa::AVX512);
+        case Isa::AVX2: return avx2::Bf16KernelSet<avx2::OpsBf16>::make(Isa::AVX2);
+        case Isa::SSE2: return sse2::Bf16KernelSet<sse2::OpsBf16>::make(Isa::SSE2);
+#endif
+        default: return scalar::Bf16KernelSet<scalar::OpsBf16>::make(Isa::SCALAR);
+    }
+}
+
+template<typename T>
+Kernels<T>& activeKernels() {
+    static Kernels<T> active = kernelsFor<T>(isaFromEnvironment(detectIsa()));
+    return active;
+}
+
+Int8Kernels& activeInt8Kernels() {
+    static Int8Kernels active = int8KernelsFor(isaFromEnvironment(detectIsa()));
+    return active;
+}
+
+Bf16Kernels& activeBf16Kernels() {
+    static Bf16Kernels active = bf16KernelsFor(isaFromEnvironment(detectIsa()));
+    return active;
+}
+
+} // namespace
+
+Isa detectIsa() {
+#if BPNN_SIMD_X86 && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return Isa::AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return Isa::AVX2;
+    if (__builtin_cpu_supports("sse2")) return Isa::SSE2;
+    return Isa::SCALAR;
+#elif BPNN_SIMD_X86 && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+
+    __cpuid(info, 1);
+    bool fma = (info[2] & (1 << 12)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+
+    // 操作系统需要保存YMM/ZMM寄存器状态
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    bool ymm_enabled = (xcr0 & 0x6) == 0x6;
+    bool zmm_enabled = (xcr0 & 0xe6) == 0xe6;
+
+    bool avx2 = false;
+    bool avx512f = false;
+    if (max_leaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+        avx512f = (info[1] & (1 << 16)) != 0;
+    }
+
+    if (avx512f && zmm_enabled) return Isa::AVX512;
+    if (avx2 && fma && ymm_enabled) return Isa::AVX2;
+    return sse2 ? Isa::SSE2 : Isa::SCALAR;
+#else
+    return Isa::SCALAR;
+#endif
+}
+
+template<typename T>
+const Kernels<T>& kernels() {
+    return activeKernels<T>();
+}
+
+template const Kernels<float>& kernels<float>();
+template const Kernels<double>& kernels<double>();
+
+const Int8Kernels& int8Kernels() {
+    return activeInt8Kernels();
+}
+
+const Bf16Kernels& bf16Kernels() {
+    return activeBf16Kernels();
+}
+
+bool setIsa(Isa isa) {
+    if (!isaSupported(isa, detectIsa())) {
+        return false;
+    }
+    activeKernels<float>() = kernelsFor<float>(isa);
+    activeKernels<double>() = kernelsFor<double>(isa);
+    activeInt8Kernels() = int8KernelsFor(isa);
+    activeBf16Kernels() = bf16KernelsFor(isa);
+    return true;
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+        case Isa::SSE2: return "SSE2";
+        case Isa::AVX2: return "AVX2";
+        case Isa::AVX512: return "AVX-512";
+        default: return "Scalar";
+    }
+}
+
+} // namespace simd
@@ -0,0 +1,151 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// ========== SIMD内核运行时分派 ==========
+// 首次调用kernels()时通过CPUID选择当前CPU支持的最宽指令集，
+// 并提供与之对应的一组函数指针；非x86平台退化为标量实现。
+// 可通过环境变量 BPNN_SIMD=scalar|sse2|avx2|avx512 强制指定（用于对比和排查）。
+namespace simd {
+
+enum class Isa {
+    SCALAR,
+    SSE2,
+    AVX2,     // AVX2 + FMA
+    AVX512    // AVX-512F
+};
+
+// GEMM微内核的寄存器分块尺寸（行×列），每行的列数为一条缓存行（double为8，float为16）
+constexpr std::size_t kGemmMR = 4;
+template<typename T>
+constexpr std::size_t kGemmNR = 64 / sizeof(T);
+
+// 一次Adam更新所需的参数，由调用者每步计算一次。偏差修正并入两个常数后，
+// w = weight_scale·w - step_size·m / (sqrt(v)·inv_sqrt_bias_correction2 + epsilon)，
+// 每个元素只需一次开方和一次除法。Adam的weight_scale为1，AdamW为1 - lr·weight_decay
+struct AdamStep {
+    double beta1;
+    double beta2;
+    double epsilon;
+    double step_size;                  // learning_rate / (1 - beta1^t)
+    double inv_sqrt_bias_correction2;  // 1 / sqrt(1 - beta2^t)
+    double weight_scale;
+    double weight_decay;               // 只用于adamMoments计算LAMB的更新量
+};
+
+// 一次带动量的SGD更新：u = momentum·u + g，w -= grad_scale·g + velocity_scale·u。
+// 普通动量grad_scale = 0、velocity_scale = lr；Nesterov动量grad_scale = lr、velocity_scale = lr·momentum
+struct MomentumStep {
+    double momentum;
+    double grad_scale;
+    double velocity_scale;
+};
+
+// 一次RMSProp更新：s = rho·s + (1 - rho)·g²，w -= learning_rate·g / (sqrt(s) + epsilon)
+struct RmsPropStep {
+    double rho;
+    double learning_rate;
+    double epsilon;
+};
+
+// 标量类型为T（float或double）的一组内核；float的向量宽度是double的两倍
+template<typename T>
+struct Kernels {
+    Isa isa;
+
+    // 返回 Σ a[j]·b[j]
+    T (*dot)(const T* a, const T* b, std::size_t n);
+    // out[r] = Σ a[r][j]·x[j]，r = 0..3
+    void (*dot4)(const T* const* a, const T* x, std::size_t n, T* out);
+    // y += alpha·x
+    void (*axpy)(T alpha, const T* x, T* y, std::size_t n);
+    // y += Σ coef[r]·a[r]，r = 0..3
+    void (*axpy4)(const T* const* a, const T* coef, T* y, std::size_t n);
+    // C[R×kGemmNR] += A[R×kc]·B[kc×kGemmNR]，下标为R-1；A(i,k) = A[i*ars + k*acs]
+    void (*gemmMicro[kGemmMR])(std::size_t kc, const T* A, std::size_t ars, std::size_t acs,
+                               const T* B, std::size_t ldb, T* C, std::size_t ldc);
+    // 对n个参数执行一次Adam更新
+    void (*adam)(T* w, T* m, T* v, const T* g, std::size_t n, const AdamStep& step);
+    // LAMB的两遍更新。第一遍只更新矩估计，并累加 sums[0] += Σw²、
+    // sums[1] += Σr²，r = step_size·m / (sqrt(v)·inv_sqrt_bias_correction2 + epsilon) + weight_decay·w；
+    // 第二遍用已更新的矩估计按adam的公式修改w
+    void (*adamMoments)(const T* w, T* m, T* v, const T* g, std::size_t n, const AdamStep& step, double* sums);
+    void (*adamApply)(T* w, const T* m, const T* v, std::size_t n, const AdamStep& step);
+    // 对n个参数执行一次动量/Nesterov更新，u为速度
+    void (*momentum)(T* w, T* u, const T* g, std::size_t n, const MomentumStep& step);
+    // 对n个参数执行一次RMSProp更新，s为平方梯度的滑动平均
+    void (*rmsprop)(T* w, T* s, const T* g, std::size_t n, const RmsPropStep& step);
+
+    // 逐元素激活：y可以与x相同
+    // exp的输入被限制在可表示的范围内（double为[-708, 709]，float为[-87, 88]），
+    // 相对误差double不超过4 ulp（约1e-15），float不超过2 ulp（约2e-7）
+    void (*exp)(const T* x, T* y, std::size_t n);
+    void (*sigmoid)(const T* x, T* y, std::size_t n);
+    void (*relu)(const T* x, T* y, std::size_t n);
+};
+
+// 当前生效的内核表
+template<typename T = double>
+const Kernels<T>& kernels();
+
+// 8位整数内核（量化推理）：无符号8位输入乘有符号8位权重，扩展为16位后相乘、int32累加。
+// 单个乘积的绝对值不超过255·127，n不超过65535时累加不会溢出
+struct Int8Kernels {
+    Isa isa;
+
+    // 返回 Σ x[j]·w[j]
+    std::int32_t (*dot)(const std::uint8_t* x, const std::int8_t* w, std::size_t n);
+    // out[r] = Σ w[r][j]·x[j]，r = 0..3
+    void (*dot4)(const std::int8_t* const* w, const std::uint8_t* x, std::size_t n, std::int32_t* out);
+};
+
+// 当前生效的8位整数内核。AVX-512F没有16位整数乘加（需要AVX512BW），此时使用AVX2的内核
+const Int8Kernels& int8Kernels();
+
+// bfloat16：float的高16位（符号、8位指数、7位尾数），数值范围与float相同。
+// 就近舍入到偶数，NaN保持为NaN
+inline std::uint16_t toBf16(float x) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &x, 4);
+    if ((bits & 0x7FFFFFFFu) > 0x7F800000u) {
+        return static_cast<std::uint16_t>((bits >> 16) | 0x0040u);
+    }
+    bits += 0x7FFFu + ((bits >> 16) & 1u);
+    return static_cast<std::uint16_t>(bits >> 16);
+}
+
+inline float fromBf16(std::uint16_t h) {
+    std::uint32_t bits = static_cast<std::uint32_t>(h) << 16;
+    float x;
+    std::memcpy(&x, &bits, 4);
+    return x;
+}
+
+// bf16转换内核（混合精度训练），舍入规则同toBf16
+struct Bf16Kernels {
+    Isa isa;
+
+    void (*encode)(const float* x, std::uint16_t* y, std::size_t n);
+    void (*decode)(const std::uint16_t* x, float* y, std::size_t n);
+    // y = fromBf16(toBf16(x))：舍入到bf16精度但仍以float存放，y可以与x相同
+    void (*round)(const float* x, float* y, std::size_t n);
+};
+
+// 当前生效的bf16转换内核
+const Bf16Kernels& bf16Kernels();
+
+// 检测CPU支持的最宽指令集
+Isa detectIsa();
+
+// 强制切换到指定指令集（浮点与整数内核同时切换），CPU不支持时返回false且保持不变；
+// 应在训练/推理开始前调用
+bool setIsa(Isa isa);
+
+const char* isaName(Isa isa);
+
+} // namespace simd
+
+#endif // SIMD_H
@@ -0,0 +1,519 @@
+// 通用SIMD内核实现。
+// 本文件由simd.cpp在不同指令集的命名空间中多次包含，
+// KernelSet<Ops>按Ops（当前指令集某一标量类型的向量类型与基本运算）实例化，
+// 每个指令集分别为double与float各实例化一次。
+
+template<typename Ops>
+struct KernelSet {
+    using T = typename Ops::Scalar;
+    using Vec = typename Ops::Vec;
+    static constexpr std::size_t W = Ops::W;
+    static constexpr std::size_t NR = kGemmNR<T>;
+    static_assert(NR % W == 0, "GEMM micro-panel width must be a multiple of the vector width");
+
+    static T dot(const T* a, const T* b, std::size_t n) {
+        Vec acc0 = Ops::zero();
+        Vec acc1 = Ops::zero();
+        std::size_t j = 0;
+        for (; j + 2 * W <= n; j += 2 * W) {
+            acc0 = Ops::fmadd(Ops::load(a + j), Ops::load(b + j), acc0);
+            acc1 = Ops::fmadd(Ops::load(a + j + W), Ops::load(b + j + W), acc1);
+        }
+        for (; j + W <= n; j += W) {
+            acc0 = Ops::fmadd(Ops::load(a + j), Ops::load(b + j), acc0);
+        }
+        T sum = Ops::hsum(Ops::add(acc0, acc1));
+        for (; j < n; ++j) {
+            sum += a[j] * b[j];
+        }
+        return sum;
+    }
+
+    static void dot4(const T* const* a, const T* x, std::size_t n, T* out) {
+        Vec acc0 = Ops::zero();
+        Vec acc1 = Ops::zero();
+        Vec acc2 = Ops::zero();
+        Vec acc3 = Ops::zero();
+        std::size_t j = 0;
+        for (; j + W <= n; j += W) {
+            Vec xv = Ops::load(x + j);
+            acc0 = Ops::fmadd(Ops::load(a[0] + j), xv, acc0);
+            acc1 = Ops::fmadd(Ops::load(a[1] + j), xv, acc1);
+            acc2 = Ops::fmadd(Ops::load(a[2] + j), xv, acc2);
+            acc3 = Ops::fmadd(Ops::load(a[3] + j), xv, acc3);
+        }
+        T s0 = Ops::hsum(acc0);
+        T s1 = Ops::hsum(acc1);
+        T s2 = Ops::hsum(acc2);
+        T s3 = Ops::hsum(acc3);
+        for (; j < n; ++j) {
+            s0 += a[0][j] * x[j];
+            s1 += a[1][j] * x[j];
+            s2 += a[2][j] * x[j];
+            s3 += a[3][j] * x[j];
+        }
+        out[0] = s0;
+        out[1] = s1;
+        out[2] = s2;
+        out[3] = s3;
+    }
+
+    static void axpy(T alpha, const T* x, T* y, std::size_t n) {
+        Vec av = Ops::set1(alpha);
+        std::size_t j = 0;
+        for (; j + W <= n; j += W) {
+            Ops::store(y + j, Ops::fmadd(av, Ops::load(x + j), Ops::load(y + j)));
+        }
+        for (; j < n; ++j) {
+            y[j] += alpha * x[j];
+        }
+    }
+
+    static void axpy4(const T* const* a, const T* coef, T* y, std::size_t n) {
+        Vec c0 = Ops::set1(coef[0]);
+        Vec c1 = Ops::set1(coef[1]);
+        Vec c2 = Ops::set1(coef[2]);
+        Vec c3 = Ops::set1(coef[3]);
+        std::size_t j = 0;
+        for (; j + W <= n; j += W) {
+            Vec yv = Ops::load(y + j);
+            yv = Ops::fmadd(c0, Ops::load(a[0] + j), yv);
+            yv = Ops::fmadd(c1, Ops::load(a[1] + j), yv);
+            yv = Ops::fmadd(c2, Ops::load(a[2] + j), yv);
+            yv = Ops::fmadd(c3, Ops::load(a[3] + j), yv);
+            Ops::store(y + j, yv);
+        }
+        for (; j < n; ++j) {
+            y[j] += coef[0] * a[0][j] + coef[1] * a[1][j] + coef[2] * a[2][j] + coef[3] * a[3][j];
+        }
+    }
+
+    // 累加器必须全部留在寄存器中：R、NV都是编译期常量，强制完全展开，
+    // 否则-O2下GCC会把acc放在栈上，每次迭代都要读写内存
+    template<std::size_t R>
+    static void gemmMicro(std::size_t kc, const T* A, std::size_t ars, std::size_t acs,
+                          const T* B, std::size_t ldb, T* C, std::size_t ldc) {
+        constexpr std::size_t NV = NR / W;
+        Vec acc[R][NV];
+#pragma GCC unroll 8
+        for (std::size_t i = 0; i < R; ++i) {
+#pragma GCC unroll 16
+            for (std::size_t v = 0; v < NV; ++v) {
+                acc[i][v] = Ops::zero();
+            }
+        }
+        for (std::size_t k = 0; k < kc; ++k) {
+            const T* b = B + k * ldb;
+            Vec bv[NV];
+#pragma GCC unroll 16
+            for (std::size_t v = 0; v < NV; ++v) {
+                bv[v] = Ops::load(b + v * W);
+            }
+#pragma GCC unroll 8
+            for (std::size_t i = 0; i < R; ++i) {
+                Vec av = Ops::set1(A[i * ars + k * acs]);
+#pragma GCC unroll 16
+                for (std::size_t v = 0; v < NV; ++v) {
+                    acc[i][v] = Ops::fmadd(av, bv[v], acc[i][v]);
+                }
+            }
+        }
+#pragma GCC unroll 8
+        for (std::size_t i = 0; i < R; ++i) {
+            T* c = C + i * ldc;
+#pragma GCC unroll 16
+            for (std::size_t v = 0; v < NV; ++v) {
+                Ops::store(c + v * W, Ops::add(Ops::load(c + v * W), acc[i][v]));
+            }
+        }
+    }
+
+    // 超参数先转换为T，向量部分与尾部使用相同的值；g、m、v、w每个元素各读写一次
+    static void adam(T* w, T* m, T* v, const T* g, std::size_t n, const AdamStep& step) {
+        const T beta1 = static_cast<T>(step.beta1);
+        const T beta2 = static_cast<T>(step.beta2);
+        const T one_minus_beta1 = static_cast<T>(1 - step.beta1);
+        const T one_minus_beta2 = static_cast<T>(1 - step.beta2);
+        const T step_size = static_cast<T>(step.step_size);
+        const T inv_sqrt_correction2 = static_cast<T>(step.inv_sqrt_bias_correction2);
+        const T epsilon = static_cast<T>(step.epsilon);
+        const T weight_scale = static_cast<T>(step.weight_scale);
+
+        Vec b1 = Ops::set1(beta1);
+        Vec b2 = Ops::set1(beta2);
+        Vec one_minus_b1 = Ops::set1(one_minus_beta1);
+        Vec one_minus_b2 = Ops::set1(one_minus_beta2);
+        Vec alpha = Ops::set1(step_size);
+        Vec inv_sqrt_bc2 = Ops::set1(inv_sqrt_correction2);
+        Vec eps = Ops::set1(epsilon);
+        Vec scale = Ops::set1(weight_scale);
+        std::size_t j = 0;
+        for (; j + W <= n; j += W) {
+            Vec gv = Ops::load(g + j);
+            Vec mv = Ops::fmadd(b1, Ops::load(m + j), Ops::mul(one_minus_b1, gv));
+            Vec vv = Ops::fmadd(b2, Ops::load(v + j), Ops::mul(one_minus_b2, Ops::mul(gv, gv)));
+            Ops::store(m + j, mv);
+            Ops::store(v + j, vv);
+            Vec denom = Ops::fmadd(Ops::sqrt(vv), inv_sqrt_bc2, eps);
+            Vec update = Ops::div(Ops::mul(alpha, mv), denom);
+            Ops::store(w + j, Ops::sub(Ops::mul(scale, Ops::load(w + j)), update));
+        }
+        for (; j < n; ++j) {
+            T mj = beta1 * m[j] + one_minus_beta1 * g[j];
+            T vj = beta2 * v[j] + one_minus_beta2 * g[j] * g[j];
+            m[j] = mj;
+            v[j] = vj;
+            w[j] = weight_scale * w[j] - step_size * mj / (std::sqrt(vj) * inv_sqrt_correction2 + epsilon);
+        }
+    }
+
+    static void adamMoments(const T* w, T* m, T* v, const T* g, std::size_t n, const AdamStep& step,
+                            double* sums) {
+        const T beta1 = static_cast<T>(step.beta1);
+        const T beta2 = static_cast<T>(step.beta2);
+        const T one_minus_beta1 = static_cast<T>(1 - step.beta1);
+        const T one_minus_beta2 = static_cast<T>(1 - step.beta2);
+        const T step_size = static_cast<T>(step.step_size);
+        const T inv_sqrt_correction2 = static_cast<T>(step.inv_sqrt_bias_correction2);
+        const T epsilon = static_cast<T>(step.epsilon);
+        const T weight_decay = static_cast<T>(step.weight_decay);
+
+        Vec b1 = Ops::set1(beta1);
+        Vec b2 = Ops::set1(beta2);
+        Vec one_minus_b1 = Ops::set1(one_minus_beta1);
+        Vec one_minus_b2 = Ops::set1(one_minus_beta2);
+        Vec alpha = Ops::set1(step_size);
+        Vec inv_sqrt_bc2 = Ops::set1(inv_sqrt_correction2);
+        Vec eps = Ops::set1(epsilon);
+        Vec decay = Ops::set1(weight_decay);
+        Vec weight_sq = Ops::zero();
+        Vec update_sq = Ops::zero();
+        std::size_t j = 0;
+        for (; j + W <= n; j += W) {
+            Vec gv = Ops::load(g + j);
+            Vec wv = Ops::load(w + j);
+            Vec mv = Ops::fmadd(b1, Ops::load(m + j), Ops::mul(one_minus_b1, gv));
+            Vec vv = Ops::fmadd(b2, Ops::load(v + j), Ops::mul(one_minus_b2, Ops::mul(gv, gv)));
+            Ops::store(m + j, mv);
+            Ops::store(v + j, vv);
+            Vec denom = Ops::fmadd(Ops::sqrt(vv), inv_sqrt_bc2, eps);
+            Vec r = Ops::fmadd(decay, wv, Ops::div(Ops::mul(alpha, mv), denom));
+            weight_sq = Ops::fmadd(wv, wv, weight_sq);
+            update_sq = Ops::fmadd(r, r, update_sq);
+        }
+        double weight_sum = Ops::hsum(weight_sq);
+        double update_sum = Ops::hsum(update_sq);
+        for (; j < n; ++j) {
+            T mj = beta1 * m[j] + one_minus_beta1 * g[j];
+            T vj = beta2 * v[j] + one_minus_beta2 * g[j] * g[j];
+            m[j] = mj;
+            v[j] = vj;
+            T r = step_size * mj / (std::sqrt(vj) * inv_sqrt_correction2 + epsilon) + weight_decay * w[j];
+            weight_sum += static_cast<double>(w[j]) * w[j];
+            update_sum += static_cast<double>(r) * r;
+        }
+        sums[0] += weight_sum;
+        sums[1] += update_sum;
+    }
+
+    static void adamApply(T* w, const T* m, const T* v, std::size_t n, const AdamStep& step) {
+        const T step_size = static_cast<T>(step.step_size);
+        const T inv_sqrt_correction2 = static_cast<T>(step.inv_sqrt_bias_correction2);
+        const T epsilon = static_cast<T>(step.epsilon);
+        const T weight_scale = static_cast<T>(step.weight_scale);
+
+        Vec alpha = Ops::set1(step_size);
+        Vec inv_sqrt_bc2 = Ops::set1(inv_sqrt_correction2);
+        Vec eps = Ops::set1(epsilon);
+        Vec scale = Ops::set1(weight_scale);
+        std::size_t j = 0;
+        for (; j + W <= n; j += W) {
+            Vec denom = Ops::fmadd(Ops::sqrt(Ops::load(v + j)), inv_sqrt_bc2, eps);
+            Vec update = Ops::div(Ops::mul(alpha, Ops::load(m + j)), denom);
+            Ops::store(w + j, Ops::sub(Ops::mul(scale, Ops::load(w + j)), update));
+        }
+        for (; j < n; ++j) {
+            w[j] = weight_scale * w[j] - step_size * m[j] / (std::sqrt(v[j]) * inv_sqrt_correction2 + epsilon);
+        }
+    }
+
+    static void momentum(T* w, T* u, const T* g, std::size_t n, const MomentumStep& step) {
+        const T mu = static_cast<T>(step.momentum);
+        const T grad_scale = static_cast<T>(step.grad_scale);
+        const T velocity_scale = static_cast<T>(step.velocity_scale);
+
+        Vec muv = Ops::set1(mu);
+        Vec gs = Ops::set1(grad_scale);
+        Vec vs = Ops::set1(velocity_scale);
+        std::size_t j = 0;
+        for (; j + W <= n; j += W) {
+            Vec gv = Ops::load(g + j);
+            Vec uv = Ops::fmadd(muv, Ops::load(u + j), gv);
+            Ops::store(u + j, uv);
+            Vec update = Ops::fmadd(vs, uv, Ops::mul(gs, gv));
+            Ops::store(w + j, Ops::sub(Ops::load(w + j), update));
+        }
+        for (; j < n; ++j) {
+            T uj = mu * u[j] + g[j];
+            u[j] = uj;
+            w[j] -= velocity_scale * uj + grad_scale * g[j];
+        }
+    }
+
+    static void rmsprop(T* w, T* s, const T* g, std::size_t n, const RmsPropStep& step) {
+        const T rho = static_cast<T>(step.rho);
+        const T one_minus_rho = static_cast<T>(1 - step.rho);
+        const T learning_rate = static_cast<T>(step.learning_rate);
+        const T epsilon = static_cast<T>(step.epsilon);
+
+        Vec rv = Ops::set1(rho);
+        Vec one_minus_r = Ops::set1(one_minus_rho);
+        Vec lr = Ops::set1(learning_rate);
+        Vec eps = Ops::set1(epsilon);
+        std::size_t j = 0;
+        for (; j + W <= n; j += W) {
+            Vec gv = Ops::load(g + j);
+            Vec sv = Ops::fmadd(rv, Ops::load(s + j), Ops::mul(one_minus_r, Ops::mul(gv, gv)));
+            Ops::store(s + j, sv);
+            Vec update = Ops::div(Ops::mul(lr, gv), Ops::add(Ops::sqrt(sv), eps));
+            Ops::store(w + j, Ops::sub(Ops::load(w + j), update));
+        }
+        for (; j < n; ++j) {
+            T sj = rho * s[j] + one_minus_rho * g[j] * g[j];
+            s[j] = sj;
+            w[j] -= learning_rate * g[j] / (std::sqrt(sj) + epsilon);
+        }
+    }
+
+    // e^x：x = n·ln2 + r，|r| <= ln2/2，e^r用泰勒多项式近似，再乘以2^n。
+    // double用12阶（截断误差 < 2e-16），float用7阶（截断误差 < 6e-9）
+    static Vec expVec(Vec x) {
+        const Vec log2e = Ops::set1(static_cast<T>(1.4426950408889634));
+        Vec n;
+        Vec r;
+        if constexpr (sizeof(T) == sizeof(double)) {
+            const Vec ln2_hi = Ops::set1(6.93147180369123816490e-01);
+            const Vec ln2_lo = Ops::set1(1.90821492927058770002e-10);
+            const Vec round_magic = Ops::set1(6755399441055744.0);  // 1.5·2^52，加减后即四舍五入取整
+
+            x = Ops::min(Ops::max(x, Ops::set1(-708.0)), Ops::set1(709.0));
+            n = Ops::sub(Ops::fmadd(x, log2e, round_magic), round_magic);
+            r = Ops::fnmadd(n, ln2_hi, x);
+            r = Ops::fnmadd(n, ln2_lo, r);
+        } else {
+            const Vec ln2_hi = Ops::set1(0.693359375f);
+            const Vec ln2_lo = Ops::set1(-2.12194440e-4f);
+            const Vec round_magic = Ops::set1(12582912.0f);  // 1.5·2^23
+
+            // n不超过127，2^n仍是正规数
+            x = Ops::min(Ops::max(x, Ops::set1(-87.0f)), Ops::set1(88.0f));
+            n = Ops::sub(Ops::fmadd(x, log2e, round_magic), round_magic);
+            r = Ops::fnmadd(n, ln2_hi, x);
+            r = Ops::fnmadd(n, ln2_lo, r);
+        }
+
+        Vec p;
+        if constexpr (sizeof(T) == sizeof(double)) {
+            p = Ops::set1(1.0 / 479001600.0);              // 1/12!
+            p = Ops::fmadd(p, r, Ops::set1(1.0 / 39916800.0));  // 1/11!
+            p = Ops::fmadd(p, r, Ops::set1(1.0 / 3628800.0));
+            p = Ops::fmadd(p, r, Ops::set1(1.0 / 362880.0));
+            p = Ops::fmadd(p, r, Ops::set1(1.0 / 40320.0));
+            p = Ops::fmadd(p, r, Ops::set1(1.0 / 5040.0));
+            p = Ops::fmadd(p, r, Ops::set1(1.0 / 720.0));
+            p = Ops::fmadd(p, r, Ops::set1(1.0 / 120.0));
+            p = Ops::fmadd(p, r, Ops::set1(1.0 / 24.0));
+            p = Ops::fmadd(p, r, Ops::set1(1.0 / 6.0));
+            p = Ops::fmadd(p, r, Ops::set1(0.5));
+        } else {
+            p = Ops::set1(1.0f / 5040.0f);                     // 1/7!
+            p = Ops::fmadd(p, r, Ops::set1(1.0f / 720.0f));
+            p = Ops::fmadd(p, r, Ops::set1(1.0f / 120.0f));
+            p = Ops::fmadd(p, r, Ops::set1(1.0f / 24.0f));
+            p = Ops::fmadd(p, r, Ops::set1(1.0f / 6.0f));
+            p = Ops::fmadd(p, r, Ops::set1(0.5f));
+        }
+        p = Ops::fmadd(p, r, Ops::set1(T(1)));
+        p = Ops::fmadd(p, r, Ops::set1(T(1)));
+
+        return Ops::mul(p, Ops::pow2i(n));
+    }
+
+    static void expArray(const T* x, T* y, std::size_t n) {
+        std::size_t j = 0;
+        for (; j + W <= n; j += W) {
+            Ops::store(y + j, expVec(Ops::load(x + j)));
+        }
+        if (j < n) {
+            // 尾部补齐成一个完整向量处理，保证所有元素使用同一近似
+            T in[W] = {};
+            T out[W];
+            for (std::size_t k = 0; j + k < n; ++k) in[k] = x[j + k];
+            Ops::store(out, expVec(Ops::load(in)));
+            for (std::size_t k = 0; j + k < n; ++k) y[j + k] = out[k];
+        }
+    }
+
+    static Vec sigmoidVec(Vec x) {
+        const Vec one = Ops::set1(T(1));
+        Vec y = Ops::div(one, Ops::add(one, expVec(Ops::sub(Ops::zero(), x))));
+        // 与标量实现一致的饱和处理
+        y = Ops::select(Ops::gt(x, Ops::set1(T(500))), one, y);
+        y = Ops::select(Ops::lt(x, Ops::set1(T(-500))), Ops::zero(), y);
+        return y;
+    }
+
+    static void sigmoidArray(const T* x, T* y, std::size_t n) {
+        std::size_t j = 0;
+        for (; j + W <= n; j += W) {
+            Ops::store(y + j, sigmoidVec(Ops::load(x + j)));
+        }
+        if (j < n) {
+            T in[W] = {};
+            T out[W];
+            for (std::size_t k = 0; j + k < n; ++k) in[k] = x[j + k];
+            Ops::store(out, sigmoidVec(Ops::load(in)));
+            for (std::size_t k = 0; j + k < n; ++k) y[j + k] = out[k];
+        }
+    }
+
+    static void reluArray(const T* x, T* y, std::size_t n) {
+        Vec zero = Ops::zero();
+        std::size_t j = 0;
+        for (; j + W <= n; j += W) {
+            Ops::store(y + j, Ops::max(Ops::load(x + j), zero));
+        }
+        for (; j < n; ++j) {
+            y[j] = std::max(T(0), x[j]);
+        }
+    }
+
+    static Kernels<T> make(Isa isa) {
+        Kernels<T> k;
+        k.isa = isa;
+        k.dot = dot;
+        k.dot4 = dot4;
+        k.axpy = axpy;
+        k.axpy4 = axpy4;
+        k.gemmMicro[0] = gemmMicro<1>;
+        k.gemmMicro[1] = gemmMicro<2>;
+        k.gemmMicro[2] = gemmMicro<3>;
+        k.gemmMicro[3] = gemmMicro<4>;
+        k.adam = adam;
+        k.adamMoments = adamMoments;
+        k.adamApply = adamApply;
+        k.momentum = momentum;
+        k.rmsprop = rmsprop;
+        k.exp = expArray;
+        k.sigmoid = sigmoidArray;
+        k.relu = reluArray;
+        return k;
+    }
+};
+
+// 按标量类型选择本指令集的Ops
+template<typename T>
+Kernels<T> makeKernels(Isa isa) {
+    using Ops = typename std::conditional<std::is_same<T, float>::value, OpsF32, OpsF64>::type;
+    return KernelSet<Ops>::make(isa);
+}
+
+// ========== 8位整数内核 ==========
+// IntOps每步处理W个元素，把x[j]·w[j]累加到int32的累加器中
+template<typename IntOps>
+struct Int8KernelSet {
+    using Acc = typename IntOps::Acc;
+    static constexpr std::size_t W = IntOps::W;
+
+    static std::int32_t dot(const std::uint8_t* x, const std::int8_t* w, std::size_t n) {
+        Acc acc = IntOps::zero();
+        std::size_t j = 0;
+        for (; j + W <= n; j += W) {
+            acc = IntOps::madd(acc, x + j, w + j);
+        }
+        std::int32_t sum = IntOps::hsum(acc);
+        for (; j < n; ++j) {
+            sum += static_cast<std::int32_t>(x[j]) * w[j];
+        }
+        return sum;
+    }
+
+    // 4行共用一次x的加载
+    static void dot4(const std::int8_t* const* w, const std::uint8_t* x, std::size_t n, std::int32_t* out) {
+        Acc acc0 = IntOps::zero();
+        Acc acc1 = IntOps::zero();
+        Acc acc2 = IntOps::zero();
+        Acc acc3 = IntOps::zero();
+        std::size_t j = 0;
+        for (; j + W <= n; j += W) {
+            acc0 = IntOps::madd(acc0, x + j, w[0] + j);
+            acc1 = IntOps::madd(acc1, x + j, w[1] + j);
+            acc2 = IntOps::madd(acc2, x + j, w[2] + j);
+            acc3 = IntOps::madd(acc3, x + j, w[3] + j);
+        }
+        out[0] = IntOps::hsum(acc0);
+        out[1] = IntOps::hsum(acc1);
+        out[2] = IntOps::hsum(acc2);
+        out[3] = IntOps::hsum(acc3);
+        for (; j < n; ++j) {
+            std::int32_t xj = x[j];
+            for (int r = 0; r < 4; ++r) {
+                out[r] += xj * w[r][j];
+            }
+        }
+    }
+
+    static Int8Kernels make(Isa isa) {
+        Int8Kernels k;
+        k.isa = isa;
+        k.dot = dot;
+        k.dot4 = dot4;
+        return k;
+    }
+};
+
+// ========== bf16转换内核 ==========
+// BOps每步转换W个元素，不足W的尾部逐个转换
+template<typename BOps>
+struct Bf16KernelSet {
+    static constexpr std::size_t W = BOps::W;
+
+    static void encode(const float* x, std::uint16_t* y, std::size_t n) {
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            BOps::encode(x + i, y + i);
+        }
+        for (; i < n; ++i) {
+            y[i] = toBf16(x[i]);
+        }
+    }
+
+    static void decode(const std::uint16_t* x, float* y, std::size_t n) {
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            BOps::decode(x + i, y + i);
+        }
+        for (; i < n; ++i) {
+            y[i] = fromBf16(x[i]);
+        }
+    }
+
+    static void round(const float* x, float* y, std::size_t n) {
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            BOps::round(x + i, y + i);
+        }
+        for (; i < n; ++i) {
+            y[i] = fromBf16(toBf16(x[i]));
+        }
+    }
+
+    static Bf16Kernels make(Isa isa) {
+        Bf16Kernels k;
+        k.isa = isa;
+        k.encode = encode;
+        k.decode = decode;
+        k.round = round;
+        return k;
+    }
+};
@@ -0,0 +1,103 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = hardwareThreads();
+    }
+
+    // 调用线程也参与计算，只需额外创建 num_threads - 1 个工作线程
+    workers.reserve(num_threads - 1);
+    for (size_t i = 1; i < num_threads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::hardwareThreads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+void ThreadPool::dispatch(size_t count, TaskInvoker invoker, void* task) {
+    if (count == 0) return;
+
+    // 单任务或没有工作线程时直接在当前线程执行
+    if (count == 1 || workers.empty()) {
+        for (size_t i = 0; i < count; ++i) {
+            invoker(task, i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit_lock(submit_mutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current_invoker = invoker;
+        current_task = task;
+        task_count = count;
+        next_index.store(0, std::memory_order_relaxed);
+        busy_workers = workers.size();
+        first_error = nullptr;
+        ++generation;
+    }
+    work_cv.notify_all();
+
+    runTasks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this] { return busy_workers == 0; });
+    current_invoker = nullptr;
+    current_task = nullptr;
+
+    if (first_error) {
+        std::exception_ptr error = first_error;
+        first_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::workerLoop() {
+    uint64_t seen_generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_cv.wait(lock, [&] { return stopping || generation != seen_generation; });
+            if (stopping) return;
+            seen_generation = generation;
+        }
+
+        runTasks();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy_workers == 0) {
+            done_cv.notify_one();
+        }
+    }
+}
+
+void ThreadPool::runTasks() {
+    // 动态领取任务下标，负载不均时快的线程多做
+    for (;;) {
+        size_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+        if (index >= task_count) break;
+
+        try {
+            current_invoker(current_task, index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!first_error) {
+                first_error = std::current_exception();
+            }
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// ========== 线程池 ==========
+// 固定数量的工作线程，按"任务下标"并行执行一组任务并等待全部完成。
+// 调用线程也参与执行，因此 size() 个线程共同分担任务。
+// 任务下标与线程之间没有固定对应关系，需要确定性结果时应按下标（而非线程）划分数据。
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex submit_mutex;  // 串行化来自不同线程的parallelFor调用
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+
+    // 当前一轮任务：类型擦除后的调用入口与任务对象，不需要堆分配
+    using TaskInvoker = void (*)(void* task, size_t index);
+    TaskInvoker current_invoker = nullptr;
+    void* current_task = nullptr;
+    size_t task_count = 0;
+    std::atomic<size_t> next_index{0};
+    size_t busy_workers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+    std::exception_ptr first_error;
+
+    void workerLoop();
+    void runTasks();
+    void dispatch(size_t count, TaskInvoker invoker, void* task);
+    
+    template<typename Task>
+    static void invokeTask(void* task, size_t index) {
+        (*static_cast<Task*>(task))(index);
+    }
+
+public:
+    // num_threads为参与计算的线程总数（含调用线程），0表示使用硬件线程数
+    explicit ThreadPool(size_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    // 执行 task(0) .. task(count-1) 并等待全部完成；任务抛出的第一个异常在此重新抛出。
+    // 多个线程同时调用时依次执行；不可在任务内部再次调用同一线程池的parallelFor
+    template<typename Task>
+    void parallelFor(size_t count, Task&& task) {
+        using TaskType = typename std::remove_reference<Task>::type;
+        dispatch(count, &invokeTask<TaskType>, const_cast<void*>(static_cast<const void*>(&task)));
+    }
+
+    static size_t hardwareThreads();
+};
+
+#endif // THREAD_POOL_H